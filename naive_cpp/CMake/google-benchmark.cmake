@@ -0,0 +1,22 @@
+include_guard (GLOBAL)
+
+# CMake chunk to find or fetch google benchmark.
+
+if (PARSELAND_BUILD_BENCHMARKS)
+	# Prefer an installed copy, since benchmark builds are slow-ish and it's commonly packaged.
+	find_package (benchmark QUIET)
+
+	if (NOT benchmark_FOUND)
+		include (FetchContent)
+		cmake_policy (SET CMP0135 NEW)
+
+		FetchContent_Declare(
+			googlebenchmark
+			URL https://github.com/google/benchmark/archive/refs/tags/v1.8.3.zip
+		)
+		set (BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+		set (BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "" FORCE)
+		set (BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "" FORCE)
+		FetchContent_MakeAvailable (googlebenchmark)
+	endif ()
+endif ()
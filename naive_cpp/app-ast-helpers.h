@@ -10,23 +10,20 @@
 namespace kfs
 {
 
-// returns an Error explaining an unexpected end of input.
-PResult unexpected_eoi(std::string_view);
-
-// return an error explaining the expectation of an identifier was not met.
-PResult expected_identifier(std::string_view what, std::string_view after, std::string_view actual);
+// returns an Error for an unexpected end of input; 'where' is the most relevant token, if any.
+PResult unexpected_eoi(const Token& where = Token{});
 
 // return an error indicating we got unexpected input (or end of input).
-PResult not_expected(const TokenSequence& ts, std::string_view after, std::string_view expected);
+PResult not_expected(const TokenSequence& ts, ErrorCode expected);
 
-// extract and return the front token from a stream if it is a word (identifier) or else return an 'expected identifier' error.
-Result<Token> take_identifier(TokenSequence& ts, std::string_view what, std::string_view after);
+// extract and return the front token from a stream if it is a word (identifier) or else return an error with the 'expected' code.
+Result<Token> take_identifier(TokenSequence& ts, ErrorCode expected);
 
 // common implementation of list-processing.
-PResult process_list(std::string_view label, TokenSequence& ts, Token open_brace, const std::function<PResult(TokenSequence&, Token)>& thunk);
+PResult process_list(TokenSequence& ts, Token open_brace, const std::function<PResult(TokenSequence&, Token)>& thunk);
 
 // extract and return the front token if it is an open brace.
-Result<Token> take_open_brace(TokenSequence& ts, std::string_view after);
+Result<Token> take_open_brace(TokenSequence& ts);
 
 }
 
@@ -2,9 +2,9 @@
 #include "app-ast.h"
 #include "app-ast-helpers.h"
 #include "app-definitions.h"
+#include "app-parse-probe.h"
 #include "app-tokensequence.h"
 
-#include <fmt/core.h>
 #include <functional>
 
 /*
@@ -30,26 +30,31 @@ Result<std::string_view> AST::next(TokenSequence& ts)
     // (using '^' to denote 'we are here'
 
     // The first token should be a Word naming the type.
+    const size_t begin = ts.index();
     const auto& [token, ok] = ts.take_front();
     if (!ok)
         return Result<std::string_view>::None();
+    ts.base_ = ts.tokens_->offset(begin);
     if (token.type_ != Token::Type::Word)
-        return Result<std::string_view>::Err(fmt::format("unexpected '{}' at top-level, expecting keywords 'enum' or 'type'", token.source_));
+        return Result<std::string_view>::Err(ErrorCode::ExpectedDefinition, token);
 
     // Call the definition factory which will determine if it was one of the expected values, and if so
     // process the remainder of the definition.
     PResult result = Definition::make(ts, token);
     if (result.is_error())
-        return Result<std::string_view>::Err(result.take_error());
+        return Result<std::string_view>::Err(result);
 
     // Validate: this key hasn't already been used.
     Definition* defn = result.value()->as<Definition*>();
-    const auto name = defn->name_.source_;
-    if (definitions_.contains(name))
-        return Result<std::string_view>::Err(fmt::format("'{}' redefinition", name));
+    const auto name = symbols_.name(defn->name_id_);
+    if (find_definition(defn->name_id_) != nullptr)
+        return Result<std::string_view>::Err(ErrorCode::Redefinition, ts.token(defn->name_));
     // Not already present, take ownership and register the name.
     nodes_.emplace_back(result.take_value());
-    definitions_[name] = defn;
+    extents_.push_back(TokenExtent{ begin, ts.index() });
+    if (defn->name_id_ >= definitions_.size())
+        definitions_.resize(symbols_.size(), nullptr);
+    definitions_[defn->name_id_] = defn;
 
     // Let the caller know the name of the type defined.
     return Result<std::string_view>::Some(name);
@@ -59,26 +64,26 @@ Result<std::string_view> AST::next(TokenSequence& ts)
 // EnumDefinition thunk for `process_list` to invoke for each possible member of
 // an enumeration list.
 //
-PResult parse_enum_member(EnumDefinition& enum_def, TokenSequence&, Token name)
+PResult parse_enum_member(EnumDefinition& enum_def, TokenSequence& ts, Token name)
 {
     // enum_definition := <word> ','?
 
     // Validate: check for a word
     if (name.type_ != Token::Type::Word)
-        return expected_identifier("member name (identifier), or '}'", "enum member list",
-                                   name.source_);
+        return PResult::Err(ErrorCode::ExpectedEnumMember, name);
 
     // Check this isn't a duplicate of an existing type/enum.
-    if (enum_def.lookup(name.source_).has_value())
-        return PResult::Err(fmt::format("duplicate enum member, '{}'", name.source_));
+    const SymbolId name_id = ts.intern(name);
+    if (enum_def.lookup(name_id).has_value())
+        return PResult::Err(ErrorCode::DuplicateMember, name);
 
     // Make sure there's at least one non-'_' in the name.
     if (name.source_.find_first_not_of('_') == std::string_view::npos)
-        return PResult::Err(fmt::format("invalid enum member name, '{}'", name.source_));
+        return PResult::Err(ErrorCode::InvalidMemberName, name);
 
     // Assign the value of the current 0-based size.
-    enum_def.lookup_[name.source_] = enum_def.members_.size();
-    enum_def.members_.push_back(name);
+    enum_def.lookup_[name_id] = enum_def.members_.size();
+    enum_def.members_.push_back(ts.node_token(name));
 
     // process_list doesn't care about values, so just give it None.
     return PResult::None();
@@ -93,31 +98,31 @@ PResult parse_enum_member(EnumDefinition& enum_def, TokenSequence&, Token name)
 //
 PResult EnumDefinition::make(TokenSequence& ts, Token first)
 {
-    auto enum_name = take_identifier(ts, "enum name", "'enum keyword'");
+    auto enum_name = take_identifier(ts, ErrorCode::ExpectedEnumName);
     if (!enum_name.is_value())
-        return PResult::Err(enum_name.take_error());
+        return PResult::Err(enum_name);
 
     // We have a name.
-    auto ptr = std::make_unique<EnumDefinition>(first, enum_name.value());
+    auto ptr = std::make_unique<EnumDefinition>(ts.node_token(first), ts.node_token(enum_name.value()), ts.intern(enum_name.value()));
     /// todo: log?
 
-    auto open_brace = take_open_brace(ts, "type name");
+    auto open_brace = take_open_brace(ts);
     if (open_brace.is_error())
-        return PResult::Err(open_brace.take_error());
+        return PResult::Err(open_brace);
 
-    auto result = process_list(
-            fmt::format("member list", enum_name.value().source_), ts, open_brace.value(),
+    auto result = KFS_PARSE_PROBE(ProcessList, ts, process_list(
+            ts, open_brace.value(),
             [&ptr] (TokenSequence& ts, Token name) -> PResult {
                 return parse_enum_member(*ptr, ts, name);
             }
-    );
+    ));
+
+    if (result.is_error())
+        return result;
 
     // An enum must have at least one member.
     if (ptr->members_.empty())
-        return PResult::Err("enum '{}' has no members: enums must have *at least* one member");
-
-    if (result.is_error())
-        return PResult::Err(fmt::format("enum '{}': {}", enum_name.value().source_, result.error()));
+        return PResult::Err(ErrorCode::EmptyEnum, enum_name.value());
 
     return PResult::Some(std::move(ptr));
 }
@@ -129,20 +134,19 @@ PResult parse_type_member(TypeDefinition& type_def, TokenSequence& ts, Token mem
 {
     // type_member <- field_definition
     // field_definition <- type_name ^ member_name arity? default?
-    auto field_def = FieldDefinition::make(ts, member_type_name);
+    auto field_def = KFS_PARSE_PROBE(FieldDefinition, ts, FieldDefinition::make(ts, member_type_name));
     if (!field_def.is_value())
         return field_def;
 
     FieldDefinition& field = *field_def.value()->as<FieldDefinition*>();
     // Check this isn't a duplicate of an existing type/enum.
-    if (type_def.lookup(field.name_.source_))
-        return PResult::Err(fmt::format("duplicate enum member, '{}'", field.name_.source_));
+    if (type_def.lookup(field.name_id_))
+        return PResult::Err(ErrorCode::DuplicateMember, ts.token(field.name_));
 
     // Transfer ownership of the allocated field, stored as a generic ASTNode,
     // into the ownership table of the type definition, as a FieldDefinition proper.
-    type_def.lookup_.emplace(field.name_.source_, dynamic_cast<FieldDefinition*>(field_def.take_value().release()));
+    type_def.lookup_.emplace(field.name_id_, dynamic_cast<FieldDefinition*>(field_def.take_value().release()));
     type_def.members_.push_back(&field);
-    fmt::print("- adding member {} {}\n", field.type_name().source_, field.name_.source_);
 
     // we've handled ownership so just return not-an-error
     return PResult::None();
@@ -158,11 +162,11 @@ Result<bool> check_array_specifier(TokenSequence& ts)
     if (!open_present)
         return Result<bool>::Some(false);
     if (ts.is_empty())
-        return Result<bool>::Err(unexpected_eoi("open-bracket ('[')").take_error());
+        return Result<bool>::Err(ErrorCode::UnexpectedEndOfInput, open_token);
     const auto& [close_token, close_present] = ts.take_front(Token::Type::RBracket);
-    ///TODO: I'd like a nice error if they did `[4]` saying "they're dynamic" or something
+    // Arrays are dynamic, so anything other than ']' here is trying to give them a size.
     if (!close_present)
-        return Result<bool>::Err(fmt::format("expecting close bracket (']') after open bracket ('['). arrays are dynamic and cannot have a fized size."));
+        return Result<bool>::Err(ErrorCode::FixedSizeArray, ts.front());
     return Result<bool>::Some(true);
 }
 
@@ -174,22 +178,24 @@ PResult FieldDefinition::make(TokenSequence& ts, Token member_type_name)
     // type_definition := <member-type-name> ^ <member-name> <arity>? <default-value>? ','?
     // Validate: check for a word
     if (member_type_name.type_ != Token::Type::Word)
-        return expected_identifier("field type name, or '}'", "type definition",
-                                   member_type_name.source_);
+        return PResult::Err(ErrorCode::ExpectedFieldType, member_type_name);
+    const string_view doc_comment = ts.doc_comment(ts.index() - 1);
 
-    auto member_name = take_identifier(ts, "member name", "field type name");
+    auto member_name = take_identifier(ts, ErrorCode::ExpectedMemberName);
     if (member_name.is_error())
-        return PResult::Err(member_name.take_error());
+        return PResult::Err(member_name);
 
     // Make sure there's at least one non-'_' in the name.
     if (member_name.value().source_.find_first_not_of('_') == std::string_view::npos)
-        return PResult::Err(fmt::format("invalid enum member name, '{}'", member_name.value().source_));
+        return PResult::Err(ErrorCode::InvalidMemberName, member_name.value());
 
-    auto ptr = std::make_unique<FieldDefinition>(member_type_name, member_name.value());
+    auto ptr = std::make_unique<FieldDefinition>(ts.node_token(member_type_name), ts.node_token(member_name.value()), ts.intern(member_name.value()));
+    ptr->type_id_ = ts.intern(member_type_name);
+    ptr->doc_comment_ = doc_comment;
 
     Result<bool> is_array = check_array_specifier(ts);
     if (is_array.is_error())
-        return PResult::Err(is_array.take_error());
+        return PResult::Err(is_array);
 
     if (is_array.has_value())
         ptr->is_array_ = is_array.value();
@@ -201,11 +207,11 @@ PResult FieldDefinition::make(TokenSequence& ts, Token member_type_name)
         auto front = ts.take_front();
         PResult value {};
         if (front.second)
-            value = Value::make(ts, front.first);
+            value = KFS_PARSE_PROBE(Value, ts, Value::make(ts, front.first));
         if (value.is_none())
-            return unexpected_eoi("default value after '='");
+            return unexpected_eoi(equals.first);
         if (value.is_error())
-            return PResult::Err(value.take_error());
+            return value;
         ptr->default_ = value.take_value();
     }
 
@@ -222,13 +228,13 @@ Result<Token> parse_type_parent(TokenSequence& ts, Token type_name)
     if (!colon.second)
         return Result<Token>::None();
 
-    auto parent_name = take_identifier(ts, "parent type name", Token::type_to_str(colon.first.type_));
+    auto parent_name = take_identifier(ts, ErrorCode::ExpectedParentName);
     if (!parent_name.is_value())
-        return Result<Token>::Err(parent_name.take_error());
+        return Result<Token>::Err(parent_name);
 
     // Validate: parent can't be same as self.
-    if (parent_name.value().source_ == type_name.source_)
-        return Result<Token>::Err(fmt::format("type {} cannot have itself as a parent", type_name.source_));
+    if (ts.intern(parent_name.value()) == ts.intern(type_name))
+        return Result<Token>::Err(ErrorCode::SelfParent, parent_name.value());
 
     return Result<Token>::Some(parent_name.value());
 }
@@ -241,43 +247,47 @@ PResult TypeDefinition::make(TokenSequence& ts, Token first)
     //  type :- 'type' ^ name:WORD [ ':' parent:WORD ] type-member-list;
     //  type-member-list :- '{' (type-member ','*)* '}';
     //
-    auto type_name = take_identifier(ts, "type name", "'type' keyword");
+    auto type_name = take_identifier(ts, ErrorCode::ExpectedTypeName);
     if (!type_name.is_value())
-        return PResult::Err(type_name.take_error());
+        return PResult::Err(type_name);
 
     if (ts.is_empty())
-        return unexpected_eoi("type name, expected ':' or '{'");
+        return unexpected_eoi(type_name.value());
 
     // If there's a colon here, attempt to capture a parent type-name.
     std::optional<Token> parent;
     if (ts.peek_ahead(Token::Type::Colon))
     {
         if (auto result = parse_type_parent(ts, type_name.value()); result.is_error())
-            return PResult::Err(result.take_error());
+            return PResult::Err(result);
         else
             parent = result.value();
     }
     else if (!ts.peek_ahead(Token::Type::LBrace))
-        return not_expected(ts, fmt::format("type name ({})", type_name.value().source_), "':' or '{'");
+        return not_expected(ts, ErrorCode::ExpectedColonOrBrace);
 
     // Create a type instance to begin populating.
-    auto ptr = std::make_unique<TypeDefinition>(first, type_name.value());
-    ptr->parent_type_ = parent;
+    auto ptr = std::make_unique<TypeDefinition>(ts.node_token(first), ts.node_token(type_name.value()), ts.intern(type_name.value()));
+    if (parent)
+    {
+        ptr->parent_type_ = ts.node_token(*parent);
+        ptr->parent_id_ = ts.intern(*parent);
+    }
 
     // Now we want the body, which should begin with a brace.
-    auto open_brace = take_open_brace(ts, "type name");
+    auto open_brace = take_open_brace(ts);
     if (open_brace.is_error())
-        return PResult::Err(open_brace.take_error());
+        return PResult::Err(open_brace);
 
     // Loop over parse_type_member while looking for the close '}'
-    auto result = process_list(
-            fmt::format("member list", type_name.value().source_), ts, open_brace.value(),
+    auto result = KFS_PARSE_PROBE(ProcessList, ts, process_list(
+            ts, open_brace.value(),
             [&ptr] (TokenSequence& ts, Token name) -> PResult {
                 return parse_type_member(*ptr, ts, name);
             }
-    );
+    ));
     if (result.is_error())
-        return PResult::Err(fmt::format("type '{}': {}", type_name.value().source_, result.error()));
+        return result;
 
     return PResult::Some(std::move(ptr));
 }
@@ -288,19 +298,34 @@ PResult TypeDefinition::make(TokenSequence& ts, Token first)
 //
 PResult Definition::make(TokenSequence &ts, Token first)
 {
+    // 'first' was just taken, so its doc comment is keyed to the previous index.
+    const string_view doc_comment = ts.doc_comment(ts.index() - 1);
+
     // expect 'enum' or 'type' to determine which type we're defining.
-    if (const auto& [type_, source_] = first; type_ == Token::Type::Word)
+    if (first.type_ == Token::Type::Word)
     {
-        if (source_ == "enum")
-            return EnumDefinition::make(ts, first);
-        else if (source_ == "type")
-            return TypeDefinition::make(ts, first);
+        PResult result {};
+        switch (first.keyword())
+        {
+        case Keyword::Enum:
+            result = KFS_PARSE_PROBE(EnumDefinition, ts, EnumDefinition::make(ts, first));
+            break;
+        case Keyword::Type:
+            result = KFS_PARSE_PROBE(TypeDefinition, ts, TypeDefinition::make(ts, first));
+            break;
+        default:
+            break;
+        }
+        if (result.is_value())
+            result.value()->as<Definition*>()->doc_comment_ = doc_comment;
+        if (!result.is_none())
+            return result;
     }
 
     if (first.type_ == Token::Type::RBrace)
-        return PResult::Err("unmatched close-brace at top-level, did you add too many }s?");
+        return PResult::Err(ErrorCode::UnmatchedCloseBrace, first);
 
-    return PResult::Err(fmt::format("expected either 'enum', or 'type'; got '{}'", first.source_));
+    return PResult::Err(ErrorCode::ExpectedDefinition, first);
 }
 
 
@@ -310,14 +335,12 @@ PResult Value::make(TokenSequence& ts, Token first)
 {
     // value <- '{' ^ <compound> / ^<scalar>^
     if (first.type_ == Token::Type::LBrace)
-        return CompoundValue::make(ts, first);
+        return KFS_PARSE_PROBE(CompoundValue, ts, CompoundValue::make(ts, first));
 
     if (auto result = ScalarValue::make(ts, first); !result.is_error())
         return result;
 
-    return PResult::Err(
-        fmt::format("syntax-error: expected a string, number, boolean, enum::label, array, or object; got {} '{}'"sv,
-                    Token::type_to_str(first.type_), first.source_));
+    return PResult::Err(ErrorCode::ExpectedValue, first);
 }
 
 
@@ -330,39 +353,39 @@ PResult ScalarValue::make(TokenSequence& ts, Token first)
     switch (first.type_)
     {
     case Token::Type::Word:
-        if (first.source_ == "true"sv || first.source_ == "false"sv)
-            return PResult::Some(std::make_unique<ScalarValue>(first, Type::Bool));
+        if (first.keyword() == Keyword::True || first.keyword() == Keyword::False)
+            return PResult::Some(std::make_unique<ScalarValue>(ts.node_token(first), Type::Bool));
 
         // scoped_enum <- word scope_operator:'::' word;
         if (!ts.is_empty() && ts.peek_ahead(Token::Type::Scope))
         {
-            auto result = EnumValue::make(ts, first);
+            auto result = KFS_PARSE_PROBE(EnumValue, ts, EnumValue::make(ts, first));
             if (!result.is_error())
                 return result;
         }
         break;
 
     case Token::Type::Float:
-        return PResult::Some(std::make_unique<ScalarValue>(first, Type::Float));
+        return PResult::Some(std::make_unique<ScalarValue>(ts.node_token(first), Type::Float));
 
     case Token::Type::Integer:
-        return PResult::Some(std::make_unique<ScalarValue>(first, Type::Int));
+        return PResult::Some(std::make_unique<ScalarValue>(ts.node_token(first), Type::Int));
 
     case Token::Type::String:
-        return PResult::Some(std::make_unique<ScalarValue>(first, Type::String));
+        return PResult::Some(std::make_unique<ScalarValue>(ts.node_token(first), Type::String));
 
     default:
         break;
     }
 
-    return PResult::Err("expected a scalar value");
+    return PResult::Err(ErrorCode::ExpectedScalar, first);
 }
 
 
 //! CompoundValue helper that tries to resolve/ensure consistency of a
 //! compound value.
 //
-Result<CompoundValue::Type> resolve_compound_type(CompoundValue& compound)
+Result<CompoundValue::Type> resolve_compound_type(const TokenSequence& ts, CompoundValue& compound)
 {
     // If it contains no elements, then we can't actually distinguish between
     // it being an array vs an object, so we call it Unit, which is a sort of
@@ -380,7 +403,7 @@ Result<CompoundValue::Type> resolve_compound_type(CompoundValue& compound)
         // you can have {1,2} and {3.0,.4} but not {0.5, 1}
         if (value->node_type() != first_type)
         {
-            return Result<CompoundValue::Type>::Err(fmt::format("invalid compound mixes types ({} and {})", first_type, value->node_type()));
+            return Result<CompoundValue::Type>::Err(ErrorCode::MixedCompound, ts.token(value->root_));
         }
     }
 
@@ -393,7 +416,7 @@ Result<CompoundValue::Type> resolve_compound_type(CompoundValue& compound)
     if (const auto first = sample->as<CompoundValue*>(); first != nullptr)
         return Result<CompoundValue::Type>::Some(CompoundValue::Type::Array);
 
-    return Result<CompoundValue::Type>::Err(fmt::format("expected object or array of objects, got an array of {}", first_type));
+    return Result<CompoundValue::Type>::Err(ErrorCode::ExpectedObjectArray, ts.token(sample->root_));
 }
 
 
@@ -404,11 +427,11 @@ PResult CompoundValue::make(TokenSequence& ts, Token first)
 {
     // compound <- '{' ^ ( <string> ':' <value> ',' )* '}';
     if (first.type_ != Token::Type::LBrace)
-        return PResult::Err("expected a compound value");
+        return PResult::Err(ErrorCode::ExpectedCompound, first);
 
     // If the next non-whitespace token after { is the }, then we have an empty
     // entry which we cannot distinguish between an array vs an object at this point.
-    auto ptr = std::make_unique<CompoundValue>(first);
+    auto ptr = std::make_unique<CompoundValue>(ts.node_token(first));
     if (auto result = ts.take_front(Token::Type::RBrace); result.second)
     {
         ptr->resolved_type_ = Type::Unit;
@@ -416,8 +439,8 @@ PResult CompoundValue::make(TokenSequence& ts, Token first)
     }
 
     // Collect all the values without trying to assess whether they are valid or not.
-    auto result = process_list(
-            "compound value", ts, first,
+    auto result = KFS_PARSE_PROBE(ProcessList, ts, process_list(
+            ts, first,
             [&ptr] (TokenSequence& ts, Token first) -> PResult {
                 // Compound can be one of three things: unit, array, or object. unit is the
                 // empty case ({}), array is a list of Values, object is a list of
@@ -433,7 +456,7 @@ PResult CompoundValue::make(TokenSequence& ts, Token first)
                 if (first.type_ == Token::Type::Word && ts.peek_ahead(Token::Type::Equals))
                     result = FieldValue::make(ts, first);
                 else
-                    result = Value::make(ts, first);
+                    result = KFS_PARSE_PROBE(Value, ts, Value::make(ts, first));
                 if (result.is_error())
                     return result;
 
@@ -443,14 +466,14 @@ PResult CompoundValue::make(TokenSequence& ts, Token first)
                 // Tell process_list there was no error.
                 return PResult::None();
             }
-    );
+    ));
 
     if (result.is_error())
-        return PResult::Err(fmt::format("compound value: {}", result.error()));
+        return result;
 
-    auto resolve = resolve_compound_type(*ptr);
+    auto resolve = resolve_compound_type(ts, *ptr);
     if (resolve.is_error())
-        return PResult::Err(resolve.take_error());
+        return PResult::Err(resolve);
 
     ptr->resolved_type_ = resolve.value();
 
@@ -463,13 +486,15 @@ PResult CompoundValue::make(TokenSequence& ts, Token first)
 PResult EnumValue::make(TokenSequence& ts, Token first)
 {
     if (const auto& [scope_op, present] = ts.take_front(Token::Type::Scope); !present)
-        return not_expected(ts, "enum class name", "scope operator ('::')");
-    auto member = take_identifier(ts, "enum member name", "scope operator ('::')");
+        return not_expected(ts, ErrorCode::ExpectedScope);
+    auto member = take_identifier(ts, ErrorCode::ExpectedEnumValueName);
     if (!member.is_value())
-        return PResult::Err(member.take_error());
+        return PResult::Err(member);
     
-    auto ptr = std::make_unique<EnumValue>(first);
-    ptr->field_ = member.take_value();
+    auto ptr = std::make_unique<EnumValue>(ts.node_token(first));
+    ptr->field_ = ts.node_token(member.value());
+    ptr->type_id_ = ts.intern(first);
+    ptr->field_id_ = ts.intern(member.value());
 
     return PResult::Some(std::move(ptr));
 }         
@@ -479,15 +504,15 @@ PResult FieldValue::make(TokenSequence& ts, Token first)
 {
     // field_value <- field_name:word ^ '=' value;
     if (auto result = ts.take_front(Token::Type::Equals); !result.second)
-        return not_expected(ts, "field name", "equals ('=')");
+        return not_expected(ts, ErrorCode::ExpectedFieldEquals);
 
-    auto ptr = std::make_unique<FieldValue>(first);
+    auto ptr = std::make_unique<FieldValue>(ts.node_token(first));
 
     auto value_first = ts.take_front();
     if (!value_first.second)
-        return unexpected_eoi(fmt::format("field assignment ('{} =')", first.source_));
+        return unexpected_eoi(first);
 
-    auto new_value = Value::make(ts, value_first.first);
+    auto new_value = KFS_PARSE_PROBE(Value, ts, Value::make(ts, value_first.first));
     if (new_value.is_error())
         return new_value;
 
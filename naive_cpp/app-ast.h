@@ -7,9 +7,12 @@
 #include "app-fwd.h"
 
 #include "result.h"
+#include "retokenize.h"
+#include "symbol-table.h"
 #include "token.h"
+#include "token-buffer.h"
 
-#include <map>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string_view>
@@ -21,11 +24,37 @@ namespace kfs
 
 using namespace std::string_view_literals;
 
+//! A token held by an AST node. Rather than a view of the text, it records where the
+//! token is relative to the first token of the top-level definition it belongs to,
+//! which no edit outside that definition can change, so kept definitions need no
+//! updating when the document is edited. NodeText turns it back into a Token.
+struct NodeToken
+{
+    uint32_t    offset_ {0};                        // From the definition's first token.
+    uint32_t    length_ {0};
+    Token::Type type_   {Token::Type::Invalid};
+    uint8_t     flags_  {Token::NoFlags};
+};
+
+//! The text of one top-level definition, for turning its NodeTokens back into Tokens.
+struct NodeText
+{
+    std::string_view source_ {};    // The document, from the definition's first token on.
+
+    [[nodiscard]]
+    Token token(const NodeToken& token) const noexcept
+    {
+        return Token{ token.type_, source_.substr(token.offset_, token.length_), token.flags_ };
+    }
+    [[nodiscard]]
+    std::string_view operator () (const NodeToken& token) const noexcept { return source_.substr(token.offset_, token.length_); }
+};
+
 struct ASTNode
 {
     using OwningPtr = std::unique_ptr<ASTNode>;
 
-    Token					root_;		// The token that invoked us.
+    NodeToken				root_;		// The token that invoked us.
     std::optional<ASTNode*>	parent_;	// Optional reference to our parent.
 
     // Default construction.
@@ -34,7 +63,7 @@ struct ASTNode
     virtual ~ASTNode() = default;
 
     // Construct with a single, explicit, token as the root token for the node.
-    explicit constexpr ASTNode(const kfs::Token& root) : root_(root) {}
+    explicit constexpr ASTNode(const NodeToken& root) : root_(root) {}
 
     // Default copy/move operators.
     constexpr ASTNode(const ASTNode&) = default;
@@ -67,13 +96,59 @@ using PResult = Result<ASTNode::OwningPtr>;
 // Type alias for a non-contiguous list of ast nodes.
 using ASTOwnedNodes = std::vector<ASTNode::OwningPtr>;
 
+// The range of tokens, [begin_, end_), that a top-level definition was parsed from.
+struct TokenExtent
+{
+    size_t begin_ {0};
+    size_t end_   {0};
+};
+
+// What AST::reparse did. 'error_' is where the parse stopped, as AST::next would
+// have reported it; it is None if the parse reached the end of the document.
+struct ReparseResult
+{
+    size_t reused_   {0};   // Definitions kept from before the edit.
+    size_t reparsed_ {0};   // Definitions parsed from the changed tokens.
+    size_t dropped_  {0};   // Definitions from before the edit that were discarded.
+    Result<std::string_view> error_ {};
+};
+
 struct AST
 {
     ASTOwnedNodes nodes_;
 
-    std::map<std::string_view /*name*/, Definition*> definitions_;
+    // The tokens each of nodes_ was parsed from; they follow on from one another.
+    std::vector<TokenExtent> extents_;
+
+    // Every name the parse has seen; the token sequence being parsed must intern
+    // into this table.
+    SymbolTable symbols_;
+
+    // Top-level definitions, indexed by the SymbolId of their name.
+    std::vector<Definition*> definitions_;
 
     Result<std::string_view /*name*/> next(TokenSequence& ts);
+
+    //! Brings the AST up to date after an edit to the document it was parsed from. 'ts'
+    //! is over the tokens as retokenize left them, which 'changed' describes. Only the
+    //! definitions the changed tokens touch are parsed again; the rest are kept as they
+    //! are, since their nodes hold positions within themselves rather than views of
+    //! the text, and the symbol table holds its own copy of every name.
+    ReparseResult reparse(TokenSequence& ts, const RetokenizeResult& changed);
+
+    //! The text of the top-level definition nodes_[index], which was parsed from 'tokens'.
+    [[nodiscard]]
+    NodeText text(const TokenBuffer& tokens, size_t index) const noexcept
+    {
+        return NodeText{ tokens.source().substr(tokens.offset(extents_[index].begin_)) };
+    }
+
+    //! Returns the definition with the given name, or nullptr.
+    [[nodiscard]]
+    Definition* find_definition(SymbolId name) const noexcept
+    {
+        return name < definitions_.size() ? definitions_[name] : nullptr;
+    }
 };
 
 }
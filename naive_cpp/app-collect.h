@@ -0,0 +1,74 @@
+#pragma once
+#ifndef INCLUDED_NAIVE_CPP_APP_COLLECT_H
+#define INCLUDED_NAIVE_CPP_APP_COLLECT_H
+
+//! Scanning a whole document into a TokenBuffer, shared by the app and benchmarks.
+
+#include "error.h"
+#include "line-index.h"
+#include "token-buffer.h"
+
+#include <fmt/core.h>
+
+#include <string_view>
+#include <vector>
+
+
+namespace kfs
+{
+
+    // An error, by where it is in the text.
+    struct ScanDiagnostic
+    {
+        size_t    offset_ {0};
+        size_t    length_ {0};
+        ErrorCode code_   {ErrorCode::None};
+    };
+
+    //! Scans the rest of the scanner's document into a TokenBuffer, printing a
+    //! diagnostic for each error and carrying on after it; with 'verbose', prints
+    //! every token as well. The errors are also added to 'errors', if given.
+    template<typename ScannerType>
+    TokenBuffer collect_tokens(ScannerType& scanner, std::string_view filename, bool verbose,
+                               std::vector<ScanDiagnostic>* errors = nullptr)
+    {
+        // Tokens are scanned in batches directly into the buffer.
+        constexpr size_t batch_size = 4096;
+
+        TokenBuffer scanned_tokens{ scanner.source() };
+        for ( ; /*ever*/ ; )
+        {
+            const size_t start = scanned_tokens.size();
+            const auto batch = scanner.next_batch(scanned_tokens, batch_size);
+
+            if (verbose)
+            {
+                for (size_t i = start; i < scanned_tokens.size(); ++i)
+                    fmt::print("token: offset:{} type:{:d} text:|{}|\n", scanned_tokens.offset(i), int(scanned_tokens.type(i)), scanned_tokens.text(i));
+            }
+
+            if (batch.is_error())
+            {
+                const auto& token = batch.error_.token();
+                const size_t offset = scanner.get_token_offset(token).value_or(0);
+                fmt::print("{}", render_diagnostic(scanner.line_index(), filename, offset, token.source_.length(), batch.error_.error()));
+                if (errors != nullptr)
+                    errors->push_back(ScanDiagnostic{ offset, token.source_.length(), batch.error_.code() });
+                continue;
+            }
+
+            if (batch.count_ < batch_size)
+            {
+                if (verbose)
+                    fmt::print("end of input\n");
+                break;
+            }
+        }
+
+        return scanned_tokens;
+    }
+
+}
+
+
+#endif  //INCLUDED_NAIVE_CPP_APP_COLLECT_H
@@ -4,8 +4,12 @@
 
 #include "app-fwd.h"
 #include "app-ast.h"
+#include "arena.h"
+#include "string-literal.h"
 
 #include <list>
+#include <string>
+#include <unordered_map>
 
 namespace kfs
 {
@@ -15,10 +19,13 @@ namespace kfs
         // Factory.
         static PResult make(TokenSequence& ts, Token first);
 
-        Token  name_ {};
+        NodeToken name_ {};
+        SymbolId  name_id_ {no_symbol};
+        // The comment before the definition, if comments were retained.
+        std::string doc_comment_ {};
 
-        // Constructor with the first two tokens - 'enum' and the name,
-        explicit Definition(Token first, Token name) : ASTNode(first), name_(name) {}
+        // Constructor with the first two tokens - 'enum' and the name - and the name's id.
+        explicit Definition(const NodeToken& first, const NodeToken& name, SymbolId name_id) : ASTNode(first), name_(name), name_id_(name_id) {}
         // Dtor needs to be virtual.
         ~Definition() override = default;
     };
@@ -29,8 +36,8 @@ namespace kfs
         // Factory.
         static PResult make(TokenSequence& ts, Token first);
 
-        using Lookup  = std::map<std::string_view, size_t>;
-        using Members = std::vector<Token>;
+        using Lookup  = std::unordered_map<SymbolId, size_t>;
+        using Members = std::vector<NodeToken>;
 
         Members     members_ {};
         Lookup      lookup_ {};
@@ -44,7 +51,7 @@ namespace kfs
         std::string_view node_type() const override { return "enum"sv; }
 
         //! Returns the value that the enumerator would resolve to if the name exists, otherwise nullopt.
-        std::optional<size_t> lookup(std::string_view key)
+        std::optional<size_t> lookup(SymbolId key) const
         {
             if (auto it = lookup_.find(key); it != lookup_.end())
                 return it->second;
@@ -69,7 +76,7 @@ namespace kfs
     {
         enum class Type { Bool, Float, Int, String, EnumField };
 
-        explicit ScalarValue(Token first, Type type) : Value(first), type_(type) {}
+        explicit ScalarValue(const NodeToken& first, Type type) : Value(first), type_(type) {}
 
         // Factory.
         static PResult make(TokenSequence& ts, Token first);
@@ -78,6 +85,11 @@ namespace kfs
         ~ScalarValue() override = default;
         Type  type_ {};
 
+        //! The value of a string: its text, from 'text', without the quotes, unescaped
+        //! into 'arena' if it had escapes. Only valid for Type::String.
+        [[nodiscard]]
+        std::string_view string_value(const NodeText& text, Arena& arena) const { return kfs::string_value(text.token(root_), arena); }
+
         [[nodiscard]]
         std::string_view node_type() const override { return "scalar value"sv; }
     };
@@ -90,15 +102,17 @@ namespace kfs
         using Value::Value;
         ~EnumValue() override = default;
 
-        Token field_;
+        NodeToken field_;
+        SymbolId  type_id_  {no_symbol};
+        SymbolId  field_id_ {no_symbol};
 
         [[nodiscard]]
         std::string_view node_type() const override { return "scoped enum"sv; }
 
         [[nodiscard]]
-        const Token& enum_type() const noexcept { return root_; }
+        const NodeToken& enum_type() const noexcept { return root_; }
         [[nodiscard]]
-        const Token& enum_name() const noexcept { return field_; }
+        const NodeToken& enum_name() const noexcept { return field_; }
     };
 
 
@@ -121,7 +135,7 @@ namespace kfs
         std::string_view node_type() const override { return "object member value"sv; }
 
         [[nodiscard]]
-        const Token& field_name() const noexcept { return root_; }
+        const NodeToken& field_name() const noexcept { return root_; }
         [[nodiscard]]
         const Value* field_value() const noexcept { return value_->as<Value*>(); }
     };
@@ -137,7 +151,7 @@ namespace kfs
 
         // std::list stops us being a constexpr in c++17
         using Value::Value;
-        explicit CompoundValue(const kfs::Token& root) : Value(root) {}
+        explicit CompoundValue(const NodeToken& root) : Value(root) {}
 
         enum class Type
         {
@@ -156,7 +170,7 @@ namespace kfs
 
         // First will be the opening brace of the token, so we need to also know
         // the list.
-        Token last_;
+        NodeToken last_;
         // And then all the values in-between.
         std::list<Value::OwningPtr> values_;
 
@@ -173,12 +187,13 @@ namespace kfs
 
         bool            is_array_  {false};
         ValuePtr        default_   {};
+        SymbolId        type_id_   {no_symbol};
 
         using Definition::Definition;
         ~FieldDefinition() override = default;
 
         [[nodiscard]]
-        const Token&    type_name() const { return root_; }
+        const NodeToken& type_name() const { return root_; }
 
         [[nodiscard]]
         std::string_view node_type() const override { return "field-definition"sv; }
@@ -193,14 +208,15 @@ namespace kfs
 
         // The parent might not be declared at the point we read a child, so
         // we don't presume to try and store a pointer to the object itself.
-        using Parent = std::optional<Token>;
+        using Parent = std::optional<NodeToken>;
         // Ownership and lookup-by-name
         using OwnedField = std::unique_ptr<FieldDefinition>;
-        using Lookup  = std::map<std::string_view, OwnedField>;
+        using Lookup  = std::unordered_map<SymbolId, OwnedField>;
         // Field order.
         using Members = std::vector<FieldDefinition*>;
 
         Parent      parent_type_ {};
+        SymbolId    parent_id_ {no_symbol};
         Members     members_ {};
         Lookup      lookup_ {};
 
@@ -214,7 +230,7 @@ namespace kfs
         std::string_view node_type() const override { return "type"sv; };
 
         //! Returns TypeMember with the give name if registered, otherwise nullptr.
-        FieldDefinition* lookup(std::string_view key)
+        FieldDefinition* lookup(SymbolId key) const
         {
             if (auto it = lookup_.find(key); it != lookup_.end())
                 return it->second.get();
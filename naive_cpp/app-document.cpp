@@ -0,0 +1,111 @@
+// A document kept up to date in memory as its text changes.
+
+#include "app-document.h"
+#include "app-tokensequence.h"
+#include "scanner.h"
+
+
+namespace kfs
+{
+
+
+namespace
+{
+
+    // Where a scanning error is; errors without a span are put at 'fallback'.
+    ScanDiagnostic diagnose(std::string_view source, const TResult& error, size_t fallback)
+    {
+        const std::string_view span = error.token().source_;
+        const auto at = size_t(span.data() - source.data());
+        if (span.data() == nullptr || span.data() < source.data() || at > source.size())
+            return ScanDiagnostic{ fallback, 0, error.code() };
+        return ScanDiagnostic{ at, span.size(), error.code() };
+    }
+
+}
+
+
+//! Scan and parse the first version of the text from scratch.
+//
+DocumentUpdate Document::load(std::string text)
+{
+    constexpr size_t batch_size = 4096;
+
+    text_ = std::move(text);
+    const std::string_view source = text_;
+    Scanner scanner(source);
+    scanner.decode_numbers(decode_numbers_);
+    tokens_ = TokenBuffer(source);
+    scan_errors_.clear();
+    for (;;)
+    {
+        const auto batch = scanner.next_batch(tokens_, batch_size);
+        if (batch.is_error())
+        {
+            scan_errors_.push_back(diagnose(source, batch.error_, 0));
+            continue;
+        }
+        if (batch.count_ < batch_size)
+            break;
+    }
+
+    DocumentUpdate update{ true, source.size(), {} };
+    ast_ = AST();
+    TokenSequence ts{ tokens_, ast_.symbols_ };
+    for (parse_error_ = ast_.next(ts); parse_error_.is_value(); parse_error_ = ast_.next(ts))
+        ++update.parse_.reparsed_;
+    update.parse_.error_ = parse_error_;
+    stopped_at_ = ts.index();
+    parsed_ = true;
+    return update;
+}
+
+
+//! Bring the document up to date with a new version of its text.
+//
+// The two versions are compared to find the one edit, from the first difference to
+// the last, that covers every change, and only the tokens and definitions that edit
+// touches are scanned and parsed again.
+//
+DocumentUpdate Document::update(std::string text)
+{
+    if (!parsed_)
+        return load(std::move(text));
+
+    const TextEdit edit = find_edit(text_, text);
+    if (edit.removed_ == 0 && edit.inserted_ == 0)
+        return DocumentUpdate{};
+
+    text_ = std::move(text);
+    const std::string_view after = text_;
+    const RetokenizeResult changed = retokenize(tokens_, after, edit, decode_numbers_);
+
+    // Scanning errors before the rescanned text stand, those in it were found again, and
+    // those after it have moved along.
+    const size_t resync = changed.start_ + changed.rescanned_;
+    std::vector<ScanDiagnostic> errors;
+    errors.reserve(scan_errors_.size() + changed.errors_.size());
+    for (const ScanDiagnostic& error : scan_errors_)
+    {
+        if (error.offset_ < changed.start_)
+            errors.push_back(error);
+    }
+    for (const TResult& error : changed.errors_)
+        errors.push_back(diagnose(after, error, changed.start_));
+    for (const ScanDiagnostic& error : scan_errors_)
+    {
+        const auto moved = ptrdiff_t(error.offset_) + edit.shift();
+        if (error.offset_ >= changed.start_ && resync < after.size() && moved >= ptrdiff_t(resync))
+            errors.push_back(ScanDiagnostic{ size_t(moved), error.length_, error.code_ });
+    }
+    scan_errors_ = std::move(errors);
+
+    TokenSequence ts{ tokens_, ast_.symbols_ };
+    DocumentUpdate update{ true, changed.rescanned_, ast_.reparse(ts, changed) };
+    parse_error_ = update.parse_.error_;
+    stopped_at_ = ts.index();
+    return update;
+}
+
+
+}
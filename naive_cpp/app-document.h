@@ -0,0 +1,71 @@
+#pragma once
+#ifndef INCLUDED_NAIVE_CPP_APP_DOCUMENT_H
+#define INCLUDED_NAIVE_CPP_APP_DOCUMENT_H
+
+//! A document that is kept scanned and parsed in memory and brought up to date as its
+//! text changes, for the app's watch mode.
+//!
+//! Each new version of the text is compared with the last to find the region that
+//! changed, and only that is rescanned (retokenize) and reparsed (AST::reparse). The
+//! document holds the text itself; once the new version is scanned, the previous one
+//! isn't needed, since the AST holds positions rather than views of the text.
+
+#include "app-ast.h"
+#include "app-collect.h"
+#include "error.h"
+#include "retokenize.h"
+#include "token-buffer.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace kfs
+{
+
+    // What bringing the document up to date took.
+    struct DocumentUpdate
+    {
+        bool          changed_   {false};   // Whether the text was any different.
+        size_t        rescanned_ {0};       // Bytes scanned.
+        ReparseResult parse_     {};        // Definitions reused and parsed.
+    };
+
+    struct Document
+    {
+        std::string text_    {};
+        bool        parsed_  {false};       // Whether there is a previous version to build on.
+        bool        decode_numbers_ {false};
+
+        TokenBuffer tokens_ {};
+        AST         ast_;
+
+        // Scanning errors, in order, and where the parse stopped: at the error, if there
+        // was one, or the end of the tokens.
+        std::vector<ScanDiagnostic> scan_errors_ {};
+        Result<std::string_view>    parse_error_ {};
+        size_t                      stopped_at_ {0};
+
+        explicit Document(bool decode_numbers = false) : decode_numbers_(decode_numbers) {}
+
+        // The tokens view the text, so the document can't be copied or moved.
+        Document(const Document&) = delete;
+        Document& operator = (const Document&) = delete;
+
+        //! The current version of the text.
+        [[nodiscard]]
+        std::string_view text() const noexcept { return text_; }
+
+        //! Replaces the text, rescanning and reparsing as little of it as the changes
+        //! allow; the first update scans and parses everything.
+        DocumentUpdate update(std::string text);
+
+    protected:
+        DocumentUpdate load(std::string text);
+    };
+
+}
+
+
+#endif  //INCLUDED_NAIVE_CPP_APP_DOCUMENT_H
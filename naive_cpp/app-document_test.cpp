@@ -0,0 +1,166 @@
+// Unit tests for documents kept up to date in memory: whatever changes between versions,
+// the document must end up as if its latest text had been loaded afresh.
+
+#include "app-definitions.h"
+#include "app-document.h"
+#include "corpus.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+using namespace kfs;
+
+
+namespace
+{
+
+// Checks 'document' has the same diagnostics and definitions as one loaded with its text.
+void expect_fresh(const Document& document)
+{
+	Document fresh(document.decode_numbers_);
+	fresh.update(std::string(document.text()));
+
+	ASSERT_TRUE(fresh.tokens_ == document.tokens_);
+	ASSERT_EQ(fresh.scan_errors_.size(), document.scan_errors_.size());
+	for (size_t i = 0; i < fresh.scan_errors_.size(); ++i)
+	{
+		EXPECT_EQ(fresh.scan_errors_[i].offset_, document.scan_errors_[i].offset_) << "error " << i;
+		EXPECT_EQ(fresh.scan_errors_[i].length_, document.scan_errors_[i].length_) << "error " << i;
+		EXPECT_EQ(fresh.scan_errors_[i].code_, document.scan_errors_[i].code_) << "error " << i;
+	}
+
+	ASSERT_EQ(fresh.ast_.nodes_.size(), document.ast_.nodes_.size());
+	for (size_t i = 0; i < fresh.ast_.nodes_.size(); ++i)
+	{
+		const auto expected = fresh.ast_.nodes_[i]->as<const Definition*>();
+		const auto actual = document.ast_.nodes_[i]->as<const Definition*>();
+		const Token expected_name = fresh.ast_.text(fresh.tokens_, i).token(expected->name_);
+		const Token actual_name = document.ast_.text(document.tokens_, i).token(actual->name_);
+		ASSERT_EQ(expected_name.source_, actual_name.source_);
+		ASSERT_EQ(expected_name.source_.data() - fresh.text().data(), actual_name.source_.data() - document.text().data());
+	}
+
+	ASSERT_EQ(fresh.parse_error_.code(), document.parse_error_.code());
+	ASSERT_EQ(fresh.stopped_at_, document.stopped_at_);
+}
+
+}
+
+
+TEST(DocumentTest, LoadAndUpdate)
+{
+	Document document;
+	auto update = document.update("enum E { A, B }\ntype T { E e = E::A }\n");
+	EXPECT_TRUE(update.changed_);
+	EXPECT_EQ(2, update.parse_.reparsed_);
+	EXPECT_TRUE(document.parse_error_.is_none());
+	EXPECT_TRUE(document.scan_errors_.empty());
+
+	// Nothing changed.
+	update = document.update("enum E { A, B }\ntype T { E e = E::A }\n");
+	EXPECT_FALSE(update.changed_);
+
+	update = document.update("enum E { A, B }\ntype T { E e = E::B }\n");
+	EXPECT_TRUE(update.changed_);
+	EXPECT_EQ(1, update.parse_.reused_);
+	EXPECT_EQ(1, update.parse_.reparsed_);
+	EXPECT_LT(update.rescanned_, 10);
+	expect_fresh(document);
+}
+
+
+TEST(DocumentTest, ScanErrorsFollowTheText)
+{
+	Document document;
+	document.update("enum E { A, @ B }\ntype T { int x = 1 ~ }\n");
+	ASSERT_EQ(2, document.scan_errors_.size());
+	EXPECT_EQ(12, document.scan_errors_[0].offset_);
+
+	// Fix the first, which moves the second.
+	document.update("enum E { A, B }\ntype T { int x = 1 ~ }\n");
+	ASSERT_EQ(1, document.scan_errors_.size());
+	EXPECT_EQ(ErrorCode::UnexpectedCharacter, document.scan_errors_[0].code_);
+	EXPECT_EQ('~', document.text()[document.scan_errors_[0].offset_]);
+	expect_fresh(document);
+
+	// Add one in between.
+	document.update("enum E { A, B }\n$\ntype T { int x = 1 ~ }\n");
+	ASSERT_EQ(2, document.scan_errors_.size());
+	EXPECT_EQ('$', document.text()[document.scan_errors_[0].offset_]);
+	expect_fresh(document);
+}
+
+
+TEST(DocumentTest, ParseErrorIsReported)
+{
+	Document document;
+	document.update("enum E { A }\ntype T { int x = }\n");
+	EXPECT_TRUE(document.parse_error_.is_error());
+	EXPECT_EQ(1, document.ast_.nodes_.size());
+
+	document.update("enum E { A }\ntype T { int x = 1 }\n");
+	EXPECT_TRUE(document.parse_error_.is_none());
+	EXPECT_EQ(2, document.ast_.nodes_.size());
+	expect_fresh(document);
+}
+
+
+TEST(DocumentTest, TinyDocuments)
+{
+	// Short enough for the string to keep it inline; the document mustn't be fooled.
+	Document document;
+	document.update("enum E { A }");
+	document.update("enum E { B }");
+	document.update("enum F { B }");
+	expect_fresh(document);
+	document.update("");
+	expect_fresh(document);
+	document.update("enum E { A }");
+	expect_fresh(document);
+}
+
+
+// Random versions of a document, each made by changing a few places in the last.
+TEST(DocumentTest, RandomVersionsMatchFreshLoad)
+{
+	static const char* fragments[] = {
+		"", " ", "x", "42", "4.2", "\"s\"", "{", "}", "=", ",", "::", "@", "~", "\"", "/*", "*/", "//", "\n",
+		"type Q { int q }\n", "enum F { A, B }\n",
+	};
+
+	CorpusOptions options;
+	options.target_size_ = 16 * 1024;
+	options.broken_rate_ = 0.05;
+	std::string text = generate_corpus(options);
+	Document document(true);
+	document.update(text);
+
+	std::mt19937 rng(5);
+	for (int i = 0; i < 200; ++i)
+	{
+		const std::string original = text;
+		for (unsigned edits = 1 + rng() % 3; edits > 0; --edits)
+		{
+			const size_t offset = rng() % (text.size() + 1);
+			const size_t removed = rng() % 3 == 0 ? rng() % 16 : 0;
+			apply_edit(text, offset, removed, fragments[rng() % std::size(fragments)]);
+		}
+		document.update(text);
+		expect_fresh(document);
+		if (testing::Test::HasFatalFailure())
+		{
+			ADD_FAILURE() << "version #" << i;
+			return;
+		}
+
+		// Usually go back, so the document isn't left broken.
+		if (rng() % 4 != 0)
+		{
+			text = original;
+			document.update(text);
+			expect_fresh(document);
+		}
+	}
+}
@@ -3,6 +3,8 @@
  * Copyright (C) Oliver 'kfsone' Smith <oliver@kfs.org> 2024, under MIT license.
  *
  * Implementation of a parser based on the naive cpp scanner.
+ *
+ * Usage: scanner-naive_cpp-app [options] [file ...] -- see app-options.cpp.
  * 
  * We're not going to be fancy, or efficient: just toss all the tokens into a vector and
  * then worry about them after that.
@@ -11,17 +13,35 @@
  */
 
 
+#include "arena.h"
+#include "line-index.h"
+#include "mapped-source.h"
+#include "perf-counters.h"
 #include "result.h"
 #include "scanner.h"
+#include "scanner-indexed.h"
+#include "scanner-parallel.h"
+#include "scanner-table.h"
 #include "token.h"
+#include "token-buffer.h"
+#include "trivia.h"
 
 #include "app-fwd.h"
 #include "app-ast.h"
 #include "app-definitions.h"
+#include "app-parse-probe.h"
+#include "app-collect.h"
+#include "app-options.h"
+#include "app-parse-cache.h"
 #include "app-tokensequence.h"
+#include "app-watch.h"
 
+#include <chrono>
+#include <cstring>
 #include <functional>
 #include <map>
+#include <optional>
+#include <thread>
 #include <vector>
 
 // Enable fmt::...
@@ -32,19 +52,41 @@ using namespace std::string_literals;
 using namespace std::string_view_literals;
 
 // Forward declarations so I can write this in reading order.
-std::vector<kfs::Token> collect_tokens(kfs::Scanner& scanner, bool verbose);
+std::optional<kfs::TokenBuffer> compare_engines(std::string_view source, std::string_view filename);
+int process_document(std::string_view filename, std::string_view source, const kfs::AppOptions& options, bool verbose,
+                     const kfs::ParseCache* cache = nullptr);
+int report_cached(std::string_view filename, std::string_view source, const kfs::CachedParse& parse);
+int report_scaling(std::string_view filename, std::string_view source);
+void report_perf(std::string_view filename, const kfs::PerfRecorder& perf);
+void report_productions(std::string_view filename);
+void describe_ast(const kfs::AST& ast, const kfs::TokenBuffer& tokens);
+
+
+// Document to parse when no files are given.
+constexpr std::string_view sample_source = R"(
+// test comment
+enum EnumName { A, B C }  enum Bravo { X Y }
+/* test comment */
+enum ConnectionState { DISCONNECTED, CONNECTED, ERROR }
+type Connected { ConnectionState state = ConnectionState :: DISCONNECTED}
+type Connection : Connected { string name, Users users[] = { { x=1, y=1} } }
+)";
 
 
-void describe_value(const kfs::Value& value)
+void describe_value(const kfs::Value& value, const kfs::NodeText& text, kfs::Arena& arena)
 {
     if (auto scalar = dynamic_cast<const kfs::ScalarValue*>(&value); scalar != nullptr)
     {
-        fmt::print("[scalar]type {}: '{}'[/scalar]", int(scalar->type_), scalar->root_.source_);
+        // Strings are shown by value, which only costs anything if they had escapes.
+        if (scalar->type_ == kfs::ScalarValue::Type::String)
+            fmt::print("[scalar]type {}: \"{}\"[/scalar]", int(scalar->type_), scalar->string_value(text, arena));
+        else
+            fmt::print("[scalar]type {}: '{}'[/scalar]", int(scalar->type_), text(scalar->root_));
         return;
     }
     else if (auto enumval = dynamic_cast<const kfs::EnumValue*>(&value); enumval != nullptr)
     {
-        fmt::print("[enum]{}::{}[/enum])", enumval->enum_type().source_, enumval->enum_name().source_);
+        fmt::print("[enum]{}::{}[/enum])", text(enumval->enum_type()), text(enumval->enum_name()));
     }
     else if (auto compound = dynamic_cast<const kfs::CompoundValue*>(&value); compound != nullptr)
     {
@@ -75,58 +117,253 @@ void describe_value(const kfs::Value& value)
     }
 }
 
-int main()
+int main(int argc, const char* argv[])
 {
-	///TODO: Read a file, maybe memmap it.
-	kfs::Scanner scanner(R"(
-// test comment
-enum EnumName { A, B C }  enum Bravo { X Y }
-/* test comment */
-enum ConnectionState { DISCONNECTED, CONNECTED, ERROR }
-type Connected { ConnectionState state = ConnectionState :: DISCONNECTED}
-type Connection : Connected { string name, Users users[] = { { x=1, y=1} } }
-)");
+    const auto options = kfs::parse_options(argc, argv);
+    if (!options.has_value())
+        return 1;
+
+    if (options->files_.empty())
+        return process_document("<input>", sample_source, *options, options->verbose_.value_or(true));
+
+    if (options->watch_)
+        return kfs::watch_files(*options);
+
+    // The cache stands in for scanning and parsing, so it's no use when asked how they went.
+    std::optional<kfs::ParseCache> cache;
+    if (!options->cache_dir_.empty() && !options->verbose_.value_or(false) && !options->perf_counters_
+        && !options->parse_profile_ && !options->scaling_ && options->engine_ != "ab")
+    {
+        // Records are kept apart by the scan that made them: the parallel scan never
+        // decodes numbers, whatever the options say.
+        const bool parallel = options->threads_ > 1;
+        const uint64_t settings = (parallel ? kfs::ParseCache::parallel_scan : 0)
+                                | (options->decode_numbers_ && !parallel ? kfs::ParseCache::decoded_numbers : 0);
+        auto opened = kfs::ParseCache::open(options->cache_dir_, settings);
+        if (opened.is_error())
+            fmt::print(stderr, "warning: not caching: {}: {}\n", options->cache_dir_, std::strerror(opened.error_number()));
+        else
+            cache = opened.take_value();
+    }
 
-	///NAIVE: We could process the tokens as we go, but that would mean
-	///having some kind of stream wrapper. So for now, the simple route.
-	std::vector<kfs::Token> scanned_tokens = collect_tokens(scanner, true);
-	fmt::print("collected {} tokens\n", scanned_tokens.size());
+    int status = 0;
+    const kfs::MappedSource::Options map_options { .sequential_ = true, .huge_pages_ = options->huge_pages_ };
+    for (const auto& path : options->files_)
+    {
+        auto source = kfs::MappedSource::open(path, map_options);
+        if (source.is_error())
+        {
+            fmt::print(stderr, "error: {}: {}: {}\n", path, source.error(), std::strerror(source.error_number()));
+            status = 2;
+            continue;
+        }
 
-	kfs::TokenSequence tokens{ scanned_tokens.begin(), scanned_tokens.end() };
+        // The mapping has to outlive the tokens and ast that refer to it.
+        const kfs::MappedSource mapped = source.take_value();
+        if (int result = process_document(path, mapped.text(), *options, options->verbose_.value_or(false),
+                                          cache ? &*cache : nullptr); result != 0)
+            status = result;
+    }
+
+    return status;
+}
+
+
+// Scan and parse a single document, reporting the first error, and optionally
+// printing the tokens and resulting ast. With a cache, a document that has been
+// parsed before reports what it did then instead.
+int process_document(std::string_view filename, std::string_view source, const kfs::AppOptions& options, bool verbose,
+                     const kfs::ParseCache* cache)
+{
+	if (options.scaling_)
+		return report_scaling(filename, source);
+
+	std::optional<kfs::ParseCacheKey> cache_key;
+	if (cache != nullptr && !verbose)
+	{
+		cache_key = cache->key(source);
+		if (auto cached = cache->find(*cache_key); cached.has_value())
+			return report_cached(filename, source, *cached);
+	}
+
+	// What this run produces, for the cache.
+	kfs::CachedParse record;
+	auto remember = [&] {
+		if (cache_key.has_value() && !cache->store(*cache_key, record))
+			fmt::print(stderr, "warning: can't write to the parse cache in {}\n", cache->directory());
+	};
+
+	// Phases are measured from one to the next, leaving out the printing between them.
+	std::optional<kfs::PerfRecorder> perf;
+	if (options.perf_counters_)
+		perf.emplace();
+
+	const std::string_view engine = options.engine_;
+	kfs::TokenBuffer scanned_tokens;
+	kfs::TriviaTable trivia;
+	kfs::TriviaTable* const retain = options.retain_comments_ ? &trivia : nullptr;
+	if (options.threads_ > 1)
+	{
+		auto output = kfs::scan_parallel(source, options.threads_);
+		const kfs::LineIndex lines(source);
+		for (const auto& error : output.errors_)
+		{
+			const auto& token = error.error_.token();
+			const auto offset = size_t(token.source_.data() - source.data());
+			fmt::print("{}", kfs::render_diagnostic(lines, filename, offset, token.source_.length(), error.error_.error()));
+			record.scan_errors_.push_back(kfs::ScanDiagnostic{ offset, token.source_.length(), error.error_.code() });
+		}
+		scanned_tokens = std::move(output.tokens_);
+	}
+	else if (engine == "switch")
+	{
+		///NAIVE: We could process the tokens as we go, but that would mean
+		///having some kind of stream wrapper. So for now, the simple route.
+		kfs::Scanner scanner(source);
+		scanner.decode_numbers(options.decode_numbers_);
+		scanner.retain_trivia(retain);
+		scanned_tokens = collect_tokens(scanner, filename, verbose, &record.scan_errors_);
+	}
+	else if (engine == "table")
+	{
+		kfs::TableScanner scanner(source);
+		scanner.decode_numbers(options.decode_numbers_);
+		scanner.retain_trivia(retain);
+		scanned_tokens = collect_tokens(scanner, filename, verbose, &record.scan_errors_);
+	}
+	else if (engine == "indexed")
+	{
+		kfs::IndexedScanner scanner(source);
+		scanner.decode_numbers(options.decode_numbers_);
+		scanned_tokens = collect_tokens(scanner, filename, verbose, &record.scan_errors_);
+	}
+	else
+	{
+		auto tokens = compare_engines(source, filename);
+		if (!tokens.has_value())
+			return 2;
+		scanned_tokens = std::move(tokens.value());
+	}
+	if (perf)
+		perf->end_phase("scan", source.size(), scanned_tokens.size());
+	fmt::print("{}: collected {} tokens\n", filename, scanned_tokens.size());
+	if (scanned_tokens.number_count() != 0)
+		fmt::print("{}: decoded {} numbers\n", filename, scanned_tokens.number_count());
+	record.tokens_ = scanned_tokens.size();
+	record.numbers_ = scanned_tokens.number_count();
+	if (perf)
+		perf->skip();
+
+	kfs::parse_profile().clear();
 	kfs::AST ast;
+	kfs::TokenSequence tokens{ scanned_tokens, ast.symbols_ };
+	if (!trivia.empty())
+	{
+		trivia.attach(scanned_tokens);
+		tokens.trivia_ = &trivia;
+		if (perf)
+			perf->end_phase("attach", source.size(), scanned_tokens.size());
+	}
 	for (;;)
     {
         if (auto result = ast.next(tokens); result.is_error())
         {
-            fmt::print("{}: error: {}", /*filename*/"<input>", result.error());
+            // Point at the error's span when it has one, otherwise at the last token the
+            // parser consumed, which is where it gave up.
+            const kfs::string_view text = scanned_tokens.source();
+            const kfs::string_view span = result.span().source_;
+            const size_t at = tokens.index() > 0 ? tokens.index() - 1 : 0;
+            const kfs::LineIndex lines(text);
+            size_t offset = at < scanned_tokens.size() ? scanned_tokens.offset(at) : text.size();
+            size_t length = at < scanned_tokens.size() ? scanned_tokens.length(at) : 0;
+            if (span.data() >= text.data() && span.data() + span.size() <= text.data() + text.size())
+            {
+                offset = size_t(span.data() - text.data());
+                length = span.size();
+            }
+            fmt::print("{}", kfs::render_diagnostic(lines, filename, offset, length, result.error()));
+            record.nodes_ = ast.nodes_.size();
+            record.parse_error_ = kfs::ScanDiagnostic{ offset, length, result.code() };
+            remember();
+            if (perf)
+            {
+                perf->end_phase("parse", source.size(), tokens.index());
+                report_perf(filename, *perf);
+            }
+            if (options.parse_profile_)
+                report_productions(filename);
             return 22;
         }
         else if (result.is_none())
         {
             break;
         }
-        else
+        else if (verbose)
         {
             fmt::print("- ast added {}\n", result.value());
         }
 	}
+    if (perf)
+        perf->end_phase("parse", source.size(), scanned_tokens.size());
+
+    fmt::print("{}: collected {} ast nodes\n", filename, ast.nodes_.size());
+    record.nodes_ = ast.nodes_.size();
+    remember();
+    if (perf)
+        report_perf(filename, *perf);
+    if (options.parse_profile_)
+        report_productions(filename);
+    if (verbose)
+        describe_ast(ast, scanned_tokens);
+
+    return 0;
+}
+
+
+// Report a document as process_document did when it was parsed and cached, without
+// scanning or parsing it again.
+int report_cached(std::string_view filename, std::string_view source, const kfs::CachedParse& parse)
+{
+    const kfs::LineIndex lines(source);
+    for (const auto& error : parse.scan_errors_)
+        fmt::print("{}", kfs::render_diagnostic(lines, filename, error.offset_, error.length_, kfs::error_message(error.code_)));
+    fmt::print("{}: collected {} tokens\n", filename, parse.tokens_);
+    if (parse.numbers_ != 0)
+        fmt::print("{}: decoded {} numbers\n", filename, parse.numbers_);
 
-    fmt::print("collected {} ast nodes\n", ast.nodes_.size());
+    if (const auto& error = parse.parse_error_; error.has_value())
+    {
+        fmt::print("{}", kfs::render_diagnostic(lines, filename, error->offset_, error->length_, kfs::error_message(error->code_)));
+        return 22;
+    }
+    fmt::print("{}: collected {} ast nodes\n", filename, parse.nodes_);
+    return 0;
+}
 
+
+// Print a description of every top-level node in the ast.
+void describe_ast(const kfs::AST& ast, const kfs::TokenBuffer& tokens)
+{
+    kfs::Arena arena;
     for (auto it = ast.nodes_.cbegin(); it != ast.nodes_.cend(); ++it)
     {
+        const kfs::NodeText text = ast.text(tokens, size_t(std::distance(ast.nodes_.cbegin(), it)));
         fmt::print("ast node #{}: {}:\n|  ", std::distance(ast.nodes_.cbegin(), it), (*it)->node_type());
         if (auto enum_ptr = dynamic_cast<kfs::EnumDefinition*>(it->get()); enum_ptr != nullptr)
         {
-            fmt::print("name={}: ", enum_ptr->name_.source_);
+            fmt::print("name={}: ", text(enum_ptr->name_));
+            if (!enum_ptr->doc_comment_.empty())
+                fmt::print("doc=|{}| ", enum_ptr->doc_comment_);
             for (const auto& child : enum_ptr->members_)
-                fmt::print("child={}, ", child.source_);
+                fmt::print("child={}, ", text(child));
         }
         else if (auto type_ptr = dynamic_cast<kfs::TypeDefinition*>(it->get()); type_ptr != nullptr)
         {
-            fmt::print("name={}: ", type_ptr->name_.source_);
+            fmt::print("name={}: ", text(type_ptr->name_));
+            if (!type_ptr->doc_comment_.empty())
+                fmt::print("doc=|{}| ", type_ptr->doc_comment_);
             if (type_ptr->parent_type_)
-                fmt::print("(derived from {}), ", type_ptr->parent_type_.value().source_);
+                fmt::print("(derived from {}), ", text(type_ptr->parent_type_.value()));
 
             if (type_ptr->members_.empty())
                 fmt::print("<no members>");
@@ -135,11 +372,11 @@ type Connection : Connected { string name, Users users[] = { { x=1, y=1} } }
             {
                 fmt::print("\n|  |  {}'{}' '{}'",
                            (child->is_array_ ? "[]" : "scalar"),
-                           child->type_name().source_, child->name_.source_);
+                           text(child->type_name()), text(child->name_));
                 if (child->default_)
                 {
                     fmt::print("; default=");
-                    describe_value(*reinterpret_cast<kfs::Value*>(child->default_.get()));
+                    describe_value(*reinterpret_cast<kfs::Value*>(child->default_.get()), text, arena);
                 }
             }
 
@@ -153,38 +390,131 @@ type Connection : Connected { string name, Users users[] = { { x=1, y=1} } }
 }
 
 
-std::vector<kfs::Token> collect_tokens(kfs::Scanner& scanner, bool verbose)
+// Print the counters for each phase, totalled and per unit of input, so that, say,
+// a regression from branchy scanning can be told apart from cache misses in the AST.
+void report_perf(std::string_view filename, const kfs::PerfRecorder& perf)
 {
-	std::vector<kfs::Token> scanned_tokens{};
-	for ( ; /*ever*/ ; )
-	{
-		auto result = scanner.next();
-		if (result.is_token())
-		{
-			auto offset = scanner.get_token_offset(result.token());
-			if (!offset.has_value())
-			{
-				fmt::print(stderr, "unreadable token error\n");
-				return {};
-			}
+    using kfs::PerfEvent;
 
-			if (verbose)
-				fmt::print("token: offset:{} type:{:d} text:|{}|\n", offset.value(), int(result.token().type_), result.token().source_);
+    if (!perf.available())
+    {
+        fmt::print("{}: perf: no hardware counters available (see /proc/sys/kernel/perf_event_paranoid)\n", filename);
+        return;
+    }
 
-			scanned_tokens.emplace_back(result.token());
+    constexpr PerfEvent events[] = {
+        PerfEvent::Cycles, PerfEvent::Instructions, PerfEvent::BranchMisses, PerfEvent::L1DMisses, PerfEvent::LLCMisses,
+    };
+    for (const auto& phase : perf.phases())
+    {
+        fmt::print("{}: perf {}: {} bytes, {} tokens, IPC {:.2f}\n", filename, phase.name_, phase.bytes_, phase.tokens_, phase.sample_.ipc());
+        for (const PerfEvent event : events)
+        {
+            if (!phase.sample_.has(event))
+            {
+                fmt::print("  {:>14}: unavailable\n", kfs::perf_event_name(event));
+                continue;
+            }
+            fmt::print("  {:>14}: {:14}  {:10.4f}/byte  {:10.4f}/token\n", kfs::perf_event_name(event), phase.sample_[event],
+                       phase.sample_.per(event, phase.bytes_), phase.sample_.per(event, phase.tokens_));
+        }
+    }
+}
 
-			continue;
-		}
 
-		if (!result.is_error())
+// Print the per-production parse counters for the document just parsed.
+void report_productions(std::string_view filename)
+{
+    if (!KFS_PARSE_PROBES)
+    {
+        fmt::print("{}: productions: parse probes aren't compiled in (configure with -DPARSELAND_PARSE_PROBES=ON)\n", filename);
+        return;
+    }
+
+    const kfs::ParseProfile& profile = kfs::parse_profile();
+    fmt::print("{}: {:>16} {:>10} {:>12} {:>9} {:>14} {:>10}\n", filename, "production", "calls", "tokens", "failures", "time (us)", "ns/call");
+    for (size_t i = 0; i < profile.stats_.size(); ++i)
+    {
+        const auto& stats = profile.stats_[i];
+        fmt::print("{}: {:>16} {:10} {:12} {:9} {:14.3f} {:10.1f}\n", filename, kfs::production_name(kfs::Production(i)),
+                   stats.calls_, stats.tokens_, stats.failures_, double(stats.nanoseconds_) / 1e3,
+                   stats.calls_ != 0 ? double(stats.nanoseconds_) / double(stats.calls_) : 0.0);
+    }
+}
+
+
+// Time the parallel scan with every thread count up to the number of cores, checking
+// that each produces the same output as the serial scan.
+int report_scaling(std::string_view filename, std::string_view source)
+{
+	using Clock = std::chrono::steady_clock;
+
+	const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+	std::optional<kfs::ScanOutput> serial;
+	double serial_time = 0;
+	fmt::print("{}: {} bytes\n", filename, source.size());
+	for (size_t threads = 1; threads <= cores; ++threads)
+	{
+		const auto start = Clock::now();
+		auto output = threads == 1 ? kfs::scan_document(source) : kfs::scan_parallel(source, threads);
+		const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+		if (threads == 1)
+		{
+			serial = std::move(output);
+			serial_time = elapsed.count();
+		}
+		else if (output != serial.value())
 		{
-			if (verbose)
-				fmt::print("end of input\n");
-			break;
+			fmt::print(stderr, "error: {} thread scan differs from the serial scan\n", threads);
+			return 2;
 		}
+		fmt::print("threads {:3}: {:10.3f}ms  {:6.1f}MB/s  speedup {:5.2f}x\n", threads, elapsed.count(),
+				   double(source.size()) / 1e3 / elapsed.count(), serial_time / elapsed.count());
+	}
+	return 0;
+}
+
+
+// Run one scanner engine over the source, reporting how long it took.
+template<typename ScannerType>
+kfs::TokenBuffer time_engine(std::string_view source, std::string_view filename, std::string_view name)
+{
+	using Clock = std::chrono::steady_clock;
+
+	ScannerType scanner(source);
+	const auto start = Clock::now();
+	auto tokens = collect_tokens(scanner, filename, false);
+	const std::chrono::duration<double, std::micro> elapsed = Clock::now() - start;
+	fmt::print("engine {}: {} tokens in {:.3f}us\n", name, tokens.size(), elapsed.count());
+	return tokens;
+}
+
+
+// A/B the switch scanner against the table and indexed scanners over the same source:
+// they must produce the same tokens, and we report how long each took. Returns the
+// tokens, or nullopt if they disagreed.
+std::optional<kfs::TokenBuffer> compare_engines(std::string_view source, std::string_view filename)
+{
+	auto switch_tokens = time_engine<kfs::Scanner>(source, filename, "switch");
+	const std::pair<std::string_view, kfs::TokenBuffer> others[] = {
+		{ "table", time_engine<kfs::TableScanner>(source, filename, "table") },
+		{ "indexed", time_engine<kfs::IndexedScanner>(source, filename, "indexed") },
+	};
+
+	for (const auto& [name, tokens] : others)
+	{
+		if (switch_tokens == tokens)
+			continue;
 
-		fmt::print("error: {}\n", result.error());
+		size_t index = 0;
+		while (index < switch_tokens.size() && index < tokens.size() && switch_tokens.packed(index) == tokens.packed(index))
+			++index;
+		fmt::print(stderr, "error: engines disagree at token #{}: switch:|{}| vs {}:|{}|\n", index,
+				   index < switch_tokens.size() ? switch_tokens.text(index) : "<eoi>"sv, name,
+				   index < tokens.size() ? tokens.text(index) : "<eoi>"sv);
+		return std::nullopt;
 	}
 
-	return scanned_tokens;
+	fmt::print("engines agree\n");
+	return switch_tokens;
 }
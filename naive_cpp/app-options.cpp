@@ -0,0 +1,124 @@
+// Command-line parsing for the naive-cpp app.
+
+#include "app-options.h"
+
+#include <fmt/core.h>
+
+#include <charconv>
+
+
+namespace kfs
+{
+
+using namespace std::string_view_literals;
+
+
+static void usage(std::string_view program)
+{
+    fmt::print(stderr,
+               "usage: {} [options] [file ...]\n"
+               "\n"
+               "Parses each file, or a built-in sample document if no files are given.\n"
+               "\n"
+               "options:\n"
+               "  --engine=ENGINE           scanner implementation: switch, table, indexed, or\n"
+               "                            'ab' to compare them all\n"
+               "  --threads=N               scan each document with N threads (switch engine)\n"
+               "  --scaling                 report parallel scan times from 1 to all cores\n"
+               "  --verbose, --quiet        print (or don't) every token and the resulting ast\n"
+               "  --huge-pages              hint that input files be backed by huge pages\n"
+               "  --numbers                 decode numeric literals while scanning\n"
+               "  --comments                keep comments, and show definitions' doc comments\n"
+               "  --perf                    report hardware counters for each phase, per byte and per token\n"
+               "  --productions             report calls, tokens, failures and time for each parser production\n"
+               "                            (needs a build with PARSELAND_PARSE_PROBES)\n"
+               "  --watch                   keep the files parsed and reparse each as it changes, reporting\n"
+               "                            diagnostics and update times (Linux; switch engine only)\n"
+               "  --cache=DIR               remember what parsing each file produced in DIR, keyed by a hash\n"
+               "                            of its text, and report that for files that haven't changed\n"
+               "                            (not with --verbose, --perf, --productions, --scaling or --engine=ab)\n",
+               program);
+}
+
+
+std::optional<AppOptions> parse_options(int argc, const char* argv[])
+{
+    AppOptions options;
+    bool options_done = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (options_done || !arg.starts_with("-"))
+            options.files_.emplace_back(arg);
+        else if (arg == "--")
+            options_done = true;
+        else if (arg.starts_with("--engine="))
+        {
+            options.engine_ = arg.substr("--engine="sv.length());
+            if (options.engine_ != "switch" && options.engine_ != "table" && options.engine_ != "indexed"
+                && options.engine_ != "ab")
+            {
+                fmt::print(stderr, "unknown engine: {}\n", options.engine_);
+                usage(argv[0]);
+                return std::nullopt;
+            }
+        }
+        else if (arg.starts_with("--threads="))
+        {
+            const auto value = arg.substr("--threads="sv.length());
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), options.threads_);
+            if (ec != std::errc{} || end != value.data() + value.size() || options.threads_ == 0)
+            {
+                fmt::print(stderr, "invalid thread count: {}\n", value);
+                usage(argv[0]);
+                return std::nullopt;
+            }
+        }
+        else if (arg == "--scaling")
+            options.scaling_ = true;
+        else if (arg == "--verbose")
+            options.verbose_ = true;
+        else if (arg == "--quiet")
+            options.verbose_ = false;
+        else if (arg == "--huge-pages")
+            options.huge_pages_ = true;
+        else if (arg == "--numbers")
+            options.decode_numbers_ = true;
+        else if (arg == "--comments")
+            options.retain_comments_ = true;
+        else if (arg == "--perf")
+            options.perf_counters_ = true;
+        else if (arg == "--productions")
+            options.parse_profile_ = true;
+        else if (arg == "--watch")
+            options.watch_ = true;
+        else if (arg.starts_with("--cache="))
+        {
+            options.cache_dir_ = arg.substr("--cache="sv.length());
+            if (options.cache_dir_.empty())
+            {
+                fmt::print(stderr, "--cache needs a directory\n");
+                usage(argv[0]);
+                return std::nullopt;
+            }
+        }
+        else
+        {
+            if (arg != "--help" && arg != "-h")
+                fmt::print(stderr, "unrecognized option: {}\n", arg);
+            usage(argv[0]);
+            return std::nullopt;
+        }
+    }
+
+    if (options.watch_ && options.files_.empty())
+    {
+        fmt::print(stderr, "--watch needs files to watch\n");
+        usage(argv[0]);
+        return std::nullopt;
+    }
+
+    return options;
+}
+
+}
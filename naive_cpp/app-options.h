@@ -0,0 +1,74 @@
+#pragma once
+#ifndef INCLUDED_NAIVE_CPP_APP_OPTIONS_H
+#define INCLUDED_NAIVE_CPP_APP_OPTIONS_H
+
+//! Command-line options for the naive-cpp app.
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace kfs
+{
+
+struct AppOptions
+{
+    // Which scanner implementation to use: the naive 'switch' scanner, the 'table'
+    // driven scanner, the two-stage 'indexed' scanner, or 'ab' to run them all over
+    // the same input, compare their output and timings, and then continue with the
+    // tokens.
+    std::string_view engine_ {"switch"};
+
+    // Print each token and a dump of the AST; defaults to on for the built-in sample
+    // and off when files are given.
+    std::optional<bool> verbose_ {};
+
+    // Number of threads to scan each document with, using the switch scanner; 1
+    // scans on the main thread with the chosen engine.
+    size_t threads_ {1};
+
+    // Rather than parsing, time the parallel scan of each document with every
+    // thread count from 1 to the number of cores.
+    bool scaling_ {false};
+
+    // Ask for input files to be backed by huge pages.
+    bool huge_pages_ {false};
+
+    // Have the scanner decode numeric literals as it goes, reporting any that are
+    // out of range.
+    bool decode_numbers_ {false};
+
+    // Retain comments while scanning, so that definitions pick up their doc comments;
+    // only the switch and table engines retain them.
+    bool retain_comments_ {false};
+
+    // Count cycles, instructions, branch and cache misses for the scan and parse
+    // phases of each document, and report them per byte and per token.
+    bool perf_counters_ {false};
+
+    // Report the parser's per-production counters for each document; they are only
+    // collected when the parser is built with KFS_PARSE_PROBES.
+    bool parse_profile_ {false};
+
+    // Keep the files parsed in memory and reparse each one as it changes, reporting
+    // its diagnostics and how long that took; uses the switch scanner.
+    bool watch_ {false};
+
+    // Directory of the parse cache: a file whose text has already been parsed with the
+    // same settings reports what it did then, without being scanned or parsed; empty
+    // for no cache. Not used when the options ask how scanning or parsing went.
+    std::string cache_dir_ {};
+
+    // Files to parse; if none are given, the built-in sample is used.
+    std::vector<std::string> files_ {};
+};
+
+//! Parses the command line, printing usage and returning nullopt if it isn't valid.
+std::optional<AppOptions> parse_options(int argc, const char* argv[]);
+
+}
+
+
+#endif  //INCLUDED_NAIVE_CPP_APP_OPTIONS_H
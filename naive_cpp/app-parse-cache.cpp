@@ -0,0 +1,164 @@
+// The on-disk parse cache.
+//
+// A record is a run of 64-bit words in the machine's byte order:
+//
+//   magic and format version, settings, text hash, text length,
+//   tokens, numbers, nodes, scan error count, parse error flag,
+//   then offset, length and code for each scan error and the parse error.
+//
+// A record from a machine with the other byte order fails the magic check. Records
+// are written to a temporary file and renamed into place, so that a reader never
+// sees half a record, even with several builds sharing the cache.
+
+#include "app-parse-cache.h"
+#include "content-hash.h"
+
+#include <fmt/core.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <system_error>
+
+
+namespace kfs
+{
+
+
+namespace
+{
+
+    constexpr uint64_t magic = uint64_t(0x504C5043 /*PLPC*/) << 32 | ParseCache::format_version;
+
+    // Words before the diagnostics, and in each one.
+    constexpr size_t header_words = 9;
+    constexpr size_t diagnostic_words = 3;
+
+    void put(std::vector<uint64_t>& words, const ScanDiagnostic& diagnostic)
+    {
+        words.push_back(diagnostic.offset_);
+        words.push_back(diagnostic.length_);
+        words.push_back(uint64_t(diagnostic.code_));
+    }
+
+    // Reads a diagnostic, checking it could have come from text of 'size' bytes.
+    std::optional<ScanDiagnostic> get(const uint64_t* words, uint64_t size)
+    {
+        const uint64_t offset = words[0], length = words[1], code = words[2];
+        if (offset > size || length > size - offset || code == 0 || code >= uint64_t(ErrorCode::Count))
+            return std::nullopt;
+        return ScanDiagnostic{ size_t(offset), size_t(length), ErrorCode(code) };
+    }
+
+}
+
+
+Result<ParseCache> ParseCache::open(const std::string& directory, uint64_t settings)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error || !std::filesystem::is_directory(directory, error))
+        return Result<ParseCache>::SystemErr(ErrorCode::FileOpenFailed, error ? error.value() : ENOTDIR);
+
+    ParseCache cache;
+    cache.directory_ = directory;
+    cache.settings_ = settings;
+    return Result<ParseCache>(std::move(cache));
+}
+
+
+ParseCacheKey ParseCache::key(string_view source) const noexcept
+{
+    return ParseCacheKey{ content_hash(source, settings_), source.size() };
+}
+
+
+std::string ParseCache::path(const ParseCacheKey& key) const
+{
+    return (std::filesystem::path(directory_) / fmt::format("{:016x}.parse", key.hash_)).string();
+}
+
+
+std::optional<CachedParse> ParseCache::find(const ParseCacheKey& key) const
+{
+    std::ifstream file(path(key), std::ios::binary | std::ios::ate);
+    if (!file)
+        return std::nullopt;
+    const auto bytes = size_t(file.tellg());
+    if (bytes < header_words * sizeof(uint64_t) || bytes % sizeof(uint64_t) != 0)
+        return std::nullopt;
+
+    std::vector<uint64_t> words(bytes / sizeof(uint64_t));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(words.data()), std::streamsize(bytes)))
+        return std::nullopt;
+
+    if (words[0] != magic || words[1] != settings_ || words[2] != key.hash_ || words[3] != key.size_)
+        return std::nullopt;
+    const uint64_t scan_errors = words[7], parse_errors = words[8];
+    if (parse_errors > 1 || scan_errors > words.size()
+        || words.size() != header_words + (scan_errors + parse_errors) * diagnostic_words)
+        return std::nullopt;
+
+    CachedParse parse;
+    parse.tokens_ = size_t(words[4]);
+    parse.numbers_ = size_t(words[5]);
+    parse.nodes_ = size_t(words[6]);
+    parse.scan_errors_.reserve(size_t(scan_errors));
+    const uint64_t* at = words.data() + header_words;
+    for (uint64_t i = 0; i < scan_errors; ++i, at += diagnostic_words)
+    {
+        const auto error = get(at, key.size_);
+        if (!error)
+            return std::nullopt;
+        parse.scan_errors_.push_back(*error);
+    }
+    if (parse_errors != 0)
+    {
+        parse.parse_error_ = get(at, key.size_);
+        if (!parse.parse_error_)
+            return std::nullopt;
+    }
+    return parse;
+}
+
+
+bool ParseCache::store(const ParseCacheKey& key, const CachedParse& parse) const
+{
+    std::vector<uint64_t> words {
+        magic, settings_, key.hash_, key.size_,
+        parse.tokens_, parse.numbers_, parse.nodes_, parse.scan_errors_.size(), parse.parse_error_ ? 1U : 0U,
+    };
+    words.reserve(header_words + (parse.scan_errors_.size() + 1) * diagnostic_words);
+    for (const ScanDiagnostic& error : parse.scan_errors_)
+        put(words, error);
+    if (parse.parse_error_)
+        put(words, *parse.parse_error_);
+
+    const std::string final_path = path(key);
+    const std::string temp_path = fmt::format("{}.{:08x}.tmp", final_path, std::random_device{}());
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(words.data()), std::streamsize(words.size() * sizeof(uint64_t)));
+        if (!file.flush())
+        {
+            file.close();
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, final_path, error);
+    if (error)
+    {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+}
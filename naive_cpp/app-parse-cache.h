@@ -0,0 +1,93 @@
+#pragma once
+#ifndef INCLUDED_NAIVE_CPP_APP_PARSE_CACHE_H
+#define INCLUDED_NAIVE_CPP_APP_PARSE_CACHE_H
+
+//! An on-disk cache of what scanning and parsing each document produced, so that a
+//! document whose text hasn't changed since it was last parsed needn't be scanned or
+//! parsed again.
+//!
+//! Records are keyed by a hash of the document's text (content-hash.h), so a file
+//! that is renamed, copied or touched still hits, and one that is edited misses.
+//! Each record is a file in the cache directory, named by the hash, holding the
+//! counts and diagnostics the app reports for the document. It is stamped with the
+//! format version and the settings it was made with; a record that doesn't match
+//! on both, or on the text's hash and length, is treated as a miss.
+
+#include "app-collect.h"
+
+#include "common.h"
+#include "result.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace kfs
+{
+
+    // What scanning and parsing a document produced.
+    struct CachedParse
+    {
+        size_t tokens_  {0};    // Tokens scanned.
+        size_t numbers_ {0};    // Numeric literals decoded.
+        size_t nodes_   {0};    // Top-level definitions parsed.
+
+        // Scanning errors, in order, and the error the parse stopped at, if it didn't
+        // reach the end.
+        std::vector<ScanDiagnostic>   scan_errors_ {};
+        std::optional<ScanDiagnostic> parse_error_ {};
+    };
+
+    // Identifies a document's text in the cache.
+    struct ParseCacheKey
+    {
+        uint64_t hash_ {0};
+        uint64_t size_ {0};
+    };
+
+    struct ParseCache
+    {
+        //! Changes whenever the record format, or what scanning and parsing report,
+        //! does, so that records written by other versions are ignored.
+        static constexpr uint32_t format_version = 2;
+
+        //! Bits of the settings word, for what affects the output for the same text.
+        static constexpr uint64_t decoded_numbers = 1 << 0;   // The scan decoded numbers.
+        static constexpr uint64_t parallel_scan   = 1 << 1;   // Scanned by scan_parallel, which doesn't.
+
+        //! Uses the cache in 'directory', creating it if need be, or returns
+        //! FileOpenFailed, with the errno value saying why in its error_number(). 'settings' is made of the bits
+        //! above, for how the text will be scanned: records made with other settings
+        //! are ignored.
+        static Result<ParseCache> open(const std::string& directory, uint64_t settings = 0);
+
+        //! Hashes a document's text.
+        [[nodiscard]]
+        ParseCacheKey key(string_view source) const noexcept;
+
+        //! Returns the record for the text with this key, if there is a valid one.
+        [[nodiscard]]
+        std::optional<CachedParse> find(const ParseCacheKey& key) const;
+
+        //! Records what parsing the text with this key produced, replacing any previous
+        //! record. Returns false if the record couldn't be written.
+        bool store(const ParseCacheKey& key, const CachedParse& parse) const;
+
+        //! The file holding the record for a key.
+        [[nodiscard]]
+        std::string path(const ParseCacheKey& key) const;
+
+        [[nodiscard]]
+        const std::string& directory() const noexcept { return directory_; }
+
+    protected:
+        std::string directory_ {};
+        uint64_t    settings_  {0};
+    };
+
+}
+
+
+#endif  //INCLUDED_NAIVE_CPP_APP_PARSE_CACHE_H
@@ -0,0 +1,217 @@
+// Unit tests for the on-disk parse cache: a record must come back as it was stored,
+// and anything that doesn't match the text or this version must be a miss.
+
+#include "app-parse-cache.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace kfs;
+
+
+namespace
+{
+
+// A directory in the temp directory, removed with its contents when done.
+struct TempDirectory
+{
+	TempDirectory()
+		: path_((std::filesystem::temp_directory_path() / ("parse-cache-test-" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "-" + ::testing::UnitTest::GetInstance()->current_test_info()->name())).string())
+	{
+		std::filesystem::remove_all(path_);
+	}
+	~TempDirectory() { std::filesystem::remove_all(path_); }
+
+	std::string path_;
+};
+
+CachedParse sample_parse()
+{
+	CachedParse parse;
+	parse.tokens_ = 12;
+	parse.numbers_ = 2;
+	parse.nodes_ = 1;
+	parse.scan_errors_.push_back(ScanDiagnostic{ 9, 1, ErrorCode::UnexpectedCharacter });
+	parse.parse_error_ = ScanDiagnostic{ 20, 3, ErrorCode::ExpectedValue };
+	return parse;
+}
+
+void expect_same(const CachedParse& expected, const CachedParse& actual)
+{
+	EXPECT_EQ(expected.tokens_, actual.tokens_);
+	EXPECT_EQ(expected.numbers_, actual.numbers_);
+	EXPECT_EQ(expected.nodes_, actual.nodes_);
+	ASSERT_EQ(expected.scan_errors_.size(), actual.scan_errors_.size());
+	for (size_t i = 0; i < expected.scan_errors_.size(); ++i)
+	{
+		EXPECT_EQ(expected.scan_errors_[i].offset_, actual.scan_errors_[i].offset_);
+		EXPECT_EQ(expected.scan_errors_[i].length_, actual.scan_errors_[i].length_);
+		EXPECT_EQ(expected.scan_errors_[i].code_, actual.scan_errors_[i].code_);
+	}
+	ASSERT_EQ(expected.parse_error_.has_value(), actual.parse_error_.has_value());
+	if (expected.parse_error_)
+	{
+		EXPECT_EQ(expected.parse_error_->offset_, actual.parse_error_->offset_);
+		EXPECT_EQ(expected.parse_error_->length_, actual.parse_error_->length_);
+		EXPECT_EQ(expected.parse_error_->code_, actual.parse_error_->code_);
+	}
+}
+
+constexpr string_view sample_source = "enum E { @ A } type T { int x = } 1 2";
+
+}
+
+
+TEST(ParseCacheTest, CreatesDirectory)
+{
+	TempDirectory directory;
+	auto cache = ParseCache::open(directory.path_ + "/nested/cache");
+	ASSERT_TRUE(cache.is_value());
+	EXPECT_TRUE(std::filesystem::is_directory(directory.path_ + "/nested/cache"));
+}
+
+
+TEST(ParseCacheTest, NotADirectory)
+{
+	TempDirectory directory;
+	std::filesystem::create_directories(directory.path_);
+	std::ofstream(directory.path_ + "/file") << "x";
+	auto cache = ParseCache::open(directory.path_ + "/file");
+	ASSERT_TRUE(cache.is_error());
+	EXPECT_EQ(ErrorCode::FileOpenFailed, cache.code());
+	EXPECT_NE(0, cache.error_number());
+}
+
+
+TEST(ParseCacheTest, StoreAndFind)
+{
+	TempDirectory directory;
+	const ParseCache cache = ParseCache::open(directory.path_).take_value();
+	const ParseCacheKey key = cache.key(sample_source);
+	EXPECT_EQ(sample_source.size(), key.size_);
+	EXPECT_FALSE(cache.find(key).has_value());
+
+	ASSERT_TRUE(cache.store(key, sample_parse()));
+	const auto found = cache.find(key);
+	ASSERT_TRUE(found.has_value());
+	expect_same(sample_parse(), *found);
+
+	// Replacing a record.
+	CachedParse clean;
+	clean.tokens_ = 3;
+	ASSERT_TRUE(cache.store(key, clean));
+	const auto replaced = cache.find(key);
+	ASSERT_TRUE(replaced.has_value());
+	expect_same(clean, *replaced);
+
+	// Nothing is left behind but the record.
+	size_t files = 0;
+	for ([[maybe_unused]] const auto& entry : std::filesystem::directory_iterator(directory.path_))
+		++files;
+	EXPECT_EQ(1, files);
+}
+
+
+TEST(ParseCacheTest, OtherTextMisses)
+{
+	TempDirectory directory;
+	const ParseCache cache = ParseCache::open(directory.path_).take_value();
+	ASSERT_TRUE(cache.store(cache.key(sample_source), sample_parse()));
+	EXPECT_FALSE(cache.find(cache.key("enum E { @ A } type T { int x = } 1 3")).has_value());
+
+	// Same hash, different length: only a collision could do this, but it must miss.
+	ParseCacheKey key = cache.key(sample_source);
+	++key.size_;
+	EXPECT_FALSE(cache.find(key).has_value());
+}
+
+
+TEST(ParseCacheTest, OtherSettingsMiss)
+{
+	TempDirectory directory;
+	const ParseCache plain = ParseCache::open(directory.path_, 0).take_value();
+	const ParseCache numbers = ParseCache::open(directory.path_, ParseCache::decoded_numbers).take_value();
+	ASSERT_TRUE(plain.store(plain.key(sample_source), sample_parse()));
+	EXPECT_NE(plain.key(sample_source).hash_, numbers.key(sample_source).hash_);
+	EXPECT_FALSE(numbers.find(numbers.key(sample_source)).has_value());
+
+	// Even a record under the other's name.
+	std::filesystem::copy_file(plain.path(plain.key(sample_source)), numbers.path(numbers.key(sample_source)));
+	EXPECT_FALSE(numbers.find(numbers.key(sample_source)).has_value());
+}
+
+
+TEST(ParseCacheTest, DamagedRecordsMiss)
+{
+	TempDirectory directory;
+	const ParseCache cache = ParseCache::open(directory.path_).take_value();
+	const ParseCacheKey key = cache.key(sample_source);
+	ASSERT_TRUE(cache.store(key, sample_parse()));
+
+	std::string record;
+	{
+		std::ifstream file(cache.path(key), std::ios::binary);
+		record.assign(std::istreambuf_iterator<char>(file), {});
+	}
+	auto write = [&] (const std::string& contents) {
+		std::ofstream(cache.path(key), std::ios::binary | std::ios::trunc) << contents;
+	};
+
+	// Truncated, or with anything extra.
+	for (size_t length : { size_t(0), size_t(7), size_t(8 * 9), record.size() - 8, record.size() - 1 })
+	{
+		write(record.substr(0, length));
+		EXPECT_FALSE(cache.find(key).has_value()) << "length " << length;
+	}
+	write(record + std::string(8, '\0'));
+	EXPECT_FALSE(cache.find(key).has_value());
+
+	// Another format version.
+	std::string other = record;
+	other[0] ^= 1;
+	write(other);
+	EXPECT_FALSE(cache.find(key).has_value());
+
+	// A diagnostic outside the text, or with no error code.
+	other = record;
+	other[8 * 9] = char(sample_source.size() + 1);
+	write(other);
+	EXPECT_FALSE(cache.find(key).has_value());
+	other = record;
+	other[8 * 11] = 0;
+	write(other);
+	EXPECT_FALSE(cache.find(key).has_value());
+
+	write(record);
+	EXPECT_TRUE(cache.find(key).has_value());
+}
+
+
+TEST(ParseCacheTest, SettingsChangeBetweenStoreAndFind)
+{
+	// A record from each way of scanning is only found by the same way.
+	TempDirectory directory;
+	const uint64_t settings[] = {
+		0, ParseCache::decoded_numbers, ParseCache::parallel_scan, ParseCache::decoded_numbers | ParseCache::parallel_scan,
+	};
+	for (const uint64_t stored : settings)
+	{
+		std::filesystem::remove_all(directory.path_);
+		const ParseCache writer = ParseCache::open(directory.path_, stored).take_value();
+		CachedParse parse = sample_parse();
+		parse.numbers_ = stored & ParseCache::decoded_numbers ? 2 : 0;
+		ASSERT_TRUE(writer.store(writer.key(sample_source), parse));
+
+		for (const uint64_t found : settings)
+		{
+			const ParseCache reader = ParseCache::open(directory.path_, found).take_value();
+			const auto record = reader.find(reader.key(sample_source));
+			EXPECT_EQ(stored == found, record.has_value()) << "stored " << stored << ", found " << found;
+			if (record)
+				expect_same(parse, *record);
+		}
+	}
+}
@@ -0,0 +1,34 @@
+// Per-production parse counters.
+
+#include "app-parse-probe.h"
+
+
+namespace kfs
+{
+
+
+std::string_view production_name(Production production) noexcept
+{
+    using namespace std::string_view_literals;
+    switch (production)
+    {
+        case Production::EnumDefinition:  return "EnumDefinition"sv;
+        case Production::TypeDefinition:  return "TypeDefinition"sv;
+        case Production::FieldDefinition: return "FieldDefinition"sv;
+        case Production::Value:           return "Value"sv;
+        case Production::CompoundValue:   return "CompoundValue"sv;
+        case Production::EnumValue:       return "EnumValue"sv;
+        case Production::ProcessList:     return "process_list"sv;
+        default:                          return "<invalid production>"sv;
+    }
+}
+
+
+ParseProfile& parse_profile() noexcept
+{
+    thread_local ParseProfile profile;
+    return profile;
+}
+
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+#ifndef INCLUDED_NAIVE_CPP_APP_PARSE_PROBE_H
+#define INCLUDED_NAIVE_CPP_APP_PARSE_PROBE_H
+
+//! Per-production counters for the parser: how often each production of the grammar
+//! was invoked, how many tokens it consumed, how often it failed and how long it took.
+//!
+//! Calls are wrapped with KFS_PARSE_PROBE(Production, ts, call). Unless the parser is
+//! built with KFS_PARSE_PROBES (the PARSELAND_PARSE_PROBES CMake option) that expands
+//! to just the call, so production builds pay nothing. Counts are inclusive - a
+//! TypeDefinition's time includes its fields' - and are kept per thread.
+
+#include "app-tokensequence.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+
+#ifndef KFS_PARSE_PROBES
+#   define KFS_PARSE_PROBES 0
+#endif
+
+
+namespace kfs
+{
+
+    enum class Production : uint8_t
+    {
+        EnumDefinition,
+        TypeDefinition,
+        FieldDefinition,
+        Value,
+        CompoundValue,
+        EnumValue,
+        ProcessList,
+
+        Count
+    };
+
+    //! Returns the name of a production, for reports.
+    [[nodiscard]]
+    std::string_view production_name(Production production) noexcept;
+
+    struct ProductionStats
+    {
+        uint64_t calls_       {0};
+        uint64_t tokens_      {0};    // Tokens consumed, including by nested productions.
+        uint64_t failures_    {0};    // Calls that returned an error.
+        uint64_t nanoseconds_ {0};    // Time spent, including in nested productions.
+    };
+
+    struct ParseProfile
+    {
+        std::array<ProductionStats, size_t(Production::Count)> stats_ {};
+
+        [[nodiscard]]
+        const ProductionStats& operator [] (Production production) const noexcept { return stats_[size_t(production)]; }
+        [[nodiscard]]
+        ProductionStats& operator [] (Production production) noexcept { return stats_[size_t(production)]; }
+
+        void clear() noexcept { stats_ = {}; }
+    };
+
+    //! The calling thread's profile, which the probes add to.
+    [[nodiscard]]
+    ParseProfile& parse_profile() noexcept;
+
+    //! Invokes 'parse', which parses 'production' from 'ts', and accounts for it in
+    //! the thread's profile; returns what 'parse' returned.
+    template<typename Parse>
+    auto parse_probe(Production production, const TokenSequence& ts, Parse&& parse)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const size_t first = ts.index();
+        const auto start = Clock::now();
+        auto result = parse();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+
+        ProductionStats& stats = parse_profile()[production];
+        stats.calls_ += 1;
+        stats.tokens_ += ts.index() - first;
+        stats.failures_ += result.is_error() ? 1 : 0;
+        stats.nanoseconds_ += uint64_t(elapsed.count());
+        return result;
+    }
+
+}
+
+
+#if KFS_PARSE_PROBES
+#   define KFS_PARSE_PROBE(production, ts, call) ::kfs::parse_probe(::kfs::Production::production, (ts), [&] { return call; })
+#else
+#   define KFS_PARSE_PROBE(production, ts, call) (call)
+#endif
+
+
+#endif  //INCLUDED_NAIVE_CPP_APP_PARSE_PROBE_H
@@ -0,0 +1,117 @@
+// Unit tests for the per-production parse counters; the probes in the parser are only
+// compiled in with KFS_PARSE_PROBES, so what a parse records depends on the build.
+
+#include "app-ast.h"
+#include "app-parse-probe.h"
+#include "app-tokensequence.h"
+#include "scanner.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace kfs;
+
+
+namespace
+{
+
+// Scans and parses a document that is expected to be valid.
+void parse(string_view source)
+{
+	Scanner scanner(source);
+	TokenBuffer tokens(source);
+	ASSERT_FALSE(scanner.next_batch(tokens, 4096).is_error());
+
+	AST ast;
+	TokenSequence sequence{ tokens, ast.symbols_ };
+	for (;;)
+	{
+		auto result = ast.next(sequence);
+		ASSERT_FALSE(result.is_error()) << result.error();
+		if (result.is_none())
+			break;
+	}
+}
+
+}
+
+
+TEST(ParseProbeTest, ProductionNames)
+{
+	EXPECT_EQ("EnumDefinition", production_name(Production::EnumDefinition));
+	EXPECT_EQ("process_list", production_name(Production::ProcessList));
+}
+
+
+TEST(ParseProbeTest, ProbeAccountsForCall)
+{
+	const std::string source = "a b c";
+	Scanner scanner(source);
+	TokenBuffer tokens(source);
+	ASSERT_FALSE(scanner.next_batch(tokens, 16).is_error());
+	SymbolTable symbols;
+	TokenSequence ts{ tokens, symbols };
+
+	parse_profile().clear();
+	auto result = parse_probe(Production::Value, ts, [&ts] {
+		ts.take_front();
+		ts.take_front();
+		return Result<int>::Err(ErrorCode::ExpectedValue);
+	});
+	EXPECT_TRUE(result.is_error());
+	parse_probe(Production::Value, ts, [] { return Result<int>::Some(1); });
+
+	const ProductionStats& stats = parse_profile()[Production::Value];
+	EXPECT_EQ(2, stats.calls_);
+	EXPECT_EQ(2, stats.tokens_);
+	EXPECT_EQ(1, stats.failures_);
+	EXPECT_EQ(0, parse_profile()[Production::EnumValue].calls_);
+}
+
+
+TEST(ParseProbeTest, ParseRecordsProductions)
+{
+	parse_profile().clear();
+	parse("enum E { A, B }\n"
+		  "type T { E e = E::A, int x[] = { { y = 1 }, {} } }\n");
+
+	const ParseProfile& profile = parse_profile();
+	if (!KFS_PARSE_PROBES)
+	{
+		for (const ProductionStats& stats : profile.stats_)
+			EXPECT_EQ(0, stats.calls_);
+		return;
+	}
+
+	EXPECT_EQ(1, profile[Production::EnumDefinition].calls_);
+	EXPECT_EQ(1, profile[Production::TypeDefinition].calls_);
+	EXPECT_EQ(2, profile[Production::FieldDefinition].calls_);
+	EXPECT_EQ(1, profile[Production::EnumValue].calls_);
+	// The two defaults, the two elements of the array and the value of 'y'.
+	EXPECT_EQ(5, profile[Production::Value].calls_);
+	// The array, and the two objects in it.
+	EXPECT_EQ(3, profile[Production::CompoundValue].calls_);
+	// The enum and type bodies, and the array and its non-empty object.
+	EXPECT_EQ(4, profile[Production::ProcessList].calls_);
+	for (const ProductionStats& stats : profile.stats_)
+		EXPECT_EQ(0, stats.failures_);
+	// "enum" was taken before the production began.
+	EXPECT_EQ(6, profile[Production::EnumDefinition].tokens_);
+}
+
+
+TEST(ParseProbeTest, ProbeEvaluatesCallOnce)
+{
+	int calls = 0;
+	const auto result = [&] {
+		const std::string source = "x";
+		Scanner scanner(source);
+		TokenBuffer tokens(source);
+		SymbolTable symbols;
+		TokenSequence ts{ tokens, symbols };
+		return KFS_PARSE_PROBE(Value, ts, (++calls, Result<int>::Some(42)));
+	}();
+	EXPECT_EQ(1, calls);
+	EXPECT_EQ(42, result.value());
+}
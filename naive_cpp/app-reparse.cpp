@@ -0,0 +1,151 @@
+// Incremental reparsing: bring an AST up to date after an edit by parsing only the
+// top-level definitions that the changed tokens belong to.
+//
+// Each definition is parsed from its own tokens alone - it starts with 'enum' or
+// 'type' and ends at its closing brace - so a definition none of whose tokens
+// changed would parse exactly the same again. Those before the change are kept as
+// they are; those after it are kept once the reparse reaches the token they begin
+// at, just as retokenize resynchronizes with the old tokens. Nodes hold their tokens
+// relative to the start of their definition, and the symbol table its own copies of
+// the names, so a kept definition needs nothing changing but its extent.
+
+#include "app-ast.h"
+#include "app-definitions.h"
+#include "app-tokensequence.h"
+
+#include <algorithm>
+#include <iterator>
+
+
+namespace kfs
+{
+
+
+namespace
+{
+
+    // Removes a definition from the name lookup, unless the name now belongs to another.
+    void unregister(AST& ast, const ASTNode& node)
+    {
+        const auto definition = node.as<const Definition*>();
+        if (ast.find_definition(definition->name_id_) == definition)
+            ast.definitions_[definition->name_id_] = nullptr;
+    }
+
+}
+
+
+//! Reparse after an edit.
+//
+// The definitions fall into three groups: those that ended before the first changed
+// token, those that began after the last, and those in between, which are discarded
+// and parsed again. Parsing continues from the end of the first group until it
+// reaches the start of a definition in the last group; any it runs past are
+// discarded, so an edit that opens a definition without closing it swallows what
+// follows, as it would in a full parse.
+//
+ReparseResult AST::reparse(TokenSequence& ts, const RetokenizeResult& changed)
+{
+    ReparseResult result;
+
+    const size_t changed_end = changed.first_ + changed.removed_;
+    const auto before_end = std::partition_point(extents_.begin(), extents_.end(),
+            [&] (const TokenExtent& extent) { return extent.end_ <= changed.first_; });
+    const auto after_begin = std::partition_point(before_end, extents_.end(),
+            [&] (const TokenExtent& extent) { return extent.begin_ < changed_end; });
+    const auto kept = size_t(before_end - extents_.begin());
+    const auto after_index = size_t(after_begin - extents_.begin());
+
+    // Set aside the definitions after the change, where their tokens are now; they stay
+    // registered by name until they are reached or dropped.
+    const auto token_shift = ptrdiff_t(changed.inserted_) - ptrdiff_t(changed.removed_);
+    ASTOwnedNodes after(std::make_move_iterator(nodes_.begin() + ptrdiff_t(after_index)), std::make_move_iterator(nodes_.end()));
+    std::vector<TokenExtent> after_extents(after_begin, extents_.end());
+    for (TokenExtent& extent : after_extents)
+    {
+        extent.begin_ = size_t(ptrdiff_t(extent.begin_) + token_shift);
+        extent.end_ = size_t(ptrdiff_t(extent.end_) + token_shift);
+    }
+    for (size_t i = kept; i < after_index; ++i)
+        unregister(*this, *nodes_[i]);
+    result.dropped_ = after_index - kept;
+    nodes_.resize(kept);
+    extents_.resize(kept);
+
+    ts.begin_ = kept > 0 ? extents_.back().end_ : 0;
+    size_t next_after = 0;
+    auto drop_after = [&] (size_t end) {
+        for (; next_after < end; ++next_after, ++result.dropped_)
+        {
+            unregister(*this, *after[next_after]);
+            after[next_after].reset();
+        }
+    };
+
+    for (;;)
+    {
+        // Resynchronized?
+        while (next_after < after.size() && after_extents[next_after].begin_ < ts.index())
+            drop_after(next_after + 1);
+        if (next_after < after.size() && after_extents[next_after].begin_ == ts.index())
+            break;
+
+        const size_t begin = ts.index();
+        result.error_ = next(ts);
+        if (result.error_.is_value())
+        {
+            ++result.reparsed_;
+            continue;
+        }
+
+        // If the name belongs to a definition further on, a full parse wouldn't have
+        // seen that one yet: it's the redefinition, and this one is parsed again.
+        if (result.error_.is_error() && result.error_.code() == ErrorCode::Redefinition)
+        {
+            const Definition* existing = find_definition(symbols_.find(result.error_.span().source_));
+            const auto later = std::find_if(after.begin() + ptrdiff_t(next_after), after.end(),
+                    [existing] (const auto& node) { return node.get() == existing; });
+            if (later != after.end())
+            {
+                unregister(*this, **later);
+                ts.begin_ = begin;
+                continue;
+            }
+        }
+
+        // End of input, or an error: nothing after here was parsed.
+        drop_after(after.size());
+        result.reused_ = kept;
+        return result;
+    }
+
+    // Reinstate the rest, stopping at one whose name has since been taken.
+    result.reused_ = kept;
+    for (; next_after < after.size(); ++next_after)
+    {
+        const auto definition = after[next_after]->as<const Definition*>();
+        if (find_definition(definition->name_id_) != definition)
+        {
+            const NodeText text{ ts.tokens_->source().substr(ts.tokens_->offset(after_extents[next_after].begin_)) };
+            result.error_ = Result<std::string_view>::Err(ErrorCode::Redefinition, text.token(definition->name_));
+            ts.begin_ = after_extents[next_after].end_;
+            after[next_after].reset();
+            ++next_after;
+            ++result.dropped_;
+            drop_after(after.size());
+            return result;
+        }
+        nodes_.push_back(std::move(after[next_after]));
+        extents_.push_back(after_extents[next_after]);
+        ++result.reused_;
+    }
+
+    // The previous parse may have stopped short of the end.
+    ts.begin_ = extents_.empty() ? 0 : extents_.back().end_;
+    for (result.error_ = next(ts); result.error_.is_value(); result.error_ = next(ts))
+        ++result.reparsed_;
+    return result;
+}
+
+
+}
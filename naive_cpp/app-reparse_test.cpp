@@ -0,0 +1,343 @@
+// Unit tests for incremental reparsing: after any edit, the AST must describe the same
+// definitions, and stop at the same error, as parsing the edited document afresh.
+
+#include "app-ast.h"
+#include "app-definitions.h"
+#include "app-tokensequence.h"
+#include "corpus.h"
+#include "retokenize.h"
+#include "scanner.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstring>
+#include <random>
+#include <string>
+
+using namespace kfs;
+
+
+namespace
+{
+
+// Scans a whole document, skipping errors as collect_tokens does.
+TokenBuffer full_scan(string_view source)
+{
+	Scanner scanner(source);
+	TokenBuffer tokens(source);
+	for (;;)
+	{
+		const auto batch = scanner.next_batch(tokens, 4096);
+		if (!batch.is_error() && batch.count_ < 4096)
+			break;
+	}
+	return tokens;
+}
+
+// Parses until the end or the first error, which is returned along with where it stopped.
+Result<std::string_view> parse_all(AST& ast, TokenSequence& ts)
+{
+	auto result = ast.next(ts);
+	while (result.is_value())
+		result = ast.next(ts);
+	return result;
+}
+
+// Describes a node and everything in it by its text, which is 'text'.
+void describe(std::string& out, const ASTNode& node, const NodeText& text)
+{
+	out += node.node_type();
+	out += ' ';
+	out += text(node.root_);
+	if (auto definition = node.as<const Definition*>(); definition != nullptr)
+	{
+		out += ' ';
+		out += text(definition->name_);
+	}
+	if (auto enum_def = node.as<const EnumDefinition*>(); enum_def != nullptr)
+	{
+		for (const NodeToken& member : enum_def->members_)
+			out.append(" ").append(text(member));
+	}
+	else if (auto type_def = node.as<const TypeDefinition*>(); type_def != nullptr)
+	{
+		if (type_def->parent_type_)
+			out.append(" : ").append(text(*type_def->parent_type_));
+		for (const FieldDefinition* field : type_def->members_)
+		{
+			out += " (";
+			describe(out, *field, text);
+			out += ')';
+		}
+	}
+	else if (auto field_def = node.as<const FieldDefinition*>(); field_def != nullptr)
+	{
+		out += field_def->is_array_ ? "[]" : "";
+		if (field_def->default_)
+		{
+			out += " = ";
+			describe(out, *field_def->default_, text);
+		}
+	}
+	else if (auto enum_value = node.as<const EnumValue*>(); enum_value != nullptr)
+	{
+		out.append("::").append(text(enum_value->field_));
+	}
+	else if (auto field_value = node.as<const FieldValue*>(); field_value != nullptr)
+	{
+		out += " = ";
+		describe(out, *field_value->value_, text);
+	}
+	else if (auto compound = node.as<const CompoundValue*>(); compound != nullptr)
+	{
+		for (const auto& value : compound->values_)
+		{
+			out += " {";
+			describe(out, *value, text);
+			out += '}';
+		}
+	}
+}
+
+// Describes an AST's definitions, parsed from 'tokens', and where they came from,
+// checking its name lookup as it goes.
+std::string describe(const AST& ast, const TokenBuffer& tokens)
+{
+	std::string out;
+	EXPECT_EQ(ast.nodes_.size(), ast.extents_.size());
+	for (size_t i = 0; i < ast.nodes_.size(); ++i)
+	{
+		const auto definition = ast.nodes_[i]->as<const Definition*>();
+		const NodeText text = ast.text(tokens, i);
+		EXPECT_EQ(definition, ast.find_definition(ast.symbols_.find(text(definition->name_)))) << text(definition->name_);
+		out += std::to_string(ast.extents_[i].begin_) + '-' + std::to_string(ast.extents_[i].end_) + ' ';
+		describe(out, *definition, text);
+		out += '\n';
+	}
+	EXPECT_EQ(ast.nodes_.size(), size_t(std::count_if(ast.definitions_.begin(), ast.definitions_.end(),
+			[] (const Definition* definition) { return definition != nullptr; })));
+	return out;
+}
+
+
+// A document that is edited and reparsed, alternating between two buffers so that
+// the text before each edit can be wiped, to show nothing still refers to it.
+struct Document
+{
+	std::array<std::string, 2> text_;
+	size_t current_ {0};
+	TokenBuffer tokens_;
+	AST ast_;
+	ReparseResult last_ {};
+	size_t stopped_at_ {0};
+
+	explicit Document(std::string text)
+	{
+		text_[0] = std::move(text);
+		tokens_ = full_scan(text_[0]);
+		TokenSequence ts{ tokens_, ast_.symbols_ };
+		last_.error_ = parse_all(ast_, ts);
+		stopped_at_ = ts.index();
+	}
+
+	const std::string& text() const { return text_[current_]; }
+
+	void edit(size_t offset, size_t removed, string_view inserted)
+	{
+		const std::string& before = text_[current_];
+		std::string& after = text_[current_ ^ 1];
+		after = before;
+		const TextEdit edit = apply_edit(after, offset, removed, inserted);
+		const RetokenizeResult changed = retokenize(tokens_, after, edit);
+		TokenSequence ts{ tokens_, ast_.symbols_ };
+		last_ = ast_.reparse(ts, changed);
+		stopped_at_ = ts.index();
+		// Nothing may refer to the old text any more.
+		text_[current_].assign(text_[current_].size(), '#');
+		current_ ^= 1;
+	}
+
+	// Checks the AST matches a parse from scratch.
+	void expect_fresh() const
+	{
+		const TokenBuffer tokens = full_scan(text());
+		AST fresh;
+		TokenSequence ts{ tokens, fresh.symbols_ };
+		const auto error = parse_all(fresh, ts);
+		ASSERT_EQ(describe(fresh, tokens), describe(ast_, tokens_));
+		ASSERT_EQ(error.is_error(), last_.error_.is_error());
+		ASSERT_EQ(ts.index(), stopped_at_);
+		if (error.is_error())
+		{
+			ASSERT_EQ(error.code(), last_.error_.code());
+			ASSERT_EQ(error.span().source_.data(), last_.error_.span().source_.data());
+		}
+	}
+};
+
+const std::string schema =
+	"enum Colour { Red, Green, Blue }\n"
+	"type Base { int id = 1 }\n"
+	"type Shape : Base { Colour colour = Colour::Red, float points[] = { { x = 1.0 } } }\n"
+	"type Circle : Shape { float radius }\n";
+
+}
+
+
+TEST(ReparseTest, EditInsideDefinition)
+{
+	Document doc(schema);
+	const size_t at = doc.text().find("radius");
+	doc.edit(at, 6, "diameter");
+	doc.expect_fresh();
+	EXPECT_EQ(3, doc.last_.reused_);
+	EXPECT_EQ(1, doc.last_.reparsed_);
+	EXPECT_EQ(1, doc.last_.dropped_);
+	EXPECT_TRUE(doc.last_.error_.is_none());
+}
+
+
+TEST(ReparseTest, EditMovesLaterDefinitions)
+{
+	Document doc(schema);
+	doc.edit(doc.text().find("Green"), 0, "Yellow, ");
+	doc.expect_fresh();
+	EXPECT_EQ(3, doc.last_.reused_);
+	EXPECT_EQ(1, doc.last_.reparsed_);
+	EXPECT_EQ(9 + 2, doc.ast_.extents_[1].begin_);
+}
+
+
+TEST(ReparseTest, EditBetweenDefinitions)
+{
+	Document doc(schema);
+	doc.edit(doc.text().find("type Base"), 0, "enum Flag { On }\n");
+	doc.expect_fresh();
+	// The closing brace before the edit is close enough to be rescanned, so Colour is
+	// parsed again too.
+	EXPECT_EQ(3, doc.last_.reused_);
+	EXPECT_EQ(2, doc.last_.reparsed_);
+	EXPECT_EQ(1, doc.last_.dropped_);
+
+	// Only a comment changes: no tokens, so nothing is parsed.
+	doc.edit(0, 0, "// colours\n");
+	doc.expect_fresh();
+	EXPECT_EQ(5, doc.last_.reused_);
+	EXPECT_EQ(0, doc.last_.reparsed_);
+}
+
+
+TEST(ReparseTest, UnclosedDefinitionSwallowsTheRest)
+{
+	Document doc(schema);
+	doc.edit(doc.text().find(" }\ntype Shape"), 2, "");
+	doc.expect_fresh();
+	EXPECT_TRUE(doc.last_.error_.is_error());
+	EXPECT_EQ(1, doc.ast_.nodes_.size());
+
+	// Closing it again parses everything after it.
+	doc.edit(doc.text().find("type Shape"), 0, "}\n");
+	doc.expect_fresh();
+	EXPECT_TRUE(doc.last_.error_.is_none());
+	EXPECT_EQ(4, doc.ast_.nodes_.size());
+}
+
+
+TEST(ReparseTest, RenameClashesWithLaterDefinition)
+{
+	Document doc(schema);
+	// Base becomes Circle: the full parse would complain about the later Circle.
+	doc.edit(doc.text().find("Base {"), 4, "Circle");
+	doc.expect_fresh();
+	ASSERT_TRUE(doc.last_.error_.is_error());
+	EXPECT_EQ(ErrorCode::Redefinition, doc.last_.error_.code());
+	EXPECT_EQ(3, doc.ast_.nodes_.size());
+
+	// And back again.
+	doc.edit(doc.text().find("Circle {"), 6, "Base");
+	doc.expect_fresh();
+	EXPECT_TRUE(doc.last_.error_.is_none());
+	EXPECT_EQ(4, doc.ast_.nodes_.size());
+}
+
+
+TEST(ReparseTest, SmallEditInLargeDocument)
+{
+	CorpusOptions options;
+	options.target_size_ = 256 * 1024;
+	Document doc(generate_corpus(options));
+	ASSERT_TRUE(doc.last_.error_.is_none());
+	const size_t definitions = doc.ast_.nodes_.size();
+
+	// Add a field to a type halfway through.
+	const size_t at = doc.text().find('{', doc.text().find("\ntype T", doc.text().size() / 2)) + 1;
+	doc.edit(at, 0, " int added_field = 42,");
+	doc.expect_fresh();
+	EXPECT_EQ(definitions - 1, doc.last_.reused_);
+	EXPECT_EQ(1, doc.last_.reparsed_);
+}
+
+
+// Renaming a definition over and over only ever reparses that definition; however
+// many names pass through the symbol table, nothing else is parsed again.
+TEST(ReparseTest, RenamesOnlyReparseTheRenamed)
+{
+	CorpusOptions options;
+	options.target_size_ = 4 * 1024;
+	Document doc(generate_corpus(options));
+	ASSERT_TRUE(doc.last_.error_.is_none());
+	const size_t definitions = doc.ast_.nodes_.size();
+
+	const size_t at = doc.text().find("\ntype T", doc.text().size() / 2) + 6;
+	size_t length = doc.text().find(' ', at) - at;
+	for (int i = 0; i < 5000; ++i)
+	{
+		const std::string name = "Renamed" + std::to_string(i);
+		doc.edit(at, length, name);
+		length = name.size();
+		ASSERT_TRUE(doc.last_.error_.is_none()) << "rename #" << i;
+		ASSERT_EQ(definitions - 1, doc.last_.reused_) << "rename #" << i;
+		ASSERT_EQ(1, doc.last_.reparsed_) << "rename #" << i;
+	}
+	doc.expect_fresh();
+}
+
+
+// Random edits of every kind, each checked against a parse from scratch. Those that
+// break the document, and most of the others, are undone straight away.
+TEST(ReparseTest, RandomEditsMatchFullParse)
+{
+	static const char* fragments[] = {
+		"", " ", "x", "int", "enum", "type", "T1", "E1", "{", "}", "{ }", "=", ":", "::", ",", "[]", "42", "\"s\"",
+		"/*", "*/", "//", "\n", "type Q { int q }\n", "enum F { A, B }\n", "} type", "= { { a = 1 } }",
+	};
+
+	CorpusOptions options;
+	options.target_size_ = 16 * 1024;
+	Document doc(generate_corpus(options));
+
+	std::mt19937 rng(11);
+	for (int i = 0; i < 400; ++i)
+	{
+		// Start at a random byte, or at the start of a line, where whole definitions go.
+		size_t offset = rng() % (doc.text().size() + 1);
+		if (rng() % 2 == 0)
+			offset = doc.text().rfind('\n', offset) + 1;
+		const size_t removed = rng() % 3 == 0 ? rng() % 24 : 0;
+		const std::string original = doc.text().substr(std::min(offset, doc.text().size()), removed);
+		const char* inserted = fragments[rng() % std::size(fragments)];
+		doc.edit(offset, removed, inserted);
+		doc.expect_fresh();
+		if (!testing::Test::HasFatalFailure() && (doc.last_.error_.is_error() || rng() % 4 != 0))
+		{
+			doc.edit(offset, std::strlen(inserted), original);
+			doc.expect_fresh();
+		}
+		if (testing::Test::HasFatalFailure())
+		{
+			ADD_FAILURE() << "edit #" << i << " at " << offset << ", removed " << removed << ", inserted |" << inserted << "|";
+			return;
+		}
+	}
+}
@@ -2,45 +2,91 @@
 #ifndef INCLUDED_NAIVE_CPP_APP_TOKENSEQUENCE_H
 #define INCLUDED_NAIVE_CPP_APP_TOKENSEQUENCE_H
 
+#include "app-ast.h"
+#include "symbol-table.h"
 #include "token.h"
+#include "token-buffer.h"
+#include "trivia.h"
 
-#include <iterator>
+#include <cstddef>
 #include <optional>
-#include <vector>
+#include <utility>
 
 
 namespace kfs
 {
 
     //! A consecutive sequence of scanner tokens that may be some or all of a document.
+    //
+    // The tokens live in a TokenBuffer; type checks only look at the buffer's type
+    // array, and a Token (with its string_view) is only materialized when one is
+    // actually taken or peeked. Names are interned into the parse's SymbolTable as
+    // they are taken, so that the parser can work with ids rather than text. If the
+    // comments were retained, the trivia table lets the parser find doc comments.
+    // The nodes of a top-level definition hold their tokens relative to base_, the
+    // offset of its first token, which AST::next sets as it starts each one.
+    //
     struct TokenSequence
     {
-        using data_type = std::vector<Token>;
-        using iterator  = data_type::iterator;
-        using difference_type = data_type::difference_type;
+        using difference_type = std::ptrdiff_t;
+
+        const TokenBuffer* tokens_;
+        SymbolTable* symbols_;
+        size_t begin_;
+        size_t end_;
+        const TriviaTable* trivia_ {nullptr};
+        size_t base_ {0};
+
+        TokenSequence(const TokenBuffer& tokens, SymbolTable& symbols)
+            : tokens_(&tokens), symbols_(&symbols), begin_(0), end_(tokens.size())
+        {}
+        TokenSequence(const TokenBuffer& tokens, SymbolTable& symbols, size_t begin, size_t end)
+            : tokens_(&tokens), symbols_(&symbols), begin_(begin), end_(end)
+        {}
+
+        //! Returns the symbol id of a word's text, interning it if it's new.
+        SymbolId intern(const Token& word) { return symbols_->intern(word.source_); }
+
+        //! Returns 'token', which must be in the current definition, as a node holds it.
+        NodeToken node_token(const Token& token) const noexcept
+        {
+            const size_t offset = size_t(token.source_.data() - tokens_->source().data()) - base_;
+            return NodeToken{ uint32_t(offset), uint32_t(token.source_.size()), token.type_, token.flags_ };
+        }
+
+        //! Returns a token of the current definition, as a node holds it, as a Token.
+        Token token(const NodeToken& token) const noexcept
+        {
+            return NodeText{ tokens_->source().substr(base_) }.token(token);
+        }
 
-        iterator begin_;
-        iterator end_;
+        //! Returns the comment immediately before the token at 'index' of the buffer, if
+        //! comments were retained.
+        string_view doc_comment(size_t index) const
+        {
+            return trivia_ ? trivia_->doc_comment(tokens_->source(), index) : string_view{};
+        }
 
         bool is_empty() const { return (begin_ == end_); }
-        auto length()   const { return std::distance(begin_, end_); }
+        auto length()   const { return difference_type(end_ - begin_); }
+
+        //! Index of the front token within the underlying buffer.
+        size_t index()  const { return begin_; }
 
         // Unchecked!
-        Token front() const { return *begin_; }
+        Token front() const { return tokens_->token(begin_); }
+        Token::Type front_type() const { return tokens_->type(begin_); }
 
-        const Token& advance()
+        Token advance()
         {
-            std::advance(begin_, 1);
-            return *(begin_ - 1);
+            return tokens_->token(begin_++);
         }
 
         std::pair<Token, bool> take_front()
         {
             if (is_empty())
                 return {};
-            Token first = *(begin_);
-            std::advance(begin_, 1);
-            return {first, true};
+            return {advance(), true};
         }
 
         // Take the front-most token, but only if it matches type.
@@ -48,21 +94,19 @@ namespace kfs
         {
             if (!peek_ahead(type))
                 return {};
-            Token first = *(begin_);
-            std::advance(begin_, 1);
-            return {first, true};
+            return {advance(), true};
         }
 
         std::optional<const Token> peek(difference_type n) const
         {
             if (n < 0 || n >= length())
                 return std::nullopt;
-            return *std::next(begin_, n);
+            return tokens_->token(begin_ + size_t(n));
         }
 
         bool peek_ahead(Token::Type type) const
         {
-            return !is_empty() && (begin_->type_ == type);
+            return !is_empty() && (tokens_->type(begin_) == type);
         }
 
         //! returns true if there is a token `n` tokens ahead which has type `type`.
@@ -71,7 +115,7 @@ namespace kfs
         {
             if (n < 0 || n >= length())
                 return false;
-            return std::next(begin_, n)->type_ == type;
+            return tokens_->type(begin_ + size_t(n)) == type;
         }
     };
 
@@ -0,0 +1,226 @@
+// Watch mode: keep each file's tokens and AST in memory, and bring them up to date as
+// the file changes.
+//
+// The directories holding the files are watched rather than the files themselves:
+// editors commonly save by writing a new file and renaming it over the old one, which
+// a watch on the old file's inode would miss. A file counts as changed when a writer
+// closes it or something is renamed onto it. Events arriving close together are
+// gathered up so that each file is read and reparsed once per burst.
+
+#include "app-watch.h"
+
+#include "app-document.h"
+#include "line-index.h"
+#include "mapped-source.h"
+
+#include <fmt/core.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#   define KFS_HAVE_INOTIFY 1
+#   include <poll.h>
+#   include <sys/inotify.h>
+#   include <unistd.h>
+#else
+#   define KFS_HAVE_INOTIFY 0
+#endif
+
+
+namespace kfs
+{
+
+
+#if KFS_HAVE_INOTIFY
+
+namespace
+{
+
+    // How long to wait for more events after one arrives, so that a burst of writes is
+    // handled as one change.
+    constexpr int settle_ms = 50;
+
+    // Reads the whole of a file, or reports why it couldn't. It's copied anyway, and
+    // an editor may truncate it at any moment, which would fault a mapping, so it's
+    // read rather than mapped.
+    std::optional<std::string> read_source(const std::string& path)
+    {
+        auto source = MappedSource::open(path, MappedSource::Options{ .map_ = false });
+        if (source.is_error())
+        {
+            fmt::print(stderr, "error: {}: {}: {}\n", path, source.error(), std::strerror(source.error_number()));
+            return std::nullopt;
+        }
+        return std::string(source.value().text());
+    }
+
+    // Prints a document's diagnostics and a summary of the update that produced them.
+    void report(const std::string& path, const Document& document, const DocumentUpdate& update, double milliseconds)
+    {
+        const std::string_view text = document.text();
+        const LineIndex lines(text);
+        for (const ScanDiagnostic& error : document.scan_errors_)
+            fmt::print("{}", render_diagnostic(lines, path, error.offset_, error.length_, error_message(error.code_)));
+
+        const auto& parse_error = document.parse_error_;
+        if (parse_error.is_error())
+        {
+            // As process_document does: the error's span if it has one, otherwise the last
+            // token the parser consumed.
+            const TokenBuffer& tokens = document.tokens_;
+            const std::string_view span = parse_error.span().source_;
+            const size_t at = document.stopped_at_ > 0 ? document.stopped_at_ - 1 : 0;
+            size_t offset = at < tokens.size() ? tokens.offset(at) : text.size();
+            size_t length = at < tokens.size() ? tokens.length(at) : 0;
+            if (span.data() >= text.data() && span.data() + span.size() <= text.data() + text.size())
+            {
+                offset = size_t(span.data() - text.data());
+                length = span.size();
+            }
+            fmt::print("{}", render_diagnostic(lines, path, offset, length, parse_error.error()));
+        }
+
+        fmt::print("{}: {} definitions, {} errors; updated in {:.3f}ms (scanned {} bytes, reused {} definitions, parsed {})\n",
+                   path, document.ast_.nodes_.size(), document.scan_errors_.size() + (parse_error.is_error() ? 1 : 0),
+                   milliseconds, update.rescanned_, update.parse_.reused_, update.parse_.reparsed_);
+    }
+
+    // A file being watched, and what is known of it.
+    struct WatchedFile
+    {
+        std::string path_;
+        std::unique_ptr<Document> document_;
+    };
+
+    // Reads a file and brings its document up to date, reporting the result.
+    void refresh(WatchedFile& file, bool decode_numbers)
+    {
+        auto text = read_source(file.path_);
+        if (!text)
+            return;
+        if (!file.document_)
+            file.document_ = std::make_unique<Document>(decode_numbers);
+
+        const auto start = std::chrono::steady_clock::now();
+        const DocumentUpdate update = file.document_->update(std::move(*text));
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (update.changed_)
+            report(file.path_, *file.document_, update, elapsed.count());
+    }
+
+}
+
+
+int watch_files(const AppOptions& options)
+{
+    const int fd = ::inotify_init1(IN_CLOEXEC);
+    if (fd < 0)
+    {
+        fmt::print(stderr, "error: can't watch files: {}\n", std::strerror(errno));
+        return 2;
+    }
+
+    // Watch each directory once, and find files by their directory's watch and name.
+    constexpr uint32_t events = IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM;
+    using FileKey = std::pair<int, std::string>;
+    std::map<std::string, int> directories;
+    std::map<FileKey, WatchedFile> files;
+    for (const auto& path : options.files_)
+    {
+        const std::filesystem::path file_path(path);
+        const std::filesystem::path directory_path = file_path.has_parent_path() ? file_path.parent_path() : std::filesystem::path(".");
+        const std::string directory = directory_path.string();
+        auto [it, added] = directories.emplace(directory, -1);
+        if (added)
+            it->second = ::inotify_add_watch(fd, directory.c_str(), events);
+        if (it->second < 0)
+        {
+            fmt::print(stderr, "error: can't watch {}: {}\n", directory, std::strerror(errno));
+            ::close(fd);
+            return 2;
+        }
+        // Another spelling of a file already listed has the same directory watch and name.
+        const auto [file, inserted] = files.try_emplace({ it->second, file_path.filename().string() }, WatchedFile{ path, nullptr });
+        if (!inserted)
+            fmt::print(stderr, "warning: {} is the same file as {}; watching it once\n", path, file->second.path_);
+    }
+
+    for (auto& [key, file] : files)
+        refresh(file, options.decode_numbers_);
+    fmt::print("watching {} files; interrupt to stop\n", files.size());
+    std::fflush(stdout);
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    std::map<FileKey, bool /*present*/> pending;
+    for (;;)
+    {
+        // Wait for something to happen, then for things to settle.
+        pollfd poll_fd{ fd, POLLIN, 0 };
+        const int ready = ::poll(&poll_fd, 1, pending.empty() ? -1 : settle_ms);
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready < 0)
+        {
+            fmt::print(stderr, "error: watching files: {}\n", std::strerror(errno));
+            ::close(fd);
+            return 2;
+        }
+
+        if (ready == 0)
+        {
+            for (const auto& [key, present] : pending)
+            {
+                WatchedFile& file = files.at(key);
+                if (present)
+                    refresh(file, options.decode_numbers_);
+                else
+                    fmt::print("{}: removed\n", file.path_);
+            }
+            pending.clear();
+            std::fflush(stdout);
+            continue;
+        }
+
+        const ssize_t length = ::read(fd, buffer, sizeof(buffer));
+        if (length < 0)
+            continue;
+        for (const char* at = buffer; at < buffer + length; )
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(at);
+            at += sizeof(inotify_event) + event->len;
+
+            // If events were lost, anything might have changed.
+            if ((event->mask & IN_Q_OVERFLOW) != 0)
+            {
+                for (const auto& [key, file] : files)
+                    pending[key] = true;
+                continue;
+            }
+            if (event->len == 0)
+                continue;
+            if (FileKey key{ event->wd, event->name }; files.contains(key))
+                pending[key] = (event->mask & (IN_DELETE | IN_MOVED_FROM)) == 0;
+        }
+    }
+}
+
+#else
+
+int watch_files(const AppOptions&)
+{
+    fmt::print(stderr, "error: --watch needs inotify, which this platform doesn't have\n");
+    return 2;
+}
+
+#endif
+
+
+}
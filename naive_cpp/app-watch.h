@@ -0,0 +1,22 @@
+#pragma once
+#ifndef INCLUDED_NAIVE_CPP_APP_WATCH_H
+#define INCLUDED_NAIVE_CPP_APP_WATCH_H
+
+//! Watch mode for the naive-cpp app: parse a set of files, then keep their tokens and
+//! ASTs in memory and reparse each file as it changes, reporting its diagnostics and
+//! how long the update took.
+
+#include "app-options.h"
+
+
+namespace kfs
+{
+
+//! Parses the files in 'options', then watches them (with inotify) until interrupted.
+//! Returns non-zero if watching isn't possible.
+int watch_files(const AppOptions& options);
+
+}
+
+
+#endif  //INCLUDED_NAIVE_CPP_APP_WATCH_H
@@ -0,0 +1,84 @@
+// Bump allocator for materialized text.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "arena.h"
+
+#include <cstring>
+#include <utility>
+
+
+namespace kfs
+{
+
+
+// The free space is in a block that moves with blocks_, so it has to move too.
+Arena::Arena(Arena&& rhs) noexcept
+	: blocks_(std::move(rhs.blocks_))
+	, next_(std::exchange(rhs.next_, nullptr))
+	, remaining_(std::exchange(rhs.remaining_, 0))
+	, block_size_(rhs.block_size_)
+	, bytes_used_(std::exchange(rhs.bytes_used_, 0))
+{
+	rhs.blocks_.clear();
+}
+
+
+Arena& Arena::operator = (Arena&& rhs) noexcept
+{
+	if (this != &rhs)
+	{
+		blocks_ = std::move(rhs.blocks_);
+		rhs.blocks_.clear();
+		next_ = std::exchange(rhs.next_, nullptr);
+		remaining_ = std::exchange(rhs.remaining_, 0);
+		block_size_ = rhs.block_size_;
+		bytes_used_ = std::exchange(rhs.bytes_used_, 0);
+	}
+	return *this;
+}
+
+
+char* Arena::allocate(size_t size)
+{
+	bytes_used_ += size;
+	if (size > remaining_)
+	{
+		// An oversized request gets its own block, leaving the current one to carry on.
+		if (size > block_size_ / 2)
+			return blocks_.emplace_back(std::make_unique_for_overwrite<char[]>(size)).get();
+		blocks_.emplace_back(std::make_unique_for_overwrite<char[]>(block_size_));
+		next_ = blocks_.back().get();
+		remaining_ = block_size_;
+	}
+
+	char* data = next_;
+	next_ += size;
+	remaining_ -= size;
+	return data;
+}
+
+
+string_view Arena::copy(string_view text)
+{
+	if (text.empty())
+		return {};
+	char* data = allocate(text.size());
+	std::memcpy(data, text.data(), text.size());
+	return string_view(data, text.size());
+}
+
+
+// Only the allocation at the end of the current block can be shrunk.
+void Arena::shrink(const char* data, size_t size, size_t used) noexcept
+{
+	if (used > size || data + size != next_)
+		return;
+	next_ -= size - used;
+	remaining_ += size - used;
+	bytes_used_ -= size - used;
+}
+
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_ARENA_H
+#define INCLUDED_KFS_NAIVE_CPP_ARENA_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Bump allocator for text that has to be materialized rather than viewed, such as
+// the unescaped values of string literals.
+//
+// Almost everything the scanner and parser produce is a view of the source, so the
+// few strings that can't be need to live somewhere that will outlast the views
+// without paying for an allocation each. The arena hands out space from large
+// blocks and frees it all at once when it is destroyed.
+
+
+#include "common.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+namespace kfs
+{
+
+
+struct Arena
+{
+public:
+	static constexpr size_t default_block_size = 64 * 1024;
+
+	explicit Arena(size_t block_size = default_block_size) noexcept : block_size_(block_size) {}
+
+	Arena(const Arena&) = delete;
+	Arena& operator = (const Arena&) = delete;
+	// Moving takes the blocks, and leaves the source empty, as if newly constructed.
+	Arena(Arena&& rhs) noexcept;
+	Arena& operator = (Arena&& rhs) noexcept;
+
+	//! Returns space for 'size' bytes, which remains valid for the life of the arena.
+	//! Requests larger than the block size get a block of their own.
+	[[nodiscard]]
+	char* allocate(size_t size);
+
+	//! Copies 'text' into the arena and returns a view of the copy.
+	[[nodiscard]]
+	string_view copy(string_view text);
+
+	//! Gives back the most recent allocation's unused tail: 'used' bytes of the
+	//! allocation at 'data' were kept.
+	void shrink(const char* data, size_t size, size_t used) noexcept;
+
+	//! Total bytes handed out, and the number of blocks they came from.
+	[[nodiscard]]
+	size_t bytes_used() const noexcept { return bytes_used_; }
+	[[nodiscard]]
+	size_t block_count() const noexcept { return blocks_.size(); }
+
+protected:
+	std::vector<std::unique_ptr<char[]>>	blocks_		{ };
+	char*		next_		{ nullptr };	// Free space in the current block.
+	size_t		remaining_	{ 0 };
+	size_t		block_size_	{ default_block_size };
+	size_t		bytes_used_	{ 0 };
+};
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_ARENA_H
@@ -0,0 +1,102 @@
+// Unit tests for the bump allocator.
+
+#include "arena.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace kfs;
+
+
+TEST(ArenaTest, Copy)
+{
+	Arena arena(64);
+	EXPECT_EQ(0, arena.block_count());
+	EXPECT_TRUE(arena.copy("").empty());
+
+	std::string text = "hello";
+	const string_view copy = arena.copy(text);
+	text[0] = 'j';
+	EXPECT_EQ("hello", copy);
+	EXPECT_NE(text.data(), copy.data());
+	EXPECT_EQ(1, arena.block_count());
+	EXPECT_EQ(5, arena.bytes_used());
+}
+
+
+TEST(ArenaTest, CopiesSurviveNewBlocks)
+{
+	Arena arena(64);
+	std::vector<string_view> copies;
+	for (int i = 0; i < 100; ++i)
+		copies.push_back(arena.copy(std::to_string(i * 1000)));
+	EXPECT_GT(arena.block_count(), 1);
+	for (int i = 0; i < 100; ++i)
+		EXPECT_EQ(std::to_string(i * 1000), copies[i]);
+}
+
+
+TEST(ArenaTest, OversizedRequests)
+{
+	Arena arena(64);
+	const string_view small = arena.copy("small");
+	const std::string big(1000, 'b');
+	const string_view big_copy = arena.copy(big);
+	EXPECT_EQ(big, big_copy);
+	EXPECT_EQ(2, arena.block_count());
+
+	// The current block carries on after the oversized one.
+	const string_view next = arena.copy("next");
+	EXPECT_EQ(small.data() + small.size(), next.data());
+	EXPECT_EQ(2, arena.block_count());
+}
+
+
+TEST(ArenaTest, Shrink)
+{
+	Arena arena(64);
+	char* first = arena.allocate(10);
+	arena.shrink(first, 10, 4);
+	EXPECT_EQ(4, arena.bytes_used());
+	char* second = arena.allocate(1);
+	EXPECT_EQ(first + 4, second);
+
+	// Only the most recent allocation can be shrunk.
+	arena.shrink(first, 4, 0);
+	EXPECT_EQ(5, arena.bytes_used());
+}
+
+
+TEST(ArenaTest, MoveLeavesSourceEmpty)
+{
+	Arena source(64);
+	const string_view first = source.copy("first");
+
+	Arena moved(std::move(source));
+	EXPECT_EQ(1, moved.block_count());
+	EXPECT_EQ(5, moved.bytes_used());
+	EXPECT_EQ(0, source.block_count());
+	EXPECT_EQ(0, source.bytes_used());
+
+	// The moved-from arena starts a block of its own rather than writing into the
+	// block it no longer owns.
+	const string_view again = source.copy("again");
+	EXPECT_EQ(1, source.block_count());
+	EXPECT_EQ("first", first);
+	EXPECT_EQ("again", again);
+	EXPECT_NE(first.data() + first.size(), again.data());
+
+	// Likewise for assignment.
+	Arena assigned(64);
+	(void)assigned.copy("old");
+	assigned = std::move(source);
+	EXPECT_EQ(1, assigned.block_count());
+	EXPECT_EQ(0, source.block_count());
+	EXPECT_EQ(0, source.bytes_used());
+	const string_view after = source.copy("after");
+	EXPECT_EQ("again", again);
+	EXPECT_EQ("after", after);
+	EXPECT_EQ(1, source.block_count());
+}
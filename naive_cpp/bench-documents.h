@@ -0,0 +1,90 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_BENCH_DOCUMENTS_H
+#define INCLUDED_KFS_NAIVE_CPP_BENCH_DOCUMENTS_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Documents for the benchmarks to chew on. They are generated deterministically,
+// so results are comparable between runs and versions.
+
+
+#include "common.h"
+#include "corpus.h"
+#include "perf-counters.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+
+
+namespace kfs::bench
+{
+
+
+//! Returns 'fragment' repeated until the result is at least 'size' bytes.
+inline std::string repeat(string_view fragment, size_t size)
+{
+	std::string text;
+	text.reserve(size + fragment.size());
+	while (text.size() < size)
+		text += fragment;
+	return text;
+}
+
+
+//! Returns a valid schema of at least 'size' bytes, from the corpus generator with
+//! its default shape and a fixed seed.
+inline std::string make_schema(size_t size)
+{
+	CorpusOptions options;
+	options.target_size_ = size;
+	return generate_corpus(options);
+}
+
+
+//! Reports throughput in bytes/sec and tokens/sec for 'bytes' and 'tokens' per iteration;
+//! benchmarks that don't consume text pass 0 bytes, and those that don't produce
+//! tokens 0 tokens, and the figure is left out rather than reported as 0/s.
+inline void report_throughput(benchmark::State& state, size_t bytes, size_t tokens)
+{
+	if (bytes != 0)
+		state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(bytes));
+	if (tokens != 0)
+		state.counters["tokens"] = benchmark::Counter(double(tokens), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+
+//! Adds hardware counters to a benchmark's results: 'sample' covers all of its
+//! iterations, each of which processed 'bytes' and 'tokens'. Events the machine
+//! can't count are left out; the counters are per byte and per token, plus IPC.
+inline void report_perf(benchmark::State& state, const PerfSample& sample, size_t bytes, size_t tokens)
+{
+	constexpr PerfEvent events[] = {
+		PerfEvent::Cycles, PerfEvent::Instructions, PerfEvent::BranchMisses, PerfEvent::L1DMisses, PerfEvent::LLCMisses,
+	};
+	const size_t iterations = size_t(state.iterations());
+	if (iterations == 0)
+		return;
+	for (const PerfEvent event : events)
+	{
+		if (!sample.has(event))
+			continue;
+		const std::string name(perf_event_name(event));
+		if (bytes != 0)
+			state.counters[name + "/byte"] = sample.per(event, bytes * iterations);
+		if (tokens != 0)
+			state.counters[name + "/token"] = sample.per(event, tokens * iterations);
+	}
+	if (sample.ipc() != 0)
+		state.counters["IPC"] = sample.ipc();
+}
+
+
+//! Size of the documents scanned and parsed.
+inline constexpr size_t document_size = 1 << 20;
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_BENCH_DOCUMENTS_H
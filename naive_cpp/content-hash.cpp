@@ -0,0 +1,103 @@
+// XXH64 content hashing.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "content-hash.h"
+
+#include <bit>
+#include <cstring>
+
+
+namespace kfs
+{
+
+
+namespace
+{
+
+	constexpr uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+	constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+	constexpr uint64_t prime3 = 0x165667B19E3779F9ULL;
+	constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+	constexpr uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+	// The hash is defined over little-endian words.
+	template<typename Word>
+	Word read_le(const char* at) noexcept
+	{
+		Word word;
+		std::memcpy(&word, at, sizeof(word));
+		if constexpr (std::endian::native == std::endian::big)
+		{
+			Word swapped = 0;
+			for (size_t i = 0; i < sizeof(word); ++i, word >>= 8)
+				swapped = Word(swapped << 8) | (word & 0xff);
+			word = swapped;
+		}
+		return word;
+	}
+
+	constexpr uint64_t round(uint64_t accumulator, uint64_t input) noexcept
+	{
+		return std::rotl(accumulator + input * prime2, 31) * prime1;
+	}
+
+	constexpr uint64_t merge_round(uint64_t hash, uint64_t accumulator) noexcept
+	{
+		return (hash ^ round(0, accumulator)) * prime1 + prime4;
+	}
+
+}
+
+
+uint64_t content_hash(string_view data, uint64_t seed) noexcept
+{
+	const char* at = data.data();
+	const char* const end = at + data.size();
+
+	uint64_t hash;
+	if (data.size() >= 32)
+	{
+		uint64_t v1 = seed + prime1 + prime2;
+		uint64_t v2 = seed + prime2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - prime1;
+		for (; end - at >= 32; at += 32)
+		{
+			v1 = round(v1, read_le<uint64_t>(at));
+			v2 = round(v2, read_le<uint64_t>(at + 8));
+			v3 = round(v3, read_le<uint64_t>(at + 16));
+			v4 = round(v4, read_le<uint64_t>(at + 24));
+		}
+		hash = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+		hash = merge_round(hash, v1);
+		hash = merge_round(hash, v2);
+		hash = merge_round(hash, v3);
+		hash = merge_round(hash, v4);
+	}
+	else
+		hash = seed + prime5;
+	hash += data.size();
+
+	// The tail: whole words, then a half word, then bytes.
+	for (; end - at >= 8; at += 8)
+		hash = std::rotl(hash ^ round(0, read_le<uint64_t>(at)), 27) * prime1 + prime4;
+	if (end - at >= 4)
+	{
+		hash = std::rotl(hash ^ (read_le<uint32_t>(at) * prime1), 23) * prime2 + prime3;
+		at += 4;
+	}
+	for (; at < end; ++at)
+		hash = std::rotl(hash ^ (uint8_t(*at) * prime5), 11) * prime1;
+
+	hash ^= hash >> 33;
+	hash *= prime2;
+	hash ^= hash >> 29;
+	hash *= prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+
+}
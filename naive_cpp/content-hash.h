@@ -0,0 +1,32 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_CONTENT_HASH_H
+#define INCLUDED_KFS_NAIVE_CPP_CONTENT_HASH_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// A fast, non-cryptographic hash of a whole document, for recognizing content that
+// has been seen before (see app-parse-cache.h).
+//
+// This is XXH64, written out here rather than pulled in as a dependency: it reads
+// the input in 32-byte stripes across four independent accumulators, so it runs at
+// memory speed, far faster than the input could be scanned. Its output matches the
+// reference implementation's, so hashes can be checked with the xxhsum tool.
+
+
+#include "common.h"
+
+#include <cstdint>
+
+
+namespace kfs
+{
+
+
+//! Returns the XXH64 hash of 'data' with the given seed.
+[[nodiscard]]
+uint64_t content_hash(string_view data, uint64_t seed = 0) noexcept;
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_CONTENT_HASH_H
@@ -0,0 +1,54 @@
+// Unit tests for content hashing: the hash must match the reference XXH64, so that
+// values can be checked against other tools.
+
+#include "content-hash.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace kfs;
+
+
+TEST(ContentHashTest, ReferenceValues)
+{
+	EXPECT_EQ(0xEF46DB3751D8E999ULL, content_hash(""));
+	EXPECT_EQ(0xD24EC4F1A98C6E5BULL, content_hash("a"));
+	EXPECT_EQ(0x44BC2CF5AD770999ULL, content_hash("abc"));
+	// Long enough for the striped loop, with a tail of words and bytes.
+	EXPECT_EQ(0xFBCEA83C8A378BF1ULL, content_hash("Nobody inspects the spammish repetition"));
+}
+
+
+TEST(ContentHashTest, SeedChangesHash)
+{
+	EXPECT_NE(content_hash("enum E { A }", 0), content_hash("enum E { A }", 1));
+	EXPECT_EQ(content_hash("enum E { A }", 7), content_hash("enum E { A }", 7));
+}
+
+
+TEST(ContentHashTest, EveryByteCounts)
+{
+	// Flipping any byte, at every length through the stripe and tail paths, changes
+	// the hash.
+	std::string text;
+	for (size_t length = 1; length <= 100; ++length)
+	{
+		text.push_back(char('a' + length % 26));
+		const uint64_t hash = content_hash(text);
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			std::string changed = text;
+			changed[i] ^= 1;
+			EXPECT_NE(hash, content_hash(changed)) << "length " << length << ", byte " << i;
+		}
+	}
+}
+
+
+TEST(ContentHashTest, UnalignedInput)
+{
+	const std::string text = "xtype T { int x = 1, string s = \"a string\" } enum E { A, B }";
+	const std::string copy = text.substr(1);
+	EXPECT_EQ(content_hash(copy), content_hash(string_view(text).substr(1)));
+}
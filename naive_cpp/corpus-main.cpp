@@ -0,0 +1,166 @@
+/*
+ * ParseLand :: naive_cpp :: corpus generator
+ * Copyright (C) Oliver 'kfsone' Smith <oliver@kfs.org> 2024, under MIT license.
+ *
+ * Writes a synthetic ParseLand document of a given size, for scale testing and
+ * benchmarking; the same options and seed always produce the same document.
+ *
+ * Usage: corpus-naive_cpp [options] -- see usage() below.
+ */
+
+#include "corpus.h"
+
+#include <fmt/core.h>
+
+#include <charconv>
+#include <cstdio>
+#include <optional>
+#include <string_view>
+
+
+using namespace std::string_view_literals;
+
+
+static void usage(std::string_view program)
+{
+    fmt::print(stderr,
+               "usage: {} [options]\n"
+               "\n"
+               "Writes a deterministic, synthetic ParseLand document.\n"
+               "\n"
+               "options:\n"
+               "  --output=FILE             where to write the document (default: stdout)\n"
+               "  --size=N[K|M|G]           approximate size of the document (default: 1M)\n"
+               "  --seed=N                  random seed (default: 1)\n"
+               "  --enum-width=MIN:MAX      members per enum (default: 1:12)\n"
+               "  --members=MIN:MAX         fields per type (default: 0:10)\n"
+               "  --inheritance=N           longest chain of parent types (default: 4)\n"
+               "  --nesting=N               deepest compound default (default: 3)\n"
+               "  --strings=MIN:MAX         length of string defaults (default: 0:40)\n"
+               "  --defaults=P              chance of a field having a default (default: 0.5)\n"
+               "  --comments=P              chance of a comment before each definition or field (default: 0.2)\n"
+               "  --enums=P                 chance of a definition being an enum (default: 0.3)\n"
+               "  --broken=P                chance of a definition containing an error (default: 0)\n",
+               program);
+}
+
+
+// Parses an unsigned number with an optional K/M/G suffix.
+static bool parse_size(std::string_view text, size_t& out)
+{
+    size_t multiplier = 1;
+    if (!text.empty())
+    {
+        switch (text.back())
+        {
+        case 'k': case 'K': multiplier = size_t(1) << 10; break;
+        case 'm': case 'M': multiplier = size_t(1) << 20; break;
+        case 'g': case 'G': multiplier = size_t(1) << 30; break;
+        default: break;
+        }
+        if (multiplier != 1)
+            text.remove_suffix(1);
+    }
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    out *= multiplier;
+    return ec == std::errc{} && end == text.data() + text.size();
+}
+
+
+static bool parse_range(std::string_view text, kfs::CorpusRange& out)
+{
+    const auto colon = text.find(':');
+    if (colon == text.npos)
+        return false;
+    return parse_size(text.substr(0, colon), out.min_) && parse_size(text.substr(colon + 1), out.max_) && out.min_ <= out.max_;
+}
+
+
+static bool parse_probability(std::string_view text, double& out)
+{
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc{} && end == text.data() + text.size() && out >= 0 && out <= 1;
+}
+
+
+int main(int argc, const char* argv[])
+{
+    kfs::CorpusOptions options;
+    std::string_view output;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        const auto eq = arg.find('=');
+        const std::string_view name = arg.substr(0, eq);
+        const std::string_view value = eq == arg.npos ? std::string_view{} : arg.substr(eq + 1);
+
+        bool ok = eq != arg.npos;
+        if (name == "--output")
+            output = value;
+        else if (name == "--size")
+            ok = ok && parse_size(value, options.target_size_);
+        else if (name == "--seed")
+        {
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), options.seed_);
+            ok = ok && ec == std::errc{} && end == value.data() + value.size();
+        }
+        else if (name == "--enum-width")
+            ok = ok && parse_range(value, options.enum_width_) && options.enum_width_.min_ > 0;
+        else if (name == "--members")
+            ok = ok && parse_range(value, options.type_members_);
+        else if (name == "--inheritance")
+            ok = ok && parse_size(value, options.inheritance_depth_) && options.inheritance_depth_ > 0;
+        else if (name == "--nesting")
+            ok = ok && parse_size(value, options.nesting_depth_);
+        else if (name == "--strings")
+            ok = ok && parse_range(value, options.string_length_);
+        else if (name == "--defaults")
+            ok = ok && parse_probability(value, options.default_rate_);
+        else if (name == "--comments")
+            ok = ok && parse_probability(value, options.comment_density_);
+        else if (name == "--enums")
+            ok = ok && parse_probability(value, options.enum_rate_);
+        else if (name == "--broken")
+            ok = ok && parse_probability(value, options.broken_rate_);
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            if (arg != "--help" && arg != "-h")
+                fmt::print(stderr, "invalid option: {}\n", arg);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::FILE* file = stdout;
+    if (!output.empty())
+    {
+        file = std::fopen(std::string(output).c_str(), "wb");
+        if (file == nullptr)
+        {
+            fmt::print(stderr, "{}: can't open for writing\n", output);
+            return 2;
+        }
+    }
+
+    kfs::CorpusGenerator generator(options);
+    const size_t written = generator.generate([file](std::string_view chunk) {
+        return std::fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+    });
+
+    const bool failed = std::ferror(file) != 0;
+    if (file != stdout)
+        std::fclose(file);
+    if (failed)
+    {
+        fmt::print(stderr, "error writing the document\n");
+        return 2;
+    }
+
+    fmt::print(stderr, "wrote {} bytes: {} definitions, {} broken, seed {}\n",
+               written, generator.definition_count(), generator.broken_count(), options.seed_);
+    return 0;
+}
@@ -0,0 +1,469 @@
+// Synthetic ParseLand documents.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "corpus.h"
+
+#include <algorithm>
+
+
+namespace kfs
+{
+
+
+namespace
+{
+
+	// Names are built from syllables, so they look vaguely like words; none of the
+	// combinations spell a keyword, and names carry a number to make them unique.
+	constexpr string_view syllables[] = {
+		"ka", "lo", "mi", "ren", "dor", "vel", "an", "tis", "gru", "bel", "zo", "qua",
+		"nim", "sar", "pe", "hol", "wic", "jun", "ost", "ley", "cra", "fin", "mo", "da",
+	};
+
+	// Words for comments.
+	constexpr string_view comment_words[] = {
+		"the", "value", "of", "this", "field", "is", "used", "when", "no", "other", "setting",
+		"applies", "see", "also", "note", "deprecated", "for", "compatibility", "with", "v2",
+	};
+
+	// Types that fields can have without referring to a definition.
+	constexpr string_view builtin_types[] = { "int", "float", "string", "bool" };
+
+	// splitmix64, for deriving reproducible bits from ids.
+	constexpr uint64_t mix(uint64_t x) noexcept
+	{
+		x += 0x9E3779B97F4A7C15ULL;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+
+	void append_number(std::string& out, uint64_t value)
+	{
+		out += std::to_string(value);
+	}
+
+}
+
+
+CorpusGenerator::CorpusGenerator(const CorpusOptions& options)
+	: options_(options)
+	, rng_(options.seed_)
+{
+	options_.enum_width_.min_ = std::max<size_t>(options_.enum_width_.min_, 1);
+	options_.enum_width_.max_ = std::max(options_.enum_width_.max_, options_.enum_width_.min_);
+	options_.type_members_.max_ = std::max(options_.type_members_.max_, options_.type_members_.min_);
+	options_.string_length_.max_ = std::max(options_.string_length_.max_, options_.string_length_.min_);
+	options_.inheritance_depth_ = std::max<size_t>(options_.inheritance_depth_, 1);
+}
+
+
+size_t CorpusGenerator::uniform(size_t min, size_t max)
+{
+	return min + size_t(rng_() % (uint64_t(max - min) + 1));
+}
+
+
+bool CorpusGenerator::chance(double probability)
+{
+	// 53 random bits as a double in [0, 1).
+	return double(rng_() >> 11) * 0x1.0p-53 < probability;
+}
+
+
+// One to three syllables, taken from 'bits'.
+void CorpusGenerator::word(std::string& out, uint64_t bits)
+{
+	const size_t count = 1 + size_t(bits % 3);
+	bits /= 3;
+	for (size_t i = 0; i < count; ++i)
+	{
+		out += syllables[bits % std::size(syllables)];
+		bits /= std::size(syllables);
+	}
+}
+
+
+void CorpusGenerator::name(std::string& out, string_view prefix, uint64_t id)
+{
+	out += prefix;
+	const size_t start = out.size();
+	word(out, mix(id));
+	out[start] = char(out[start] - 'a' + 'A');
+	append_number(out, id);
+}
+
+
+// Member names are derived from the enum's id so that references can be made
+// without remembering them.
+void CorpusGenerator::member_name(std::string& out, uint64_t enum_id, size_t index)
+{
+	const size_t start = out.size();
+	word(out, mix(enum_id * 1024 + index));
+	for (size_t i = start; i < out.size(); ++i)
+		out[i] = char(out[i] - 'a' + 'A');
+	out += '_';
+	append_number(out, index);
+}
+
+
+void CorpusGenerator::comment(std::string& out, string_view indent)
+{
+	const bool block = chance(0.3);
+	out += indent;
+	out += block ? "/*" : "//";
+	const size_t words = uniform(2, 12);
+	for (size_t i = 0; i < words; ++i)
+	{
+		out += ' ';
+		out += comment_words[uniform(0, std::size(comment_words) - 1)];
+		// Block comments nest.
+		if (block && i == words / 2 && chance(0.1))
+			out += " /* nested */";
+	}
+	out += block ? " */\n" : "\n";
+}
+
+
+void CorpusGenerator::string_literal(std::string& out)
+{
+	out += '"';
+	const size_t length = uniform(options_.string_length_);
+	for (size_t i = 0; i < length; ++i)
+	{
+		const size_t pick = uniform(0, 99);
+		if (pick < 2)
+			out += "\\\"";
+		else if (pick < 3)
+			out += "\\\\";
+		else if (pick < 15)
+			out += ' ';
+		else
+			out += char('a' + pick % 26);
+	}
+	out += '"';
+}
+
+
+void CorpusGenerator::scalar(std::string& out)
+{
+	switch (uniform(0, 5))
+	{
+	case 0:
+		if (chance(0.2))
+			out += '-';
+		append_number(out, uniform(0, 1000000000));
+		break;
+	case 1:
+		append_number(out, uniform(0, 100000));
+		out += '.';
+		append_number(out, uniform(0, 999));
+		break;
+	case 2:
+		out += chance(0.5) ? "true" : "false";
+		break;
+	case 3:
+		if (!enums_.empty())
+		{
+			const EnumInfo& info = enums_[uniform(0, enums_.size() - 1)];
+			name(out, "E", info.id_);
+			out += "::";
+			member_name(out, info.id_, uniform(0, info.width_ - 1));
+			break;
+		}
+		[[fallthrough]];
+	default:
+		string_literal(out);
+		break;
+	}
+}
+
+
+// An object: field-value pairs, whose values may themselves be compounds.
+void CorpusGenerator::object(std::string& out, size_t depth)
+{
+	const size_t fields = uniform(0, 4);
+	if (fields == 0)
+	{
+		out += "{}";
+		return;
+	}
+	out += "{ ";
+	for (size_t i = 0; i < fields; ++i)
+	{
+		if (i > 0)
+			out += ", ";
+		word(out, rng_());
+		append_number(out, i);
+		out += " = ";
+		if (depth > 1 && chance(0.3))
+		{
+			if (chance(0.5))
+				object(out, depth - 1);
+			else
+				array(out, depth - 1);
+		}
+		else
+			scalar(out);
+	}
+	out += " }";
+}
+
+
+// An array: a list of objects.
+void CorpusGenerator::array(std::string& out, size_t depth)
+{
+	const size_t elements = uniform(0, 3);
+	if (elements == 0 || depth == 0)
+	{
+		out += "{}";
+		return;
+	}
+	out += "{ ";
+	for (size_t i = 0; i < elements; ++i)
+	{
+		if (i > 0)
+			out += ", ";
+		object(out, depth - 1);
+	}
+	out += " }";
+}
+
+
+void CorpusGenerator::enum_definition(std::string& out, bool broken)
+{
+	const uint64_t id = next_id_++;
+	const size_t width = uniform(options_.enum_width_);
+	const bool one_line = width <= 4;
+
+	out += "enum ";
+	name(out, "E", id);
+	out += one_line ? " { " : " {\n";
+
+	// The ways an enum can be broken.
+	const size_t breakage = broken ? uniform(0, 2) : SIZE_MAX;
+	for (size_t i = 0; i < width; ++i)
+	{
+		if (!one_line)
+			out += "    ";
+		member_name(out, id, i);
+		out += one_line ? ", " : ",\n";
+	}
+	if (breakage == 0)
+	{
+		// Duplicate member.
+		member_name(out, id, 0);
+		out += ' ';
+	}
+	else if (breakage == 1)
+		out += "~ ";
+
+	// Missing close brace.
+	if (breakage != 2)
+		out += "}\n\n";
+	else
+		out += "\n\n";
+
+	enums_.push_back(EnumInfo{ id, width });
+	if (enums_.size() > window_size)
+		enums_.pop_front();
+}
+
+
+void CorpusGenerator::type_definition(std::string& out, bool broken)
+{
+	const uint64_t id = next_id_++;
+
+	// Choose a parent that leaves room in the inheritance chain.
+	size_t depth = 1;
+	std::string parent;
+	if (!types_.empty() && chance(0.5))
+	{
+		const TypeInfo& candidate = types_[uniform(0, types_.size() - 1)];
+		if (candidate.depth_ < options_.inheritance_depth_)
+		{
+			name(parent, "T", candidate.id_);
+			depth = candidate.depth_ + 1;
+		}
+	}
+
+	const size_t breakage = broken ? uniform(0, 1) : SIZE_MAX;
+	out += "type ";
+	name(out, "T", id);
+	if (breakage == 0)
+	{
+		// Its own parent.
+		out += " : ";
+		name(out, "T", id);
+	}
+	else if (!parent.empty())
+	{
+		out += " : ";
+		out += parent;
+	}
+	out += " {\n";
+
+	const size_t members = uniform(options_.type_members_);
+	// If this definition is broken in a field, pick which one.
+	const size_t broken_field = breakage == 1 ? uniform(0, members) : SIZE_MAX;
+	for (size_t i = 0; i <= members; ++i)
+	{
+		if (i == broken_field)
+			field(out, true);
+		else if (i < members)
+			field(out, false);
+	}
+	out += "}\n\n";
+
+	types_.push_back(TypeInfo{ id, depth });
+	if (types_.size() > window_size)
+		types_.pop_front();
+}
+
+
+void CorpusGenerator::field(std::string& out, bool broken)
+{
+	if (chance(options_.comment_density_))
+		comment(out, "    ");
+
+	out += "    ";
+	// Fields are of a builtin type, an enum or a type.
+	enum { Builtin, Enum, Type } kind = Builtin;
+	const size_t pick = uniform(0, 9);
+	if (pick >= 6 && pick < 8 && !enums_.empty())
+		kind = Enum;
+	else if (pick >= 8 && !types_.empty())
+		kind = Type;
+
+	size_t builtin = 0;
+	EnumInfo enum_ref {};
+	switch (kind)
+	{
+	case Builtin:
+		builtin = uniform(0, std::size(builtin_types) - 1);
+		out += builtin_types[builtin];
+		break;
+	case Enum:
+		enum_ref = enums_[uniform(0, enums_.size() - 1)];
+		name(out, "E", enum_ref.id_);
+		break;
+	case Type:
+		name(out, "T", types_[uniform(0, types_.size() - 1)].id_);
+		break;
+	}
+
+	out += ' ';
+	word(out, rng_());
+	append_number(out, next_id_++);
+	const bool is_array = chance(kind == Type ? 0.5 : 0.1);
+	if (is_array)
+		out += "[]";
+
+	if (broken)
+	{
+		// The ways a field can be broken.
+		switch (uniform(0, 3))
+		{
+		case 0: out += " = \"unterminated\n"; return;
+		case 1: out += " @\n"; return;
+		case 2: out += " = { {}, 1 }\n"; return;
+		default: out += " = }\n"; return;
+		}
+	}
+
+	if (chance(options_.default_rate_))
+	{
+		out += " = ";
+		if (is_array)
+			array(out, options_.nesting_depth_);
+		else if (kind == Type)
+			object(out, options_.nesting_depth_);
+		else if (kind == Enum)
+		{
+			name(out, "E", enum_ref.id_);
+			out += "::";
+			member_name(out, enum_ref.id_, uniform(0, enum_ref.width_ - 1));
+		}
+		else
+		{
+			switch (builtin)
+			{
+			case 0:
+				if (chance(0.2))
+					out += '-';
+				append_number(out, uniform(0, 1000000));
+				break;
+			case 1:
+				if (chance(0.1))
+					out += "-";
+				append_number(out, uniform(0, 1000));
+				out += '.';
+				append_number(out, uniform(0, 99999));
+				break;
+			case 2:
+				string_literal(out);
+				break;
+			default:
+				out += chance(0.5) ? "true" : "false";
+				break;
+			}
+		}
+	}
+	out += chance(0.5) ? ",\n" : "\n";
+}
+
+
+void CorpusGenerator::next_definition(std::string& out)
+{
+	if (chance(options_.comment_density_))
+		comment(out, "");
+
+	const bool broken = chance(options_.broken_rate_);
+	if (chance(options_.enum_rate_))
+		enum_definition(out, broken);
+	else
+		type_definition(out, broken);
+
+	++definitions_;
+	broken_ += broken ? 1 : 0;
+}
+
+
+size_t CorpusGenerator::generate(const std::function<bool(string_view)>& sink, size_t chunk_size)
+{
+	std::string chunk;
+	chunk.reserve(chunk_size + 4096);
+	size_t written = 0;
+	while (written + chunk.size() < options_.target_size_)
+	{
+		next_definition(chunk);
+		if (chunk.size() >= chunk_size)
+		{
+			written += chunk.size();
+			if (!sink(chunk))
+				return written;
+			chunk.clear();
+		}
+	}
+	if (!chunk.empty())
+	{
+		written += chunk.size();
+		sink(chunk);
+	}
+	return written;
+}
+
+
+std::string generate_corpus(const CorpusOptions& options)
+{
+	std::string text;
+	text.reserve(options.target_size_ + 4096);
+	CorpusGenerator generator(options);
+	generator.generate([&text](string_view chunk) { text += chunk; return true; });
+	return text;
+}
+
+
+}
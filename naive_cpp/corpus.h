@@ -0,0 +1,128 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_CORPUS_H
+#define INCLUDED_KFS_NAIVE_CPP_CORPUS_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Synthetic ParseLand documents, for testing and benchmarking at scale.
+//
+// The generator writes enums and types with tunable shapes - enum widths, member
+// counts, inheritance depth, nesting of compound defaults, comment density and
+// string lengths - and can deliberately break a proportion of the definitions.
+// Output depends only on the options and the seed: the random numbers come from
+// mt19937_64, whose sequence is specified by the standard, reduced to ranges by
+// our own arithmetic rather than the (implementation-defined) std distributions.
+//
+// Documents are produced a definition at a time and handed over in chunks, and the
+// generator only remembers a bounded window of earlier definitions to refer to, so
+// memory use doesn't grow with the size of the document.
+
+
+#include "common.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <random>
+#include <string>
+
+
+namespace kfs
+{
+
+
+//! An inclusive range of sizes to choose from.
+struct CorpusRange
+{
+	size_t	min_	{0};
+	size_t	max_	{0};
+};
+
+
+struct CorpusOptions
+{
+	uint64_t	seed_				{1};
+	size_t		target_size_		{1024 * 1024};	// Stop after the definition that reaches this.
+	CorpusRange	enum_width_			{1, 12};		// Members per enum.
+	CorpusRange	type_members_		{0, 10};		// Fields per type.
+	size_t		inheritance_depth_	{4};			// Longest chain of parent types.
+	size_t		nesting_depth_		{3};			// Deepest compound default.
+	CorpusRange	string_length_		{0, 40};		// Characters in string defaults.
+	double		default_rate_		{0.5};			// Chance that a field has a default.
+	double		comment_density_	{0.2};			// Chance of a comment before each definition or field.
+	double		enum_rate_			{0.3};			// Chance that a definition is an enum.
+	double		broken_rate_		{0.0};			// Chance that a definition contains an error.
+};
+
+
+struct CorpusGenerator
+{
+public:
+	explicit CorpusGenerator(const CorpusOptions& options);
+
+	//! Appends the next definition, with any comments that precede it, to 'out'.
+	void next_definition(std::string& out);
+
+	//! Generates definitions until the target size is reached, handing them to 'sink'
+	//! in chunks of about 'chunk_size' bytes; stops early if 'sink' returns false.
+	//! Returns the number of bytes generated.
+	size_t generate(const std::function<bool(string_view)>& sink, size_t chunk_size = 1024 * 1024);
+
+	//! Number of definitions generated so far, and how many of them were broken.
+	[[nodiscard]]
+	size_t definition_count() const noexcept { return definitions_; }
+	[[nodiscard]]
+	size_t broken_count() const noexcept { return broken_; }
+
+protected:
+	struct EnumInfo
+	{
+		uint64_t	id_;
+		size_t		width_;
+	};
+	struct TypeInfo
+	{
+		uint64_t	id_;
+		size_t		depth_;		// 1 for a type without a parent.
+	};
+
+	// How many earlier definitions we remember to refer to.
+	static constexpr size_t window_size = 256;
+
+	CorpusOptions			options_;
+	std::mt19937_64			rng_;
+	std::deque<EnumInfo>	enums_		{ };
+	std::deque<TypeInfo>	types_		{ };
+	uint64_t				next_id_	{0};
+	size_t					definitions_{0};
+	size_t					broken_		{0};
+
+	// Random number helpers.
+	size_t uniform(size_t min, size_t max);
+	size_t uniform(const CorpusRange& range) { return uniform(range.min_, range.max_); }
+	bool chance(double probability);
+
+	// Pieces of text.
+	void word(std::string& out, uint64_t bits);
+	void name(std::string& out, string_view prefix, uint64_t id);
+	void member_name(std::string& out, uint64_t enum_id, size_t index);
+	void comment(std::string& out, string_view indent);
+	void string_literal(std::string& out);
+	void scalar(std::string& out);
+	void object(std::string& out, size_t depth);
+	void array(std::string& out, size_t depth);
+
+	void enum_definition(std::string& out, bool broken);
+	void type_definition(std::string& out, bool broken);
+	void field(std::string& out, bool broken);
+};
+
+
+//! Generates a whole document in memory.
+[[nodiscard]]
+std::string generate_corpus(const CorpusOptions& options);
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_CORPUS_H
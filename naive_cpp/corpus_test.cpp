@@ -0,0 +1,121 @@
+// Unit tests for the corpus generator: its documents must be reproducible, the
+// requested size, and valid unless asked to be broken.
+
+#include "corpus.h"
+#include "scanner.h"
+
+#include "app-ast.h"
+#include "app-tokensequence.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace kfs;
+
+
+namespace
+{
+
+// Scans and parses a document, returning the number of definitions, or nullopt
+// at the first error.
+std::optional<size_t> parse(string_view source)
+{
+	Scanner scanner(source);
+	TokenBuffer tokens(source);
+	for (;;)
+	{
+		const auto batch = scanner.next_batch(tokens, 4096);
+		if (batch.is_error())
+			return std::nullopt;
+		if (batch.count_ < 4096)
+			break;
+	}
+
+	AST ast;
+	TokenSequence sequence{ tokens, ast.symbols_ };
+	for (;;)
+	{
+		auto result = ast.next(sequence);
+		if (result.is_error())
+			return std::nullopt;
+		if (result.is_none())
+			return ast.nodes_.size();
+	}
+}
+
+}
+
+
+TEST(CorpusTest, Deterministic)
+{
+	CorpusOptions options;
+	options.target_size_ = 64 * 1024;
+	const std::string first = generate_corpus(options);
+	EXPECT_EQ(first, generate_corpus(options));
+
+	options.seed_ = 2;
+	EXPECT_NE(first, generate_corpus(options));
+}
+
+
+TEST(CorpusTest, Size)
+{
+	CorpusOptions options;
+	for (size_t size : { size_t(1), size_t(1000), size_t(100 * 1000) })
+	{
+		options.target_size_ = size;
+		const std::string text = generate_corpus(options);
+		EXPECT_GE(text.size(), size);
+		// Overshooting by more than a definition would be a bug.
+		EXPECT_LT(text.size(), size + 4096);
+	}
+}
+
+
+// Chunked output must be the same document as generating it whole.
+TEST(CorpusTest, Chunks)
+{
+	CorpusOptions options;
+	options.target_size_ = 200 * 1000;
+	std::string chunked;
+	size_t chunks = 0;
+	CorpusGenerator generator(options);
+	const size_t written = generator.generate([&](string_view chunk) { chunked += chunk; ++chunks; return true; }, 16 * 1024);
+	EXPECT_EQ(written, chunked.size());
+	EXPECT_GT(chunks, 10);
+	EXPECT_EQ(generate_corpus(options), chunked);
+}
+
+
+TEST(CorpusTest, Valid)
+{
+	for (uint64_t seed = 1; seed <= 8; ++seed)
+	{
+		CorpusOptions options;
+		options.seed_ = seed;
+		options.target_size_ = 128 * 1024;
+		options.comment_density_ = 0.5;
+		options.nesting_depth_ = 5;
+		CorpusGenerator generator(options);
+		std::string text;
+		generator.generate([&text](string_view chunk) { text += chunk; return true; });
+		EXPECT_EQ(0, generator.broken_count());
+		EXPECT_EQ(generator.definition_count(), parse(text)) << "seed " << seed;
+	}
+}
+
+
+// Every broken definition must actually be an error.
+TEST(CorpusTest, Broken)
+{
+	CorpusOptions options;
+	options.broken_rate_ = 1.0;
+	for (uint64_t seed = 1; seed <= 64; ++seed)
+	{
+		options.seed_ = seed;
+		options.target_size_ = 1;
+		const std::string text = generate_corpus(options);
+		EXPECT_EQ(std::nullopt, parse(text)) << text;
+	}
+}
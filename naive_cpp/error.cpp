@@ -0,0 +1,87 @@
+// Descriptions of error codes.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "error.h"
+
+#include <array>
+
+
+namespace kfs
+{
+
+using namespace std::string_view_literals;
+
+
+namespace
+{
+
+constexpr std::array<string_view, size_t(ErrorCode::Count)> kMessages
+{
+	"no error"sv,
+
+	"unexpected character"sv,
+	"unterminated string"sv,
+	"unterminated block comment"sv,
+	"token exceeds packed token limits"sv,
+	"document exceeds packed token offsets (4GiB)"sv,
+	"integer literal out of range"sv,
+	"float literal out of range"sv,
+
+	"unexpected end of input"sv,
+	"unexpected token at top-level, expecting keywords 'enum' or 'type'"sv,
+	"unmatched close-brace at top-level, did you add too many }s?"sv,
+	"redefinition"sv,
+	"expected enum name after 'enum' keyword"sv,
+	"expected type name after 'type' keyword"sv,
+	"expected parent type name after ':'"sv,
+	"type cannot have itself as a parent"sv,
+	"expected ':' or '{' after type name"sv,
+	"expected open brace ('{')"sv,
+	"expected member name (identifier), or '}'"sv,
+	"enums must have *at least* one member"sv,
+	"duplicate member"sv,
+	"invalid member name, names need at least one character other than '_'"sv,
+	"expected field type name, or '}'"sv,
+	"expected member name after field type name"sv,
+	"expecting close bracket (']') after open bracket ('['). arrays are dynamic and cannot have a fixed size."sv,
+	"expected a string, number, boolean, enum::label, array, or object"sv,
+	"expected a scalar value"sv,
+	"expected a compound value"sv,
+	"invalid compound mixes types"sv,
+	"expected object or array of objects"sv,
+	"expected equals ('=') after field name"sv,
+	"expected scope operator ('::') after enum class name"sv,
+	"expected enum member name after scope operator ('::')"sv,
+
+	"cannot open file"sv,
+	"cannot map file"sv,
+	"cannot read file"sv,
+};
+
+}
+
+
+string_view error_message(ErrorCode code) noexcept
+{
+	if (code >= ErrorCode::Count)
+		return "<invalid error code>"sv;
+	return kMessages[size_t(code)];
+}
+
+
+std::string describe_error(ErrorCode code, const Token& span)
+{
+	std::string message { error_message(code) };
+	if (!span.source_.empty())
+	{
+		message += ": '";
+		message += span.source_;
+		message += "'";
+	}
+	return message;
+}
+
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_ERROR_H
+#define INCLUDED_KFS_NAIVE_CPP_ERROR_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Error codes for the scanner, parser and file handling.
+//
+// Results carry a one-byte ErrorCode and the span (token) the error relates to, rather
+// than a formatted message, so that failing doesn't allocate: the text for a code is
+// a static string, and a full message including the offending text is only built
+// when someone asks for one.
+
+
+#include "common.h"
+#include "token.h"
+
+#include <cstdint>
+#include <string>
+
+
+namespace kfs
+{
+
+
+//! Identifies what went wrong; the span of a Result or TResult says where.
+enum class ErrorCode : uint8_t
+{
+	None,
+
+	// Scanner.
+	UnexpectedCharacter,
+	UnterminatedString,
+	UnterminatedComment,
+	TokenTooLong,
+	DocumentTooLarge,
+	IntegerOutOfRange,
+	FloatOutOfRange,
+
+	// Parser.
+	UnexpectedEndOfInput,
+	ExpectedDefinition,
+	UnmatchedCloseBrace,
+	Redefinition,
+	ExpectedEnumName,
+	ExpectedTypeName,
+	ExpectedParentName,
+	SelfParent,
+	ExpectedColonOrBrace,
+	ExpectedOpenBrace,
+	ExpectedEnumMember,
+	EmptyEnum,
+	DuplicateMember,
+	InvalidMemberName,
+	ExpectedFieldType,
+	ExpectedMemberName,
+	FixedSizeArray,
+	ExpectedValue,
+	ExpectedScalar,
+	ExpectedCompound,
+	MixedCompound,
+	ExpectedObjectArray,
+	ExpectedFieldEquals,
+	ExpectedScope,
+	ExpectedEnumValueName,
+
+	// Files; the result's error_number() holds the errno value.
+	FileOpenFailed,
+	FileMapFailed,
+	FileReadFailed,
+
+	Count
+};
+
+
+//! Returns the static description of an error code.
+[[nodiscard]]
+string_view error_message(ErrorCode code) noexcept;
+
+//! Builds the full message for an error: the description, followed by the text of
+//! the span it relates to, if there is one.
+[[nodiscard]]
+std::string describe_error(ErrorCode code, const Token& span);
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_ERROR_H
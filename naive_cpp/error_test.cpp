@@ -0,0 +1,98 @@
+// Unit tests for error codes and the results that carry them.
+
+#include "error.h"
+#include "result.h"
+#include "tresult.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <type_traits>
+
+using namespace kfs;
+
+
+TEST(ErrorTest, EveryCodeHasAMessage)
+{
+	EXPECT_EQ("no error", error_message(ErrorCode::None));
+	for (size_t code = 1; code < size_t(ErrorCode::Count); ++code)
+	{
+		EXPECT_FALSE(error_message(ErrorCode(code)).empty()) << code;
+		EXPECT_NE(error_message(ErrorCode(code - 1)), error_message(ErrorCode(code))) << code;
+	}
+	EXPECT_EQ("<invalid error code>", error_message(ErrorCode::Count));
+}
+
+
+TEST(ErrorTest, DescribeError)
+{
+	EXPECT_EQ("unexpected end of input", describe_error(ErrorCode::UnexpectedEndOfInput, Token{}));
+	EXPECT_EQ("duplicate member: 'x'", describe_error(ErrorCode::DuplicateMember, Token{ Token::Type::Word, "x" }));
+}
+
+
+TEST(ErrorTest, TResultIsCompact)
+{
+	static_assert(sizeof(TResult) == 16);
+	static_assert(std::is_trivially_copyable_v<TResult>);
+
+	constexpr TResult none{};
+	EXPECT_TRUE(none.is_none());
+	EXPECT_FALSE(none.is_error());
+
+	const Token token{ Token::Type::String, "\"abc" };
+	const TResult error{ token, ErrorCode::UnterminatedString };
+	EXPECT_TRUE(error.is_error());
+	EXPECT_TRUE(error.has_token());
+	EXPECT_FALSE(error.is_token());
+	EXPECT_EQ(token, error.token());
+	EXPECT_EQ(ErrorCode::UnterminatedString, error.code());
+	EXPECT_EQ("unterminated string", error.error());
+	EXPECT_EQ("unterminated string: '\"abc'", error.message());
+}
+
+
+TEST(ErrorTest, TResultRefusesTokensTooLongToStore)
+{
+	if constexpr (sizeof(size_t) > sizeof(uint32_t))
+	{
+		// Nothing reads the text, so the view needn't be backed by real memory.
+		const char text[] = "x";
+		const Token huge{ Token::Type::String, string_view(text, TResult::max_length + 1) };
+		for (const TResult result : { TResult{ huge }, TResult{ huge, ErrorCode::UnterminatedString } })
+		{
+			EXPECT_TRUE(result.is_error());
+			EXPECT_EQ(ErrorCode::TokenTooLong, result.code());
+			EXPECT_EQ(text, result.token().source_.data());
+			EXPECT_EQ(TResult::max_length, result.token().source_.size());
+		}
+
+		// The longest token that fits is kept as it is.
+		const Token longest{ Token::Type::String, string_view(text, TResult::max_length) };
+		const TResult kept{ longest };
+		EXPECT_TRUE(kept.is_token());
+		EXPECT_EQ(text, kept.token().source_.data());
+		EXPECT_EQ(TResult::max_length, kept.token().source_.size());
+	}
+}
+
+
+TEST(ErrorTest, ResultForwardsErrors)
+{
+	static_assert(std::is_trivially_copyable_v<Result<Token>>);
+
+	const Token span{ Token::Type::Word, "Foo" };
+	const auto inner = Result<Token>::Err(ErrorCode::Redefinition, span);
+	const auto outer = Result<int>::Err(inner);
+	EXPECT_TRUE(outer.is_error());
+	EXPECT_FALSE(outer.has_value());
+	EXPECT_EQ(ErrorCode::Redefinition, outer.code());
+	EXPECT_EQ(span, outer.span());
+	EXPECT_EQ("redefinition", outer.error());
+	EXPECT_EQ("redefinition: 'Foo'", outer.message());
+
+	const auto value = Result<int>::Some(42);
+	EXPECT_TRUE(value.is_value());
+	EXPECT_EQ(ErrorCode::None, value.code());
+	EXPECT_EQ(42, value.value());
+}
@@ -0,0 +1,117 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_KEYWORD_H
+#define INCLUDED_KFS_NAIVE_CPP_KEYWORD_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Keyword classification.
+//
+// The scanner classifies words as it scans them, so the parser can dispatch on a
+// Keyword rather than comparing the text of every word against each keyword.
+//
+// Classification is a perfect hash: a hash of the word's length and its first two
+// and last characters picks a single slot in a small table, and one comparison
+// confirms it. The hash's seed is searched for at compile time, so adding a keyword
+// is just a matter of adding it to the enum and keyword_text; if no seed separates
+// them, the static_assert below fails.
+
+
+#include "common.h"
+
+#include <array>
+#include <cstdint>
+
+
+namespace kfs
+{
+
+
+//! Keyword enumerates the words with special meaning to the grammar.
+enum class Keyword : uint8_t
+{
+	None,
+	Enum,
+	Type,
+	True,
+	False,
+};
+
+//! The text of each keyword, indexed by Keyword.
+inline constexpr string_view keyword_text[] = { "", "enum", "type", "true", "false" };
+
+//! Keywords are stored in 4 bits of the token's flags.
+inline constexpr size_t max_keywords = 16;
+static_assert(std::size(keyword_text) <= max_keywords);
+
+
+namespace keyword_hash
+{
+
+	constexpr size_t table_bits = 4;
+	constexpr size_t table_size = size_t(1) << table_bits;
+
+	constexpr size_t max_length = []() {
+		size_t longest = 0;
+		for (string_view text : keyword_text)
+			longest = text.size() > longest ? text.size() : longest;
+		return longest;
+	}();
+
+	//! Hashes a non-empty word into a slot of the table.
+	constexpr size_t slot(string_view word, uint32_t seed) noexcept
+	{
+		uint32_t hash = seed;
+		hash = (hash ^ uint8_t(word.front())) * 0x01000193u;
+		hash = (hash ^ uint8_t(word[word.size() > 1 ? 1 : 0])) * 0x01000193u;
+		hash = (hash ^ uint8_t(word.back())) * 0x01000193u;
+		hash = (hash ^ uint32_t(word.size())) * 0x01000193u;
+		return hash >> (32 - table_bits);
+	}
+
+	//! Finds the first seed that puts every keyword in a different slot, or 0.
+	constexpr uint32_t find_seed() noexcept
+	{
+		for (uint32_t seed = 1; seed < 0x10000; ++seed)
+		{
+			bool used[table_size] {};
+			bool collided = false;
+			for (size_t i = 1; i < std::size(keyword_text) && !collided; ++i)
+			{
+				const size_t index = slot(keyword_text[i], seed);
+				collided = used[index];
+				used[index] = true;
+			}
+			if (!collided)
+				return seed;
+		}
+		return 0;
+	}
+
+	constexpr uint32_t seed = find_seed();
+	static_assert(seed != 0, "no perfect hash for the keywords: increase table_bits");
+
+	//! Keyword in each slot of the table, None for the unused ones.
+	constexpr std::array<Keyword, table_size> table = []() {
+		std::array<Keyword, table_size> slots {};
+		for (size_t i = 1; i < std::size(keyword_text); ++i)
+			slots[slot(keyword_text[i], seed)] = static_cast<Keyword>(i);
+		return slots;
+	}();
+
+}
+
+
+//! Returns the keyword that 'word' spells, or Keyword::None.
+[[nodiscard]]
+constexpr Keyword classify_keyword(string_view word) noexcept
+{
+	if (word.empty() || word.size() > keyword_hash::max_length)
+		return Keyword::None;
+	const Keyword candidate = keyword_hash::table[keyword_hash::slot(word, keyword_hash::seed)];
+	return keyword_text[static_cast<size_t>(candidate)] == word ? candidate : Keyword::None;
+}
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_KEYWORD_H
@@ -0,0 +1,59 @@
+// Unit tests for keyword classification.
+
+#include "keyword.h"
+#include "scanner.h"
+#include "token-buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace kfs;
+
+
+// The table is built at compile time, so it can be checked at compile time too.
+static_assert(classify_keyword("enum") == Keyword::Enum);
+static_assert(classify_keyword("false") == Keyword::False);
+static_assert(classify_keyword("enumeration") == Keyword::None);
+
+
+TEST(KeywordTest, Keywords)
+{
+	for (size_t i = 1; i < std::size(keyword_text); ++i)
+		EXPECT_EQ(static_cast<Keyword>(i), classify_keyword(keyword_text[i])) << keyword_text[i];
+}
+
+
+TEST(KeywordTest, NotKeywords)
+{
+	for (string_view word : { "", "e", "en", "enu", "Enum", "ENUM", "enums", "types", "tru", "True", "fals", "falsey", "efum", "tyle", "_", "xyzzy" })
+		EXPECT_EQ(Keyword::None, classify_keyword(word)) << word;
+
+	// Words matching a keyword's length, first two and last characters share its
+	// slot, so they are the ones the comparison has to reject.
+	for (string_view word : { "enzm", "tyze", "trze", "fazze" })
+		EXPECT_EQ(Keyword::None, classify_keyword(word)) << word;
+}
+
+
+TEST(KeywordTest, TokenFlags)
+{
+	const Token token { Token::Type::Word, "true", Token::keyword_flags(Keyword::True) };
+	EXPECT_EQ(Keyword::True, token.keyword());
+	EXPECT_FALSE(token.is_escaped());
+	EXPECT_EQ(Keyword::None, (Token{ Token::Type::String, "\"\\\"\"", Token::Escaped }).keyword());
+}
+
+
+TEST(KeywordTest, ScannerClassifiesWords)
+{
+	const string_view source = "enum type true false enumtype Type e \"enum\"";
+	const Keyword expected[] = { Keyword::Enum, Keyword::Type, Keyword::True, Keyword::False, Keyword::None, Keyword::None, Keyword::None, Keyword::None };
+
+	Scanner scanner(source);
+	TokenBuffer buffer(source);
+	ASSERT_FALSE(scanner.next_batch(buffer, 64).is_error());
+	ASSERT_EQ(std::size(expected), buffer.size());
+	for (size_t i = 0; i < buffer.size(); ++i)
+		EXPECT_EQ(expected[i], buffer.token(i).keyword()) << buffer.text(i);
+}
@@ -0,0 +1,99 @@
+// Lazily-built offset to line/column mapping.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "line-index.h"
+#include "scanner-simd.h"
+
+#include <algorithm>
+
+
+namespace kfs
+{
+
+
+// Find every newline with the vectorized byte search; there's always at least one
+// line, even in an empty document.
+void LineIndex::build() const
+{
+	line_starts_.clear();
+	line_starts_.push_back(0);
+
+	const char* data = source_.data();
+	const size_t len = source_.size();
+	for (size_t pos = simd::find_byte(data, len, '\n'); pos < len; )
+	{
+		line_starts_.push_back(pos + 1);
+		pos += 1 + simd::find_byte(data + pos + 1, len - pos - 1, '\n');
+	}
+}
+
+
+SourceLocation LineIndex::locate(size_t offset) const
+{
+	if (!is_built())
+		build();
+
+	offset = std::min(offset, source_.size());
+	// The last line start that is <= offset.
+	const auto it = std::upper_bound(line_starts_.begin(), line_starts_.end(), offset) - 1;
+	return SourceLocation{ size_t(it - line_starts_.begin()) + 1, offset - *it + 1 };
+}
+
+
+string_view LineIndex::line_text(size_t line) const
+{
+	if (!is_built())
+		build();
+
+	if (line == 0 || line > line_starts_.size())
+		return {};
+
+	const size_t begin = line_starts_[line - 1];
+	size_t end = (line < line_starts_.size()) ? line_starts_[line] - 1 : source_.size();
+	// Don't include the \r of a \r\n.
+	if (end > begin && source_[end - 1] == '\r')
+		--end;
+	return source_.substr(begin, end - begin);
+}
+
+
+size_t LineIndex::line_count() const
+{
+	if (!is_built())
+		build();
+
+	return line_starts_.size();
+}
+
+
+std::string render_diagnostic(const LineIndex& lines, string_view filename, size_t offset, size_t length, string_view message)
+{
+	const SourceLocation where = lines.locate(offset);
+	const string_view text = lines.line_text(where.line_);
+
+	std::string result;
+	result.append(filename).append(":")
+		  .append(std::to_string(where.line_)).append(":")
+		  .append(std::to_string(where.column_)).append(": error: ")
+		  .append(message).append("\n");
+
+	// Reproduce the line, then underline the span beneath it; tabs are kept in the
+	// padding so that the caret lines up however the line is displayed.
+	result.append("    ").append(text).append("\n    ");
+	const size_t column = std::min(where.column_ - 1, text.size());
+	for (size_t i = 0; i < column; ++i)
+		result += (text[i] == '\t') ? '\t' : ' ';
+	result += '^';
+	// Underline the rest of the span, but only as far as the end of the line.
+	const size_t underline = std::min(length, text.size() - column);
+	if (underline > 1)
+		result.append(underline - 1, '~');
+	result += '\n';
+
+	return result;
+}
+
+
+}
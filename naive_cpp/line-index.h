@@ -0,0 +1,85 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_LINE_INDEX_H
+#define INCLUDED_KFS_NAIVE_CPP_LINE_INDEX_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Offset to line/column mapping for a source document.
+//
+// Rather than have the scanner count lines as it goes, which it would have to do
+// for every token whether or not anyone ever asks, the LineIndex finds all of the
+// line starts the first time a location is requested, and then answers lookups by
+// binary search.
+
+
+#include "common.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace kfs
+{
+
+
+//! 1-based line and (byte) column of a position within a source document.
+struct SourceLocation
+{
+	size_t	line_	{0};
+	size_t	column_	{0};
+
+	bool operator == (const SourceLocation&) const noexcept = default;
+};
+
+
+//! Lazily-built index of the line starts in a source document.
+//
+// The source must outlive the index.
+//
+struct LineIndex
+{
+public:
+	LineIndex() = default;
+	explicit LineIndex(const string_view source) : source_(source) {}
+
+	//! Returns the line and column of the byte at 'offset'; offsets beyond the end
+	//! of the source are clamped to the end.
+	[[nodiscard]]
+	SourceLocation locate(size_t offset) const;
+
+	//! Returns the text of a 1-based line number, without its line terminator.
+	[[nodiscard]]
+	string_view line_text(size_t line) const;
+
+	//! Returns the number of lines in the source.
+	[[nodiscard]]
+	size_t line_count() const;
+
+	//! Returns true once the index has been built.
+	[[nodiscard]]
+	bool is_built() const noexcept { return !line_starts_.empty(); }
+
+protected:
+	// Populates line_starts_ on first use.
+	void build() const;
+
+	string_view					source_		 { };
+	mutable std::vector<size_t>	line_starts_ { };	// Offset of the first byte of each line.
+};
+
+
+//! Renders a diagnostic for the span [offset, offset+length) in a compiler-style
+//! format, with the offending line and a caret underlining the span:
+//!
+//!   file:3:14: error: unexpected character
+//!       enum X { ~ }
+//!                ^
+//
+[[nodiscard]]
+std::string render_diagnostic(const LineIndex& lines, string_view filename, size_t offset, size_t length, string_view message);
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_LINE_INDEX_H
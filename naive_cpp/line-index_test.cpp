@@ -0,0 +1,94 @@
+// Unit tests for the line index and diagnostic rendering.
+
+#include "line-index.h"
+#include "scanner.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace kfs;
+
+
+TEST(LineIndexTest, Empty)
+{
+	LineIndex lines("");
+	EXPECT_FALSE(lines.is_built());
+	EXPECT_EQ((SourceLocation{1, 1}), lines.locate(0));
+	EXPECT_TRUE(lines.is_built());
+	EXPECT_EQ(1, lines.line_count());
+	EXPECT_EQ("", lines.line_text(1));
+	EXPECT_EQ("", lines.line_text(0));
+	EXPECT_EQ("", lines.line_text(2));
+}
+
+
+TEST(LineIndexTest, Locate)
+{
+	const string_view source = "ab\ncd\r\n\nefg";
+	LineIndex lines(source);
+	EXPECT_EQ(4, lines.line_count());
+
+	EXPECT_EQ((SourceLocation{1, 1}), lines.locate(0));
+	EXPECT_EQ((SourceLocation{1, 2}), lines.locate(1));
+	EXPECT_EQ((SourceLocation{1, 3}), lines.locate(2));	// the newline itself
+	EXPECT_EQ((SourceLocation{2, 1}), lines.locate(3));
+	EXPECT_EQ((SourceLocation{2, 3}), lines.locate(5));	// \r
+	EXPECT_EQ((SourceLocation{3, 1}), lines.locate(7));
+	EXPECT_EQ((SourceLocation{4, 1}), lines.locate(8));
+	EXPECT_EQ((SourceLocation{4, 4}), lines.locate(11));	// end of input
+	EXPECT_EQ((SourceLocation{4, 4}), lines.locate(999));	// clamped
+
+	EXPECT_EQ("ab", lines.line_text(1));
+	EXPECT_EQ("cd", lines.line_text(2));
+	EXPECT_EQ("", lines.line_text(3));
+	EXPECT_EQ("efg", lines.line_text(4));
+}
+
+
+TEST(LineIndexTest, LongLines)
+{
+	// Lines longer than any vector width, with newlines at assorted alignments.
+	std::string source;
+	for (size_t line = 0; line < 50; ++line)
+		source += std::string(line * 7, 'x') + '\n';
+	LineIndex lines(source);
+	EXPECT_EQ(51, lines.line_count());
+
+	size_t offset = 0;
+	for (size_t line = 0; line < 50; ++line)
+	{
+		SCOPED_TRACE(line);
+		EXPECT_EQ((SourceLocation{line + 1, 1}), lines.locate(offset));
+		EXPECT_EQ(line * 7, lines.line_text(line + 1).size());
+		offset += line * 7 + 1;
+	}
+}
+
+
+TEST(LineIndexTest, ScannerTokenLocation)
+{
+	Scanner scanner("enum X {\n\tA,\n\tB ~\n}");
+	TResult result;
+	while ((result = scanner.next()).is_token())
+		;
+	ASSERT_TRUE(result.is_error());
+	EXPECT_EQ((SourceLocation{3, 4}), scanner.get_token_location(result.token()));
+	EXPECT_EQ(std::nullopt, scanner.get_token_location(Token{Token::Type::Word, "elsewhere"}));
+}
+
+
+TEST(LineIndexTest, RenderDiagnostic)
+{
+	LineIndex lines("type T {\n\tint x = ~~~\n}");
+	EXPECT_EQ("f.pl:2:10: error: unexpected character\n"
+			  "    \tint x = ~~~\n"
+			  "    \t        ^\n",
+			  render_diagnostic(lines, "f.pl", 18, 1, "unexpected character"));
+
+	// Spans are underlined, but not beyond the end of the line.
+	EXPECT_EQ("f.pl:1:6: error: bad name\n"
+			  "    type T {\n"
+			  "         ^~~\n",
+			  render_diagnostic(lines, "f.pl", 5, 100, "bad name"));
+}
@@ -0,0 +1,178 @@
+// Memory-mapped input files.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "mapped-source.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#	define KFS_HAVE_MMAP 1
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#else
+#	define KFS_HAVE_MMAP 0
+#endif
+
+
+namespace kfs
+{
+
+
+namespace
+{
+
+#if KFS_HAVE_MMAP
+// Fallback for inputs we can't map: read the whole thing from the descriptor that is
+// already open, rather than opening the path again, which for a FIFO would be a
+// second reader. Returns 0, or the errno value of the failed read.
+int read_into(int fd, size_t size_hint, std::string& buffer)
+{
+	constexpr size_t chunk = 64 * 1024;
+	buffer.clear();
+	buffer.reserve(size_hint);
+	for (;;)
+	{
+		const size_t used = buffer.size();
+		buffer.resize(used + std::max(chunk, buffer.capacity() - used));
+		const ssize_t got = ::read(fd, buffer.data() + used, buffer.size() - used);
+		if (got < 0 && errno == EINTR)
+		{
+			buffer.resize(used);
+			continue;
+		}
+		buffer.resize(used + size_t(std::max<ssize_t>(got, 0)));
+		if (got < 0)
+			return errno;
+		if (got == 0)
+			return 0;
+	}
+}
+#else
+// Fallback for platforms without mmap: read the whole thing into a string.
+bool read_into(const std::string& path, std::string& buffer)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	buffer = std::move(contents).str();
+	return !file.bad();
+}
+#endif
+
+}
+
+
+Result<MappedSource> MappedSource::open(const std::string& path, [[maybe_unused]] Options options)
+{
+	MappedSource source;
+	source.path_ = path;
+
+#if KFS_HAVE_MMAP
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return Result<MappedSource>::SystemErr(ErrorCode::FileOpenFailed, errno);
+
+	struct stat info {};
+	if (::fstat(fd, &info) != 0)
+	{
+		const int error_number = errno;
+		::close(fd);
+		return Result<MappedSource>::SystemErr(ErrorCode::FileOpenFailed, error_number);
+	}
+
+	// Only regular, non-empty files can be mapped; anything else, or a file that
+	// fails to map, gets read.
+	const bool regular = S_ISREG(info.st_mode);
+	if (options.map_ && regular && info.st_size > 0)
+	{
+		const auto size = static_cast<size_t>(info.st_size);
+		void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED)
+		{
+			// The mapping holds its own reference to the file.
+			::close(fd);
+
+			// These are only hints, so we don't care if they fail.
+			if (options.sequential_)
+				::madvise(addr, size, MADV_SEQUENTIAL);
+#	ifdef MADV_HUGEPAGE
+			if (options.huge_pages_)
+				::madvise(addr, size, MADV_HUGEPAGE);
+#	endif
+
+			source.data_ = static_cast<const char*>(addr);
+			source.size_ = size;
+			source.mapped_ = true;
+			return Result<MappedSource>::Some(std::move(source));
+		}
+	}
+
+	const int error_number = read_into(fd, regular ? static_cast<size_t>(info.st_size) : 0, source.buffer_);
+	::close(fd);
+	if (error_number != 0)
+		return Result<MappedSource>::SystemErr(ErrorCode::FileReadFailed, error_number);
+#else
+	// iostreams needn't set errno, so fall back to a generic I/O error.
+	errno = 0;
+	if (!read_into(path, source.buffer_))
+		return Result<MappedSource>::SystemErr(ErrorCode::FileReadFailed, errno != 0 ? errno : EIO);
+#endif
+	source.data_ = source.buffer_.data();
+	source.size_ = source.buffer_.size();
+	return Result<MappedSource>::Some(std::move(source));
+}
+
+
+MappedSource::~MappedSource()
+{
+	release();
+}
+
+
+MappedSource::MappedSource(MappedSource&& rhs) noexcept
+{
+	*this = std::move(rhs);
+}
+
+
+MappedSource& MappedSource::operator = (MappedSource&& rhs) noexcept
+{
+	if (this == &rhs)
+		return *this;
+
+	release();
+	path_ = std::move(rhs.path_);
+	mapped_ = std::exchange(rhs.mapped_, false);
+	size_ = std::exchange(rhs.size_, 0);
+	buffer_ = std::move(rhs.buffer_);
+	// A read buffer may have moved (small-string optimization), a mapping won't.
+	data_ = mapped_ ? rhs.data_ : buffer_.data();
+	rhs.data_ = "";
+	return *this;
+}
+
+
+void MappedSource::release() noexcept
+{
+#if KFS_HAVE_MMAP
+	if (mapped_)
+		::munmap(const_cast<char*>(data_), size_);
+#endif
+	mapped_ = false;
+	data_ = "";
+	size_ = 0;
+	buffer_.clear();
+}
+
+
+}
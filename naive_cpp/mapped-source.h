@@ -0,0 +1,76 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_MAPPED_SOURCE_H
+#define INCLUDED_KFS_NAIVE_CPP_MAPPED_SOURCE_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// MappedSource provides the text of an input file as a string_view without reading
+// it into heap memory: the file is memory-mapped read-only, and the MappedSource
+// owns the mapping, so it satisfies the Scanner's requirement that the source
+// outlives the scanner and any tokens taken from it.
+//
+// Inputs that can't be mapped (pipes, character devices, files whose mapping fails,
+// platforms without mmap) are read into memory instead, from the descriptor that was
+// opened for them, so a FIFO is only opened once.
+
+
+#include "common.h"
+#include "result.h"
+
+#include <string>
+
+
+namespace kfs
+{
+
+
+struct MappedSource
+{
+public:
+	//! How the file will be used.
+	struct Options
+	{
+		bool	sequential_	{true};		// madvise(SEQUENTIAL): we'll read it front to back.
+		bool	huge_pages_	{false};	// madvise(HUGEPAGE): back the mapping with huge pages where possible.
+		bool	map_		{true};		// Otherwise read it, so that it being truncated meanwhile can't SIGBUS us.
+	};
+
+	//! Maps the file at 'path', or returns an error code saying what failed, with
+	//! the errno value saying why in its error_number().
+	static Result<MappedSource> open(const std::string& path, Options options);
+	static Result<MappedSource> open(const std::string& path) { return open(path, Options{}); }
+
+	MappedSource() = default;
+	~MappedSource();
+
+	// Ownership of a mapping can be moved but not copied.
+	MappedSource(const MappedSource&) = delete;
+	MappedSource& operator = (const MappedSource&) = delete;
+	MappedSource(MappedSource&& rhs) noexcept;
+	MappedSource& operator = (MappedSource&& rhs) noexcept;
+
+	//! The contents of the file; valid for the lifetime of this object.
+	[[nodiscard]]
+	string_view text() const noexcept { return string_view(data_, size_); }
+	[[nodiscard]]
+	size_t size() const noexcept { return size_; }
+	[[nodiscard]]
+	const std::string& path() const noexcept { return path_; }
+	//! Returns true if the text is memory-mapped rather than read into memory.
+	[[nodiscard]]
+	bool is_mapped() const noexcept { return mapped_; }
+
+protected:
+	void release() noexcept;
+
+	std::string		path_		{ };
+	const char*		data_		{ "" };
+	size_t			size_		{ 0 };
+	bool			mapped_		{ false };
+	std::string		buffer_		{ };	// Holds the text when it couldn't be mapped.
+};
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_MAPPED_SOURCE_H
@@ -0,0 +1,139 @@
+// Unit tests for memory-mapped input files.
+
+#include "mapped-source.h"
+#include "scanner.h"
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#	include <sys/stat.h>
+#endif
+
+using namespace kfs;
+
+
+namespace
+{
+
+// Writes 'contents' to a file in the temp directory, removing it when done.
+struct TempFile
+{
+	explicit TempFile(const std::string& contents)
+		: path_((std::filesystem::temp_directory_path() / ("mapped-source-test-" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "-" + ::testing::UnitTest::GetInstance()->current_test_info()->name())).string())
+	{
+		std::ofstream(path_, std::ios::binary) << contents;
+	}
+	~TempFile() { std::remove(path_.c_str()); }
+
+	std::string path_;
+};
+
+}
+
+
+TEST(MappedSourceTest, MissingFile)
+{
+	auto result = MappedSource::open("/this/path/does/not/exist");
+	ASSERT_TRUE(result.is_error());
+	EXPECT_EQ(ErrorCode::FileOpenFailed, result.code());
+	EXPECT_EQ(ENOENT, result.error_number());
+
+	// It survives anything that happens to errno after the call.
+	errno = 0;
+	EXPECT_EQ(ENOENT, Result<int>::Err(result).error_number());
+}
+
+
+TEST(MappedSourceTest, MapsContents)
+{
+	const std::string contents = "enum E { A, B }\n// trailing comment";
+	TempFile file(contents);
+
+	auto result = MappedSource::open(file.path_);
+	ASSERT_TRUE(result.has_value());
+	const MappedSource source = result.take_value();
+	EXPECT_TRUE(source.is_mapped());
+	EXPECT_EQ(contents, source.text());
+	EXPECT_EQ(contents.size(), source.size());
+	EXPECT_EQ(file.path_, source.path());
+
+	Scanner scanner(source.text());
+	EXPECT_EQ(Token::Type::Word, scanner.next().token().type_);
+}
+
+
+TEST(MappedSourceTest, ReadsWhenAsked)
+{
+	const std::string contents = "enum E { A, B }";
+	TempFile file(contents);
+
+	auto result = MappedSource::open(file.path_, MappedSource::Options{ .map_ = false });
+	ASSERT_TRUE(result.has_value());
+	const MappedSource source = result.take_value();
+	EXPECT_FALSE(source.is_mapped());
+	EXPECT_EQ(contents, source.text());
+}
+
+
+TEST(MappedSourceTest, EmptyFile)
+{
+	TempFile file("");
+
+	auto result = MappedSource::open(file.path_);
+	ASSERT_TRUE(result.has_value());
+	const MappedSource source = result.take_value();
+	EXPECT_FALSE(source.is_mapped());
+	EXPECT_TRUE(source.text().empty());
+	EXPECT_NE(nullptr, source.text().data());
+}
+
+
+TEST(MappedSourceTest, Move)
+{
+	const std::string contents = "type T { int x }";
+	TempFile file(contents);
+
+	MappedSource first = MappedSource::open(file.path_).take_value();
+	const char* data = first.text().data();
+
+	MappedSource second = std::move(first);
+	EXPECT_EQ(contents, second.text());
+	EXPECT_EQ(data, second.text().data());
+	EXPECT_TRUE(first.text().empty());
+	EXPECT_FALSE(first.is_mapped());
+
+	first = std::move(second);
+	EXPECT_EQ(contents, first.text());
+	EXPECT_TRUE(second.text().empty());
+}
+
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST(MappedSourceTest, ReadsFifoOnce)
+{
+	// A FIFO can't be mapped; it must be read from the one open the writer connected
+	// to, or the writer's data goes to a reader that then goes away.
+	const std::string path = (std::filesystem::temp_directory_path() / ("mapped-source-test-" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "-fifo")).string();
+	std::remove(path.c_str());
+	ASSERT_EQ(0, ::mkfifo(path.c_str(), 0600));
+
+	std::string contents(200 * 1024, 'x');
+	contents += " enum E { A }";
+	std::thread writer([&] { std::ofstream(path, std::ios::binary) << contents; });
+	auto result = MappedSource::open(path);
+	writer.join();
+	std::remove(path.c_str());
+
+	ASSERT_TRUE(result.has_value());
+	const MappedSource source = result.take_value();
+	EXPECT_FALSE(source.is_mapped());
+	EXPECT_EQ(contents, source.text());
+}
+#endif
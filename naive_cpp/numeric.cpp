@@ -0,0 +1,86 @@
+// Decoding of Integer and Float literals.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "numeric.h"
+
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+
+namespace kfs
+{
+
+
+// Pairs of digits are combined into 2-digit values, then pairs of those into 4-digit
+// values, and finally the two halves into the 8-digit result, with one multiply per
+// step doing all of the lanes at once.
+uint32_t parse_eight_digits(const char* digits) noexcept
+{
+	if constexpr (std::endian::native == std::endian::little)
+	{
+		uint64_t v;
+		std::memcpy(&v, digits, sizeof(v));
+		v -= 0x3030303030303030ULL;
+		v = (v * 10) + (v >> 8);
+		v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)))
+		   + (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+		return static_cast<uint32_t>(v);
+	}
+	else
+	{
+		uint32_t value = 0;
+		for (size_t i = 0; i < 8; ++i)
+			value = value * 10 + uint32_t(digits[i] - '0');
+		return value;
+	}
+}
+
+
+ErrorCode parse_integer(string_view text, int64_t& out) noexcept
+{
+	const bool negative = !text.empty() && text.front() == '-';
+	if (!text.empty() && (text.front() == '-' || text.front() == '+'))
+		text.remove_prefix(1);
+
+	// Leading zeros don't count towards the size; anything over 19 significant digits
+	// can't fit, and 19 digits always fit in a uint64 so the accumulation can't wrap.
+	while (text.size() > 1 && text.front() == '0')
+		text.remove_prefix(1);
+	if (text.size() > std::numeric_limits<int64_t>::digits10 + 1)
+		return ErrorCode::IntegerOutOfRange;
+
+	uint64_t value = 0;
+	size_t pos = 0;
+	for ( ; pos + 8 <= text.size(); pos += 8)
+		value = value * 100000000 + parse_eight_digits(text.data() + pos);
+	for ( ; pos < text.size(); ++pos)
+		value = value * 10 + uint64_t(text[pos] - '0');
+
+	constexpr uint64_t max = uint64_t(std::numeric_limits<int64_t>::max());
+	if (value > max + (negative ? 1 : 0))
+		return ErrorCode::IntegerOutOfRange;
+
+	out = negative ? int64_t(0 - value) : int64_t(value);
+	return ErrorCode::None;
+}
+
+
+ErrorCode parse_float(string_view text, double& out) noexcept
+{
+	// from_chars doesn't accept a leading '+'.
+	if (!text.empty() && text.front() == '+')
+		text.remove_prefix(1);
+
+	// Underflow is reported as out of range too: a literal that's too small to
+	// represent would silently become zero.
+	if (std::from_chars(text.data(), text.data() + text.size(), out).ec == std::errc::result_out_of_range)
+		return ErrorCode::FloatOutOfRange;
+	return ErrorCode::None;
+}
+
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_NUMERIC_H
+#define INCLUDED_KFS_NAIVE_CPP_NUMERIC_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Decoding of Integer and Float literals.
+//
+// The scanner can decode numbers as it scans them, while the digits are still in
+// cache, so that nothing downstream has to parse the text again. Integers are
+// parsed 8 digits at a time with SWAR (SIMD-within-a-register) arithmetic, and
+// floats with std::from_chars, which is exact and doesn't depend on the locale.
+
+
+#include "common.h"
+#include "error.h"
+
+#include <cstdint>
+
+
+namespace kfs
+{
+
+
+//! The decoded value of an Integer or Float token; the token's type says which.
+union NumericValue
+{
+	int64_t		integer_;
+	double		float_;
+};
+
+
+//! Converts 8 ascii digits to their value, using SWAR arithmetic.
+[[nodiscard]]
+uint32_t parse_eight_digits(const char* digits) noexcept;
+
+//! Decodes an integer literal ([+-]?[0-9]+) into 'out', returning
+//! ErrorCode::IntegerOutOfRange if it doesn't fit in 64 bits, or None.
+[[nodiscard]]
+ErrorCode parse_integer(string_view text, int64_t& out) noexcept;
+
+//! Decodes a float literal ([+-]?([0-9]+.[0-9]*|.[0-9]+)) into 'out', returning
+//! ErrorCode::FloatOutOfRange if its magnitude is too large or too small for a
+//! double, or None.
+[[nodiscard]]
+ErrorCode parse_float(string_view text, double& out) noexcept;
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_NUMERIC_H
@@ -0,0 +1,173 @@
+// Unit tests for numeric literal decoding.
+
+#include "numeric.h"
+#include "scanner.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+using namespace kfs;
+
+
+TEST(NumericTest, EightDigits)
+{
+	EXPECT_EQ(0, parse_eight_digits("00000000"));
+	EXPECT_EQ(12345678, parse_eight_digits("12345678"));
+	EXPECT_EQ(99999999, parse_eight_digits("99999999"));
+	EXPECT_EQ(10000001, parse_eight_digits("10000001"));
+	// Only the first eight characters are read.
+	EXPECT_EQ(87654321, parse_eight_digits("87654321x"));
+}
+
+
+TEST(NumericTest, Integers)
+{
+	struct Case {
+		string_view text;
+		int64_t value;
+	} cases[] = {
+		{ "0", 0 },
+		{ "-0", 0 },
+		{ "+7", 7 },
+		{ "42", 42 },
+		{ "-42", -42 },
+		{ "0000000000000000000000000001", 1 },
+		{ "1234567", 1234567 },
+		{ "12345678", 12345678 },
+		{ "123456789", 123456789 },
+		{ "1234567890123456", 1234567890123456 },
+		{ "9223372036854775807", std::numeric_limits<int64_t>::max() },
+		{ "-9223372036854775808", std::numeric_limits<int64_t>::min() },
+		{ "+0009223372036854775807", std::numeric_limits<int64_t>::max() },
+	};
+	for (const auto& c : cases)
+	{
+		int64_t value = -1;
+		EXPECT_EQ(ErrorCode::None, parse_integer(c.text, value)) << c.text;
+		EXPECT_EQ(c.value, value) << c.text;
+	}
+}
+
+
+TEST(NumericTest, IntegerOverflow)
+{
+	for (string_view text : { "9223372036854775808", "-9223372036854775809", "18446744073709551616", "99999999999999999999", "100000000000000000000" })
+	{
+		int64_t value = -1;
+		EXPECT_EQ(ErrorCode::IntegerOutOfRange, parse_integer(text, value)) << text;
+		EXPECT_EQ(-1, value) << text;
+	}
+}
+
+
+TEST(NumericTest, Floats)
+{
+	struct Case {
+		string_view text;
+		double value;
+	} cases[] = {
+		{ "0.0", 0.0 },
+		{ "1.5", 1.5 },
+		{ "5.", 5.0 },
+		{ ".5", 0.5 },
+		{ "+1.5", 1.5 },
+		{ "-.25", -0.25 },
+		{ "+.5", 0.5 },
+		{ "0.1", 0.1 },
+		{ "3.141592653589793", 3.141592653589793 },
+	};
+	for (const auto& c : cases)
+	{
+		double value = -1;
+		EXPECT_EQ(ErrorCode::None, parse_float(c.text, value)) << c.text;
+		EXPECT_EQ(c.value, value) << c.text;
+	}
+
+	double value = 0;
+	EXPECT_EQ(ErrorCode::FloatOutOfRange, parse_float("1" + std::string(400, '0') + ".0", value));
+	EXPECT_EQ(ErrorCode::FloatOutOfRange, parse_float("0." + std::string(400, '0') + "1", value));
+}
+
+
+TEST(NumericTest, ScannerDoesNotDecodeByDefault)
+{
+	Scanner scanner("99999999999999999999");
+	EXPECT_FALSE(scanner.decodes_numbers());
+	EXPECT_TRUE(scanner.next().is_token());
+}
+
+
+TEST(NumericTest, ScannerDecodes)
+{
+	Scanner scanner("x = -12 y = 3.5 z = +.25 u = .5 w = 99999999999999999999 v = 1");
+	scanner.decode_numbers(true);
+
+	auto next_number = [&scanner]() {
+		for (auto result = scanner.next(); !result.is_none(); result = scanner.next())
+			if (result.is_error() || result.token().type_ == Token::Type::Integer || result.token().type_ == Token::Type::Float)
+				return result;
+		return TResult{};
+	};
+
+	auto result = next_number();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ(-12, scanner.last_number().integer_);
+	result = next_number();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ(3.5, scanner.last_number().float_);
+	result = next_number();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ(0.25, scanner.last_number().float_);
+	// A leading '.' makes a float, not an integer with a stray dot.
+	result = next_number();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ(Token::Type::Float, result.token().type_);
+	EXPECT_EQ(0.5, scanner.last_number().float_);
+
+	// Out of range literals are diagnosed with the offending token, and scanning
+	// carries on after them.
+	result = next_number();
+	ASSERT_TRUE(result.is_error());
+	EXPECT_EQ(ErrorCode::IntegerOutOfRange, result.code());
+	EXPECT_EQ("99999999999999999999", result.token().source_);
+	result = next_number();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ(1, scanner.last_number().integer_);
+}
+
+
+TEST(NumericTest, TokenBufferValues)
+{
+	const string_view source = "a = 1 b = { 2.5, -3 } c = \"4\"";
+	Scanner scanner(source);
+	scanner.decode_numbers(true);
+	TokenBuffer buffer(source);
+	const auto batch = scanner.next_batch(buffer, 64);
+	ASSERT_FALSE(batch.is_error());
+	ASSERT_EQ(13, buffer.size());
+	EXPECT_EQ(3, buffer.number_count());
+
+	EXPECT_FALSE(buffer.number(0).has_value());
+	ASSERT_TRUE(buffer.number(2).has_value());
+	EXPECT_EQ(1, buffer.number(2)->integer_);
+	ASSERT_TRUE(buffer.number(6).has_value());
+	EXPECT_EQ(2.5, buffer.number(6)->float_);
+	ASSERT_TRUE(buffer.number(8).has_value());
+	EXPECT_EQ(-3, buffer.number(8)->integer_);
+	EXPECT_FALSE(buffer.number(12).has_value());
+
+	// Values have to be recorded in token order.
+	EXPECT_FALSE(buffer.set_number(4, NumericValue{ .integer_ = 0 }));
+	EXPECT_FALSE(buffer.set_number(13, NumericValue{ .integer_ = 0 }));
+
+	// Appending rebases the indexes.
+	TokenBuffer combined(source);
+	combined.append(buffer);
+	combined.append(buffer);
+	EXPECT_EQ(6, combined.number_count());
+	ASSERT_TRUE(combined.number(13 + 8).has_value());
+	EXPECT_EQ(-3, combined.number(13 + 8)->integer_);
+}
@@ -0,0 +1,190 @@
+// Benchmarks for the parser: AST::next over whole documents, and name lookups in
+// the resulting AST.
+
+#include "app-ast.h"
+#include "app-collect.h"
+#include "app-definitions.h"
+#include "app-tokensequence.h"
+#include "bench-documents.h"
+#include "retokenize.h"
+#include "scanner.h"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <string>
+
+using namespace kfs;
+using namespace kfs::bench;
+
+
+namespace
+{
+
+// Parses every definition in 'tokens', returning false on a parse error.
+bool parse_all(const TokenBuffer& tokens, AST& ast)
+{
+	TokenSequence sequence{ tokens, ast.symbols_ };
+	for (;;)
+	{
+		auto result = ast.next(sequence);
+		if (result.is_error())
+			return false;
+		if (result.is_none())
+			return true;
+	}
+}
+
+
+// The parsing phase alone, over tokens scanned up front.
+void BM_ParseDocument(benchmark::State& state)
+{
+	const std::string source = make_schema(document_size);
+	Scanner scanner(source);
+	const TokenBuffer tokens = collect_tokens(scanner, "bench", false);
+	const PerfCounters perf;
+	const PerfSample before = perf.read();
+	for (auto _ : state)
+	{
+		AST ast;
+		if (!parse_all(tokens, ast))
+		{
+			state.SkipWithError("parse error");
+			break;
+		}
+		benchmark::DoNotOptimize(ast.nodes_.data());
+	}
+	report_perf(state, perf.read() - before, source.size(), tokens.size());
+	report_throughput(state, source.size(), tokens.size());
+}
+BENCHMARK(BM_ParseDocument);
+
+
+// Scanning and parsing, as the app does.
+void BM_ScanAndParse(benchmark::State& state)
+{
+	const std::string source = make_schema(document_size);
+	size_t token_count = 0;
+	const PerfCounters perf;
+	const PerfSample before = perf.read();
+	for (auto _ : state)
+	{
+		Scanner scanner(source);
+		const TokenBuffer tokens = collect_tokens(scanner, "bench", false);
+		token_count = tokens.size();
+		AST ast;
+		if (!parse_all(tokens, ast))
+		{
+			state.SkipWithError("parse error");
+			break;
+		}
+		benchmark::DoNotOptimize(ast.nodes_.data());
+	}
+	report_perf(state, perf.read() - before, source.size(), token_count);
+	report_throughput(state, source.size(), token_count);
+}
+BENCHMARK(BM_ScanAndParse);
+
+
+// Bringing the tokens and AST of a document up to date after adding a field to a type
+// halfway through it, and then taking it out again, to compare with BM_ScanAndParse.
+// The two versions are in separate buffers, as they would be when a file is re-read.
+void BM_Reparse(benchmark::State& state)
+{
+	std::array<std::string, 2> text{ make_schema(document_size), {} };
+	const std::string_view field = " int added_field = 42,";
+	const size_t at = text[0].find('{', text[0].find("\ntype T", text[0].size() / 2)) + 1;
+	text[1] = text[0];
+	text[1].insert(at, field);
+	const TextEdit edits[] = { TextEdit{ at, 0, field.size() }, TextEdit{ at, field.size(), 0 } };
+
+	Scanner scanner(text[0]);
+	TokenBuffer tokens = collect_tokens(scanner, "bench", false);
+	AST ast;
+	if (!parse_all(tokens, ast))
+	{
+		state.SkipWithError("parse error");
+		return;
+	}
+
+	size_t current = 0, reused = 0, rescanned = 0, reparsed = 0;
+	for (auto _ : state)
+	{
+		const RetokenizeResult changed = retokenize(tokens, text[current ^ 1], edits[current]);
+		TokenSequence sequence{ tokens, ast.symbols_ };
+		const ReparseResult result = ast.reparse(sequence, changed);
+		if (result.error_.is_error())
+		{
+			state.SkipWithError("parse error");
+			break;
+		}
+		reused = result.reused_;
+		rescanned += changed.rescanned_;
+		reparsed += result.reparsed_;
+		current ^= 1;
+	}
+	// Throughput is of what was rescanned and reparsed, which differs between the two
+	// edits, not the whole document.
+	state.SetBytesProcessed(int64_t(rescanned));
+	state.counters["definitions"] = double(ast.nodes_.size());
+	state.counters["reused"] = double(reused);
+	state.counters["reparsed"] = benchmark::Counter(double(reparsed), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_Reparse);
+
+
+// Resolving every definition, field and enum member of a parsed document by name,
+// the way later passes that check references would.
+void BM_ResolveNames(benchmark::State& state)
+{
+	const std::string source = make_schema(document_size);
+	Scanner scanner(source);
+	const TokenBuffer tokens = collect_tokens(scanner, "bench", false);
+	AST ast;
+	if (!parse_all(tokens, ast))
+	{
+		state.SkipWithError("parse error");
+		return;
+	}
+
+	size_t lookups = 0;
+	const PerfCounters perf;
+	const PerfSample before = perf.read();
+	for (auto _ : state)
+	{
+		lookups = 0;
+		for (size_t index = 0; index < ast.nodes_.size(); ++index)
+		{
+			const auto& node = ast.nodes_[index];
+			if (auto type = node->as<TypeDefinition*>(); type != nullptr)
+			{
+				for (const FieldDefinition* field : type->members_)
+				{
+					benchmark::DoNotOptimize(type->lookup(field->name_id_));
+					benchmark::DoNotOptimize(ast.find_definition(field->type_id_));
+					lookups += 2;
+				}
+				if (type->parent_id_ != no_symbol)
+				{
+					benchmark::DoNotOptimize(ast.find_definition(type->parent_id_));
+					++lookups;
+				}
+			}
+			else if (auto enumeration = node->as<EnumDefinition*>(); enumeration != nullptr)
+			{
+				const NodeText text = ast.text(tokens, index);
+				for (const NodeToken& member : enumeration->members_)
+				{
+					benchmark::DoNotOptimize(enumeration->lookup(ast.symbols_.find(text(member))));
+					++lookups;
+				}
+			}
+		}
+	}
+	// Per lookup, in place of per token.
+	report_perf(state, perf.read() - before, 0, lookups);
+	state.counters["lookups"] = benchmark::Counter(double(lookups), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_ResolveNames);
+
+}
@@ -0,0 +1,186 @@
+// Hardware performance counters.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "perf-counters.h"
+
+#if defined(__linux__)
+#	include <linux/perf_event.h>
+#	include <sys/ioctl.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#	define KFS_HAVE_PERF_EVENTS 1
+#else
+#	define KFS_HAVE_PERF_EVENTS 0
+#endif
+
+
+namespace kfs
+{
+
+
+string_view perf_event_name(PerfEvent event) noexcept
+{
+	using namespace std::string_view_literals;
+	switch (event)
+	{
+		case PerfEvent::Cycles:       return "cycles"sv;
+		case PerfEvent::Instructions: return "instructions"sv;
+		case PerfEvent::BranchMisses: return "branch-misses"sv;
+		case PerfEvent::L1DMisses:    return "L1d-misses"sv;
+		case PerfEvent::LLCMisses:    return "LLC-misses"sv;
+		default:                      return "<invalid event>"sv;
+	}
+}
+
+
+double PerfSample::ipc() const noexcept
+{
+	if (!has(PerfEvent::Cycles) || !has(PerfEvent::Instructions) || (*this)[PerfEvent::Cycles] == 0)
+		return 0;
+	return double((*this)[PerfEvent::Instructions]) / double((*this)[PerfEvent::Cycles]);
+}
+
+
+double PerfSample::per(PerfEvent event, size_t units) const noexcept
+{
+	if (!has(event) || units == 0)
+		return 0;
+	return double((*this)[event]) / double(units);
+}
+
+
+PerfSample PerfSample::operator - (const PerfSample& earlier) const noexcept
+{
+	PerfSample delta;
+	for (size_t i = 0; i < values_.size(); ++i)
+	{
+		delta.present_[i] = present_[i] && earlier.present_[i];
+		delta.values_[i] = delta.present_[i] && values_[i] >= earlier.values_[i] ? values_[i] - earlier.values_[i] : 0;
+	}
+	return delta;
+}
+
+
+#if KFS_HAVE_PERF_EVENTS
+
+namespace
+{
+
+	// The (type, config) for each PerfEvent.
+	perf_event_attr event_attr(PerfEvent event) noexcept
+	{
+		perf_event_attr attr {};
+		attr.size = sizeof(attr);
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		// Follow threads started after the counter is opened, such as scan_parallel's
+		// workers; their counts are added in when they exit. (Inherited counters can't
+		// be read as a PERF_FORMAT_GROUP, which is one more reason for not grouping.)
+		attr.inherit = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		constexpr uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D
+										 | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+										 | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		switch (event)
+		{
+		case PerfEvent::Cycles:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case PerfEvent::Instructions:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case PerfEvent::BranchMisses:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+			break;
+		case PerfEvent::L1DMisses:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = l1d_read_miss;
+			break;
+		default:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			break;
+		}
+		return attr;
+	}
+
+}
+
+
+// Each event gets its own counter rather than joining a group, so that one the
+// hardware doesn't have can't take the others down with it.
+PerfCounters::PerfCounters()
+{
+	for (size_t i = 0; i < fds_.size(); ++i)
+	{
+		perf_event_attr attr = event_attr(PerfEvent(i));
+		// This thread and those it starts, on any cpu.
+		fds_[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+}
+
+
+PerfCounters::~PerfCounters()
+{
+	for (int fd : fds_)
+		if (fd >= 0)
+			close(fd);
+}
+
+
+bool PerfCounters::available() const noexcept
+{
+	for (int fd : fds_)
+		if (fd >= 0)
+			return true;
+	return false;
+}
+
+
+PerfSample PerfCounters::read() const noexcept
+{
+	PerfSample sample;
+	for (size_t i = 0; i < fds_.size(); ++i)
+	{
+		// value, time enabled, time running.
+		uint64_t data[3] {};
+		if (fds_[i] < 0 || ::read(fds_[i], data, sizeof(data)) != ssize_t(sizeof(data)) || data[2] == 0)
+			continue;
+		sample.present_[i] = true;
+		sample.values_[i] = data[1] == data[2] ? data[0] : uint64_t(double(data[0]) * double(data[1]) / double(data[2]));
+	}
+	return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters()
+{
+	fds_.fill(-1);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+bool PerfCounters::available() const noexcept { return false; }
+
+PerfSample PerfCounters::read() const noexcept { return PerfSample{}; }
+
+#endif
+
+
+void PerfRecorder::end_phase(string_view name, size_t bytes, size_t tokens)
+{
+	const PerfSample now = counters_.read();
+	phases_.push_back(PerfPhase{ name, now - mark_, bytes, tokens });
+	// Leave out the bookkeeping.
+	mark_ = counters_.read();
+}
+
+
+}
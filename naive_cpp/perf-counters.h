@@ -0,0 +1,136 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_PERF_COUNTERS_H
+#define INCLUDED_KFS_NAIVE_CPP_PERF_COUNTERS_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Hardware performance counters, via Linux's perf_event_open.
+//
+// PerfCounters opens a counter for each PerfEvent on the calling thread, counting
+// user-space only so that it works at the default perf_event_paranoid level.
+// Threads the calling thread starts afterwards are counted too, but only once they
+// have exited, so a phase that runs work on other threads must join them before it
+// ends. The
+// counters run from construction; a phase is measured as the difference between
+// two read()s. Counters the kernel or hardware won't provide (virtual machines
+// often lack the cache events, and other platforms lack all of them) are simply
+// absent from the samples, so callers don't need to care where they are running.
+//
+// PerfRecorder builds on it to attribute counts to consecutive named phases of
+// work, e.g. scanning and then parsing, with the bytes and tokens each covered so
+// that they can be compared per unit of input.
+
+
+#include "common.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace kfs
+{
+
+
+enum class PerfEvent : uint8_t
+{
+	Cycles,
+	Instructions,
+	BranchMisses,
+	L1DMisses,		// Level 1 data-cache read misses.
+	LLCMisses,		// Last-level cache misses.
+
+	Count
+};
+
+//! Short name of an event, for reports.
+[[nodiscard]]
+string_view perf_event_name(PerfEvent event) noexcept;
+
+
+//! Counts of each event over some span of execution.
+struct PerfSample
+{
+	std::array<uint64_t, size_t(PerfEvent::Count)>	values_		{ };
+	std::array<bool, size_t(PerfEvent::Count)>		present_	{ };
+
+	[[nodiscard]]
+	bool has(PerfEvent event) const noexcept { return present_[size_t(event)]; }
+	[[nodiscard]]
+	uint64_t operator [] (PerfEvent event) const noexcept { return values_[size_t(event)]; }
+
+	//! Instructions per cycle, or 0 if either wasn't counted.
+	[[nodiscard]]
+	double ipc() const noexcept;
+
+	//! The count of 'event' per 'units' (of input), or 0 if it wasn't counted.
+	[[nodiscard]]
+	double per(PerfEvent event, size_t units) const noexcept;
+
+	//! The counts between two readings; an event is present if it is in both.
+	[[nodiscard]]
+	PerfSample operator - (const PerfSample& earlier) const noexcept;
+};
+
+
+struct PerfCounters
+{
+public:
+	PerfCounters();
+	~PerfCounters();
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator = (const PerfCounters&) = delete;
+
+	//! Returns true if at least one counter could be opened.
+	[[nodiscard]]
+	bool available() const noexcept;
+
+	//! Reads the running totals; counts that were multiplexed with other users of the
+	//! hardware are scaled up to estimate the whole time.
+	[[nodiscard]]
+	PerfSample read() const noexcept;
+
+protected:
+	std::array<int, size_t(PerfEvent::Count)>	fds_	{ };	// -1 where unavailable.
+};
+
+
+//! The counts for one phase of work, and how much input it covered.
+struct PerfPhase
+{
+	string_view	name_	{ };
+	PerfSample	sample_	{ };
+	size_t		bytes_	{0};
+	size_t		tokens_	{0};
+};
+
+
+struct PerfRecorder
+{
+public:
+	PerfRecorder() : mark_(counters_.read()) {}
+
+	[[nodiscard]]
+	bool available() const noexcept { return counters_.available(); }
+
+	//! Ends the current phase, which began when the recorder was created or the last
+	//! phase ended, recording what it covered; 'name' must outlive the recorder.
+	void end_phase(string_view name, size_t bytes, size_t tokens);
+
+	//! Starts a new phase without recording the one in progress, to leave out work
+	//! that isn't of interest, such as printing.
+	void skip() noexcept { mark_ = counters_.read(); }
+
+	[[nodiscard]]
+	const std::vector<PerfPhase>& phases() const noexcept { return phases_; }
+
+protected:
+	PerfCounters			counters_	{ };
+	PerfSample				mark_		{ };
+	std::vector<PerfPhase>	phases_		{ };
+};
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_PERF_COUNTERS_H
@@ -0,0 +1,121 @@
+// Unit tests for the hardware performance counters. Whether the counters can be
+// opened depends on the machine (and perf_event_paranoid), so tests that need real
+// counts skip when there are none.
+
+#include "perf-counters.h"
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace kfs;
+
+
+namespace
+{
+
+PerfSample make_sample(uint64_t cycles, uint64_t instructions)
+{
+	PerfSample sample;
+	sample.values_[size_t(PerfEvent::Cycles)] = cycles;
+	sample.present_[size_t(PerfEvent::Cycles)] = true;
+	sample.values_[size_t(PerfEvent::Instructions)] = instructions;
+	sample.present_[size_t(PerfEvent::Instructions)] = true;
+	return sample;
+}
+
+// Something for the counters to count.
+uint64_t busy_work()
+{
+	std::vector<uint64_t> values(1 << 16);
+	std::iota(values.begin(), values.end(), 1);
+	volatile uint64_t sum = std::accumulate(values.begin(), values.end(), uint64_t(0));
+	return sum;
+}
+
+}
+
+
+TEST(PerfCountersTest, EventNames)
+{
+	EXPECT_EQ("cycles", perf_event_name(PerfEvent::Cycles));
+	EXPECT_EQ("LLC-misses", perf_event_name(PerfEvent::LLCMisses));
+}
+
+
+TEST(PerfCountersTest, SampleArithmetic)
+{
+	const PerfSample before = make_sample(100, 150);
+	PerfSample after = make_sample(300, 550);
+	after.values_[size_t(PerfEvent::BranchMisses)] = 7;
+	after.present_[size_t(PerfEvent::BranchMisses)] = true;
+
+	const PerfSample delta = after - before;
+	EXPECT_EQ(200, delta[PerfEvent::Cycles]);
+	EXPECT_EQ(400, delta[PerfEvent::Instructions]);
+	EXPECT_DOUBLE_EQ(2.0, delta.ipc());
+	EXPECT_DOUBLE_EQ(0.5, delta.per(PerfEvent::Cycles, 400));
+	// Only in one of the readings, so it isn't in the difference.
+	EXPECT_FALSE(delta.has(PerfEvent::BranchMisses));
+	EXPECT_EQ(0, delta.per(PerfEvent::BranchMisses, 1));
+	EXPECT_EQ(0, delta.per(PerfEvent::Cycles, 0));
+}
+
+
+TEST(PerfCountersTest, MissingCountersHaveNoIPC)
+{
+	PerfSample sample = make_sample(0, 100);
+	EXPECT_EQ(0, sample.ipc());
+	sample.present_[size_t(PerfEvent::Cycles)] = false;
+	sample.values_[size_t(PerfEvent::Cycles)] = 50;
+	EXPECT_EQ(0, sample.ipc());
+}
+
+
+TEST(PerfCountersTest, CountsWork)
+{
+	PerfCounters counters;
+	if (!counters.available())
+		GTEST_SKIP() << "no hardware counters available";
+
+	const PerfSample before = counters.read();
+	busy_work();
+	const PerfSample delta = counters.read() - before;
+	if (delta.has(PerfEvent::Instructions))
+		EXPECT_GT(delta[PerfEvent::Instructions], 1u << 16);
+}
+
+
+TEST(PerfCountersTest, CountsWorkerThreads)
+{
+	PerfCounters counters;
+	if (!counters.available())
+		GTEST_SKIP() << "no hardware counters available";
+
+	// Work done on a thread started, and joined, after the counters were opened.
+	const PerfSample before = counters.read();
+	std::thread(busy_work).join();
+	const PerfSample delta = counters.read() - before;
+	if (delta.has(PerfEvent::Instructions))
+		EXPECT_GT(delta[PerfEvent::Instructions], 1u << 16);
+}
+
+
+TEST(PerfCountersTest, RecorderPhases)
+{
+	PerfRecorder recorder;
+	busy_work();
+	recorder.end_phase("first", 100, 10);
+	recorder.skip();
+	recorder.end_phase("second", 200, 20);
+
+	ASSERT_EQ(2, recorder.phases().size());
+	EXPECT_EQ("first", recorder.phases()[0].name_);
+	EXPECT_EQ(100, recorder.phases()[0].bytes_);
+	EXPECT_EQ("second", recorder.phases()[1].name_);
+	EXPECT_EQ(20, recorder.phases()[1].tokens_);
+	if (recorder.available() && recorder.phases()[0].sample_.has(PerfEvent::Instructions))
+		EXPECT_GT(recorder.phases()[0].sample_[PerfEvent::Instructions], recorder.phases()[1].sample_[PerfEvent::Instructions]);
+}
@@ -4,9 +4,11 @@
 
 
 #include "common.h"
+#include "error.h"
+#include "token.h"
 
-#include <optional>
 #include <string>
+#include <utility>
 
 
 namespace kfs
@@ -19,39 +21,38 @@ namespace kfs
 //!		.is_value()  => no error, but a concrete value is present,
 //!		.has_value() => true when is_value(), but can also be true with is_error() to
 //!						provide additional error context.
+//!
+//! Errors are an ErrorCode plus the span (Token) of the text that caused them, so a
+//! Result is trivially copyable whenever the value type is, and producing an error
+//! never allocates. The value type must be default constructible. Errors from system
+//! calls (the file codes) also carry the errno value, since errno itself may have
+//! changed by the time the error is reported.
 //
 struct val_t {};
-struct err_t {};
 
 template<typename ValueType>
 struct Result
-///TODO: disallow ValueType == string-like
 {
 	using data_type = ValueType;
-	using err_type  = std::string;
 	using self_type = Result<data_type>;
 
 private:
-	std::optional<data_type> value_ {};
-	std::optional<err_type>	 error_ {};
+	data_type	value_		{ };
+	Token		span_		{ };
+	ErrorCode	code_		{ ErrorCode::None };
+	bool		has_value_	{ false };
+	int			error_number_	{ 0 };
 
 public:
 	constexpr Result() = default;
     static self_type None()  { return self_type(); }
 
-    // Copy and move operations.
-	~Result() = default;
-	constexpr Result(const Result&) = default;
-	Result(Result&&) = default;
-    constexpr Result& operator = (const Result&) = default;
-    Result& operator = (Result&&) = default;
-
     explicit Result(data_type value, val_t=val_t{})
-		: value_(std::forward<data_type>(value))
+		: value_(std::move(value)), has_value_(true)
 	{}
     static self_type Some(data_type value)
     {
-        return self_type(std::forward<data_type>(value), val_t{});
+        return self_type(std::move(value), val_t{});
     }
     template<typename T>
     static self_type Some(Result<T>&& rhs)
@@ -59,56 +60,82 @@ public:
         return self_type(rhs.take_value(), val_t{});
     }
 
-	explicit Result(err_type&& error, err_t={})
-		: error_(std::move(error))
+	explicit Result(ErrorCode code, const Token& span = Token{})
+		: span_(span), code_(code)
 	{}
-    static self_type Err(err_type&& error)
+    static self_type Err(ErrorCode code, const Token& span = Token{})
+    {
+        return self_type(code, span);
+    }
+    //! An error from a system call, with the errno value that says why.
+    static self_type SystemErr(ErrorCode code, int error_number)
+    {
+        self_type result(code);
+        result.error_number_ = error_number;
+        return result;
+    }
+    //! Forward the error from a result of another type.
+    template<typename T>
+    static self_type Err(const Result<T>& rhs)
     {
-        return self_type(std::move(error), err_t{});
+        self_type result(rhs.code(), rhs.span());
+        result.error_number_ = rhs.error_number();
+        return result;
     }
 
-    explicit Result(data_type value, err_type&& error)
-        : value_(std::forward<data_type>(value)), error_(std::move(error))
+    explicit Result(data_type value, ErrorCode code, const Token& span = Token{})
+        : value_(std::move(value)), span_(span), code_(code), has_value_(true)
     {}
 
     [[nodiscard]]
 	bool operator == (const self_type& other) const noexcept
 	{
-		if (has_value())
-			return other.has_value() && value() == other.value();
-		if (is_error())
-			return other.is_error() && error() == other.error();
-		return true;
+		if (code_ != other.code_ || has_value_ != other.has_value_)
+			return false;
+		if (is_error() && span_ != other.span_)
+			return false;
+		return !has_value_ || value_ == other.value_;
 	}
 
 	//! is_none will return true if the value has no error or value.
 	[[nodiscard]]
-	bool is_none() const noexcept { return !value_ && !error_; }
+	bool is_none() const noexcept { return !has_value_ && !is_error(); }
 	//! is_error will return true if an error is present.
     [[nodiscard]]
-	bool is_error() const noexcept { return error_.has_value(); }
+	bool is_error() const noexcept { return code_ != ErrorCode::None; }
 	//! is_value will return true only if a value is present without an error.
     [[nodiscard]]
-	bool is_value() const noexcept { return value_.has_value() && !is_error(); }
+	bool is_value() const noexcept { return has_value_ && !is_error(); }
 	//! has_value will return true if a value is present, but it may be an error-related piece of information.
     [[nodiscard]]
-	bool has_value() const noexcept { return value_.has_value(); }
+	bool has_value() const noexcept { return has_value_; }
 
 	//! value() will attempt to return the value of the result, you must check is_value() or has_value() first.
     [[nodiscard]]
-	const data_type& value() const noexcept { return value_.value(); }
+	const data_type& value() const noexcept { return value_; }
     //! take the value
     [[nodiscard]]
-    data_type&& take_value() noexcept { return std::move(*value_); }
-	//! error() will attempt to return the error instead of the value, you must check is_error() first.
+    data_type&& take_value() noexcept { return std::move(value_); }
+
+	//! code() returns the error code, which is ErrorCode::None if there is no error.
+    [[nodiscard]]
+	ErrorCode code() const noexcept { return code_; }
+	//! span() returns the text that the error relates to, which may be empty.
+    [[nodiscard]]
+	const Token& span() const noexcept { return span_; }
+	//! error_number() returns the errno value of a SystemErr, otherwise 0.
+    [[nodiscard]]
+	int error_number() const noexcept { return error_number_; }
+	//! error() returns the static description of the error, you must check is_error() first.
+    [[nodiscard]]
+	string_view error() const noexcept { return error_message(code_); }
+	//! message() builds a full description of the error, including the text of its span.
     [[nodiscard]]
-	const err_type&  error() const noexcept { return error_.value(); }
-    //! take the error
-    err_type&& take_error() noexcept { return std::move(*error_); }
+	std::string message() const { return describe_error(code_, span_); }
 
 };
 
 
 }
 
-#endif  // INCLUDED_KFS_NAIVE_CPP_RESULT_H
\ No newline at end of file
+#endif  // INCLUDED_KFS_NAIVE_CPP_RESULT_H
@@ -0,0 +1,143 @@
+// Incremental re-tokenization after edits.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "retokenize.h"
+#include "scanner.h"
+
+#include <algorithm>
+
+
+namespace kfs
+{
+
+
+namespace
+{
+
+	// How far past its end the scanner may have looked to decide a token.
+	constexpr size_t lookahead = 2;
+
+	// Index of the first token whose decision could have looked at 'offset' or later.
+	size_t first_affected(const TokenBuffer& tokens, size_t offset) noexcept
+	{
+		size_t lo = 0, hi = tokens.size();
+		while (lo < hi)
+		{
+			const size_t mid = lo + (hi - lo) / 2;
+			if (size_t(tokens.offset(mid)) + tokens.length(mid) + lookahead <= offset)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+}
+
+
+TextEdit apply_edit(std::string& text, size_t offset, size_t removed, string_view inserted)
+{
+	offset = std::min(offset, text.size());
+	removed = std::min(removed, text.size() - offset);
+	text.replace(offset, removed, inserted);
+	return TextEdit{ offset, removed, inserted.size() };
+}
+
+
+TextEdit find_edit(string_view before, string_view after) noexcept
+{
+	const size_t limit = std::min(before.size(), after.size());
+	const size_t prefix = size_t(std::mismatch(before.begin(), before.begin() + ptrdiff_t(limit), after.begin()).first - before.begin());
+	size_t suffix = 0;
+	while (suffix < limit - prefix && before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix])
+		++suffix;
+	return TextEdit{ prefix, before.size() - prefix - suffix, after.size() - prefix - suffix };
+}
+
+
+RetokenizeResult retokenize(TokenBuffer& tokens, string_view source, const TextEdit& edit, bool decode_numbers)
+{
+	const size_t old_size = tokens.source().size();
+	const bool fits = edit.offset_ <= old_size && edit.removed_ <= old_size - edit.offset_
+		&& ptrdiff_t(old_size) + edit.shift() == ptrdiff_t(source.size());
+
+	RetokenizeResult result;
+	if (!TokenBuffer::can_hold(source)) [[unlikely]]
+	{
+		// As with a full scan: one error for the whole document, and no tokens.
+		result.removed_ = tokens.size();
+		result.errors_.push_back(TResult{Token{ Token::Type::Invalid, source.substr(0, 0) }, ErrorCode::DocumentTooLarge});
+		tokens.clear();
+		tokens.rebase(source);
+		return result;
+	}
+	result.first_ = fits ? first_affected(tokens, edit.offset_) : 0;
+	const size_t restart = result.first_ > 0 ? size_t(tokens.offset(result.first_ - 1)) + tokens.length(result.first_ - 1) : 0;
+	result.start_ = restart;
+
+	// Scanning a view of the rest of the document yields tokens within the document.
+	Scanner scanner(source.substr(restart));
+	scanner.decode_numbers(decode_numbers);
+	TokenBuffer replacement(source);
+
+	const size_t edit_end = edit.offset_ + edit.inserted_;
+	size_t old_index = result.first_;
+	bool resynced = false;
+	while (!resynced)
+	{
+		TResult scanned = scanner.next();
+		if (scanned.is_none())
+			break;
+		if (scanned.is_error())
+		{
+			result.errors_.push_back(std::move(scanned));
+			continue;
+		}
+
+		const Token& token = scanned.token();
+		const auto offset = size_t(token.source_.data() - source.data());
+		if (fits && offset >= edit_end)
+		{
+			// Where this token would have been before the edit.
+			const auto old_offset = size_t(ptrdiff_t(offset) - edit.shift());
+			while (old_index < tokens.size() && tokens.offset(old_index) < old_offset)
+				++old_index;
+			if (old_index < tokens.size() && tokens.offset(old_index) == old_offset)
+			{
+				resynced = true;
+				result.rescanned_ = offset - restart;
+				break;
+			}
+		}
+
+		if (!replacement.push_back(token))
+		{
+			result.errors_.push_back(TResult{token, ErrorCode::TokenTooLong});
+			continue;
+		}
+		if (decode_numbers && (token.type_ == Token::Type::Integer || token.type_ == Token::Type::Float))
+			replacement.set_number(replacement.size() - 1, scanner.last_number());
+	}
+	if (!resynced)
+	{
+		old_index = tokens.size();
+		result.rescanned_ = source.size() - restart;
+	}
+
+	result.removed_ = old_index - result.first_;
+	result.inserted_ = replacement.size();
+	tokens.rebase(source);
+	if (!tokens.splice(result.first_, result.removed_, replacement, edit.shift()))
+	{
+		// The document has outgrown the offsets; keep what we can and drop the rest.
+		result.removed_ = tokens.size() - result.first_;
+		tokens.splice(result.first_, result.removed_, replacement, 0);
+		result.errors_.push_back(TResult{Token{}, ErrorCode::TokenTooLong});
+	}
+	return result;
+}
+
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_RETOKENIZE_H
+#define INCLUDED_KFS_NAIVE_CPP_RETOKENIZE_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Incremental re-tokenization: after an edit to a document, bring its TokenBuffer
+// up to date by scanning only the part of the text the edit can have affected.
+//
+// The scanner has no state between tokens other than its position, so the tokens
+// from any token's start onward depend only on the text from there on. That gives
+// both ends of the region to rescan:
+//
+//  - it starts just after the last token that couldn't have seen the edit; a token
+//    is decided by its own text plus at most two characters after it (a '+' is only
+//    a number if it is followed by ".<digit>"), so the tokens that end at least that
+//    far before the edit are unchanged.
+//  - it stops at the first new token, after the inserted text, that starts where an
+//    old token started (allowing for the change in length); from there on the old
+//    tokens are still right and only need moving.
+//
+// The work is proportional to the size of the edit plus however far its effect
+// runs - opening a block comment or a string can reach a long way - rather than to
+// the size of the document, apart from moving the token arrays and offsets along.
+//
+// Retained comments (TriviaTable) aren't updated; rescan if you need them.
+
+
+#include "common.h"
+#include "token-buffer.h"
+#include "tresult.h"
+
+#include <string>
+#include <vector>
+
+
+namespace kfs
+{
+
+
+//! An edit to a document: 'removed_' bytes at 'offset_' were replaced with
+//! 'inserted_' bytes of new text.
+struct TextEdit
+{
+	size_t	offset_		{0};
+	size_t	removed_	{0};
+	size_t	inserted_	{0};
+
+	//! The change in the document's length.
+	[[nodiscard]]
+	ptrdiff_t shift() const noexcept { return ptrdiff_t(inserted_) - ptrdiff_t(removed_); }
+};
+
+//! Applies an edit to 'text', returning its description; the edit is clamped to
+//! the text.
+TextEdit apply_edit(std::string& text, size_t offset, size_t removed, string_view inserted);
+
+//! Returns the smallest single edit that turns 'before' into 'after', found by
+//! trimming the text they start and end with in common.
+[[nodiscard]]
+TextEdit find_edit(string_view before, string_view after) noexcept;
+
+
+//! What retokenize changed.
+struct RetokenizeResult
+{
+	size_t					first_		{0};	// Index of the first token replaced.
+	size_t					removed_	{0};	// Number of old tokens replaced,
+	size_t					inserted_	{0};	// and the number of new tokens in their place.
+	size_t					start_		{0};	// Where scanning began in the new text,
+	size_t					rescanned_	{0};	// and how many bytes were scanned.
+	std::vector<TResult>	errors_		{ };	// Errors in the rescanned text, which scanning skipped.
+};
+
+
+//! Updates 'tokens', scanned from a document before 'edit', to match 'source', the
+//! document after it; errors are skipped, as collect_tokens does. With
+//! 'decode_numbers', new numeric tokens are decoded. If the edit doesn't fit the
+//! document, the whole document is rescanned. A document too large for the buffer
+//! to hold is reported as a single DocumentTooLarge error, leaving no tokens.
+RetokenizeResult retokenize(TokenBuffer& tokens, string_view source, const TextEdit& edit, bool decode_numbers = false);
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_RETOKENIZE_H
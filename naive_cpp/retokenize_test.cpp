@@ -0,0 +1,273 @@
+// Unit tests for incremental re-tokenization: after any edit, the spliced buffer
+// must be exactly what scanning the edited document from scratch produces.
+
+#include "corpus.h"
+#include "retokenize.h"
+#include "scanner.h"
+
+#include <gtest/gtest.h>
+
+#include <bit>
+#include <random>
+#include <string>
+
+using namespace kfs;
+
+
+namespace
+{
+
+// Scans a whole document, skipping errors as collect_tokens does.
+TokenBuffer full_scan(string_view source, bool decode_numbers = false)
+{
+	Scanner scanner(source);
+	scanner.decode_numbers(decode_numbers);
+	TokenBuffer tokens(source);
+	for (;;)
+	{
+		const auto batch = scanner.next_batch(tokens, 4096);
+		if (!batch.is_error() && batch.count_ < 4096)
+			break;
+	}
+	return tokens;
+}
+
+// Checks the buffers hold the same tokens, flags and decoded numbers.
+void expect_same(const TokenBuffer& expected, const TokenBuffer& actual)
+{
+	ASSERT_EQ(expected.size(), actual.size());
+	ASSERT_TRUE(expected == actual);
+	ASSERT_EQ(expected.source().data(), actual.source().data());
+	ASSERT_EQ(expected.number_count(), actual.number_count());
+	for (size_t i = 0; i < expected.size(); ++i)
+	{
+		ASSERT_EQ(expected.number(i).has_value(), actual.number(i).has_value()) << "token " << i;
+		if (expected.number(i).has_value())
+		{
+			ASSERT_EQ(std::bit_cast<uint64_t>(*expected.number(i)), std::bit_cast<uint64_t>(*actual.number(i))) << "token " << i;
+		}
+	}
+}
+
+}
+
+
+TEST(RetokenizeTest, ApplyEdit)
+{
+	std::string text = "hello world";
+	TextEdit edit = apply_edit(text, 6, 5, "there");
+	EXPECT_EQ("hello there", text);
+	EXPECT_EQ(6, edit.offset_);
+	EXPECT_EQ(0, edit.shift());
+
+	edit = apply_edit(text, 100, 3, "!");
+	EXPECT_EQ("hello there!", text);
+	EXPECT_EQ(11, edit.offset_);
+	EXPECT_EQ(0, edit.removed_);
+
+	edit = apply_edit(text, 5, 100, "");
+	EXPECT_EQ("hello", text);
+	EXPECT_EQ(-7, edit.shift());
+}
+
+
+TEST(RetokenizeTest, FindEdit)
+{
+	TextEdit edit = find_edit("enum E { A }", "enum E { A, B }");
+	EXPECT_EQ(10, edit.offset_);
+	EXPECT_EQ(0, edit.removed_);
+	EXPECT_EQ(3, edit.inserted_);
+
+	edit = find_edit("type T { int x }", "type U { int x }");
+	EXPECT_EQ(5, edit.offset_);
+	EXPECT_EQ(1, edit.removed_);
+	EXPECT_EQ(1, edit.inserted_);
+
+	// Repeated text: the common prefix is taken first.
+	edit = find_edit("aaaa", "aa");
+	EXPECT_EQ(2, edit.offset_);
+	EXPECT_EQ(2, edit.removed_);
+	EXPECT_EQ(0, edit.inserted_);
+
+	edit = find_edit("same", "same");
+	EXPECT_EQ(0, edit.removed_);
+	EXPECT_EQ(0, edit.inserted_);
+
+	std::string text = "x = 1, y = 2";
+	const std::string after = "x = 10, z = 2";
+	edit = find_edit(text, after);
+	apply_edit(text, edit.offset_, edit.removed_, string_view(after).substr(edit.offset_, edit.inserted_));
+	EXPECT_EQ(after, text);
+}
+
+
+TEST(RetokenizeTest, SpliceMovesTokensAndNumbers)
+{
+	const std::string before = "a 1 b 2 c 3";
+	TokenBuffer tokens = full_scan(before, true);
+	ASSERT_EQ(3, tokens.number_count());
+
+	// "b 2" -> "xyz 42 7"
+	const std::string after = "a 1 xyz 42 7 c 3";
+	TokenBuffer replacement = full_scan(after, true);
+	TokenBuffer middle(after);
+	for (size_t i = 2; i < 5; ++i)
+	{
+		ASSERT_TRUE(middle.push_back(replacement.token(i)));
+		if (auto value = replacement.number(i); value.has_value())
+			middle.set_number(middle.size() - 1, *value);
+	}
+	tokens.rebase(after);
+	ASSERT_TRUE(tokens.splice(2, 2, middle, 5));
+	expect_same(replacement, tokens);
+
+	// Sources must match.
+	TokenBuffer other(before);
+	EXPECT_FALSE(tokens.splice(0, 0, other, 0));
+	EXPECT_FALSE(tokens.splice(5, 5, middle, 0));
+}
+
+
+TEST(RetokenizeTest, HugeDocumentIsOneError)
+{
+	if constexpr (sizeof(size_t) > sizeof(uint32_t))
+	{
+		// Rejected before anything is scanned, so the view needn't be backed by real memory.
+		const std::string before = "a b c";
+		TokenBuffer tokens = full_scan(before);
+		const string_view huge(before.data(), TokenBuffer::max_offset + 1);
+		const auto result = retokenize(tokens, huge, TextEdit{ 5, 0, TokenBuffer::max_offset + 1 - 5 });
+		ASSERT_EQ(1, result.errors_.size());
+		EXPECT_EQ(ErrorCode::DocumentTooLarge, result.errors_[0].code());
+		EXPECT_EQ(3, result.removed_);
+		EXPECT_EQ(0, result.inserted_);
+		EXPECT_TRUE(tokens.empty());
+		EXPECT_EQ(huge.size(), tokens.source().size());
+	}
+}
+
+
+TEST(RetokenizeTest, EditWithinWord)
+{
+	std::string text = "enum E { Alpha, Beta }\ntype T { int x = 1 }\n";
+	TokenBuffer tokens = full_scan(text);
+	const TextEdit edit = apply_edit(text, 11, 0, "ph");
+
+	const auto result = retokenize(tokens, text, edit);
+	expect_same(full_scan(text), tokens);
+	EXPECT_EQ(3, result.first_);
+	EXPECT_EQ(8, result.start_);		// Just after the '{'.
+	EXPECT_EQ(1, result.removed_);
+	EXPECT_EQ(1, result.inserted_);
+	EXPECT_LT(result.rescanned_, 10);
+	EXPECT_TRUE(result.errors_.empty());
+}
+
+
+TEST(RetokenizeTest, EditChangesLookahead)
+{
+	// The '+' was an error, and becomes part of a float.
+	std::string text = "a +.x b";
+	TokenBuffer tokens = full_scan(text);
+	ASSERT_EQ(3, tokens.size());
+	const TextEdit edit = apply_edit(text, 4, 1, "5");
+
+	const auto result = retokenize(tokens, text, edit);
+	expect_same(full_scan(text), tokens);
+	EXPECT_EQ(Token::Type::Float, tokens.type(1));
+	EXPECT_TRUE(result.errors_.empty());
+}
+
+
+TEST(RetokenizeTest, OpeningCommentRunsToItsEnd)
+{
+	std::string text = "a b c d */ e f";
+	TokenBuffer tokens = full_scan(text);
+	const TextEdit edit = apply_edit(text, 2, 0, "/* ");
+
+	const auto result = retokenize(tokens, text, edit);
+	expect_same(full_scan(text), tokens);
+	// 'a' is close enough to the edit to be rescanned; '*' and '/' were errors.
+	EXPECT_EQ(0, result.first_);
+	EXPECT_EQ(4, result.removed_);
+	EXPECT_EQ(1, result.inserted_);
+	EXPECT_EQ(3, tokens.size());
+}
+
+
+TEST(RetokenizeTest, ReportsErrorsInRescannedText)
+{
+	std::string text = "type T { int x = 1 }";
+	TokenBuffer tokens = full_scan(text);
+	const TextEdit edit = apply_edit(text, 17, 1, "@");
+
+	const auto result = retokenize(tokens, text, edit);
+	expect_same(full_scan(text), tokens);
+	ASSERT_EQ(1, result.errors_.size());
+	EXPECT_EQ(ErrorCode::UnexpectedCharacter, result.errors_[0].code());
+	EXPECT_EQ("@", result.errors_[0].token().source_);
+}
+
+
+TEST(RetokenizeTest, MismatchedEditRescansEverything)
+{
+	std::string text = "a b c";
+	TokenBuffer tokens = full_scan(text);
+	text = "a b c d e";
+	const auto result = retokenize(tokens, text, TextEdit{ 1, 0, 1 });
+	expect_same(full_scan(text), tokens);
+	EXPECT_EQ(0, result.first_);
+	EXPECT_EQ(text.size(), result.rescanned_);
+}
+
+
+TEST(RetokenizeTest, SmallEditInLargeDocument)
+{
+	CorpusOptions options;
+	options.target_size_ = 1024 * 1024;
+	std::string text = generate_corpus(options);
+	TokenBuffer tokens = full_scan(text, true);
+
+	// Rename an identifier halfway through.
+	const size_t at = text.find(" T", text.size() / 2) + 2;
+	const TextEdit edit = apply_edit(text, at, 1, "Q");
+	const auto result = retokenize(tokens, text, edit, true);
+	expect_same(full_scan(text, true), tokens);
+	EXPECT_EQ(1, result.removed_);
+	EXPECT_EQ(1, result.inserted_);
+	EXPECT_LT(result.rescanned_, 256);
+}
+
+
+// Random edits of every kind, each checked against a full rescan.
+TEST(RetokenizeTest, RandomEditsMatchFullScan)
+{
+	static const char* fragments[] = {
+		"", " ", "\n", "x", "enum", "Name_2", "0", "42", ".", "5.", "+", "-", ".5", "\"", "\\\"", "\"str\"",
+		"{", "}", "[]", "=", ":", "::", ",", "/", "*", "/*", "*/", "//", "@", "\r\n",
+	};
+
+	CorpusOptions options;
+	options.target_size_ = 32 * 1024;
+	options.comment_density_ = 0.5;
+	options.broken_rate_ = 0.1;
+	std::string text = generate_corpus(options);
+	TokenBuffer tokens = full_scan(text, true);
+
+	std::mt19937 rng(7);
+	for (int i = 0; i < 500; ++i)
+	{
+		const size_t offset = rng() % (text.size() + 1);
+		const size_t removed = rng() % 4 == 0 ? rng() % 12 : 0;
+		const char* inserted = fragments[rng() % std::size(fragments)];
+		const TextEdit edit = apply_edit(text, offset, removed, inserted);
+
+		retokenize(tokens, text, edit, true);
+		expect_same(full_scan(text, true), tokens);
+		if (testing::Test::HasFatalFailure())
+		{
+			ADD_FAILURE() << "edit #" << i << " at " << offset << ", removed " << removed << ", inserted |" << inserted << "|";
+			return;
+		}
+	}
+}
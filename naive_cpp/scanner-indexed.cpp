@@ -0,0 +1,74 @@
+// Stage-2 scanner driven by a StructuralIndex.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "scanner-indexed.h"
+
+
+namespace kfs
+{
+
+
+TResult IndexedScanner::next()
+{
+	const size_t pos = index_.next_significant(position());
+	current_ = source_.substr(pos);
+	if (current_.empty())
+		return TResult{};
+
+	if (pos == index_.unterminated_comment())
+		return TResult{make_token(Token::Type::OpenComment, current_.size()), ErrorCode::UnterminatedComment};
+
+	if (index_.is_structural(pos))
+	{
+		switch (front())
+		{
+		case '{':	return TResult{make_token(Token::Type::LBrace, 1)};
+		case '}':	return TResult{make_token(Token::Type::RBrace, 1)};
+		case '[':	return TResult{make_token(Token::Type::LBracket, 1)};
+		case ']':	return TResult{make_token(Token::Type::RBracket, 1)};
+		case '=':	return TResult{make_token(Token::Type::Equals, 1)};
+		case ',':	return TResult{make_token(Token::Type::Comma, 1)};
+		default:
+			// ':'
+			if (peek(1) == ':')
+				return TResult{make_token(Token::Type::Scope, 2)};
+			return TResult{make_token(Token::Type::Colon, 1)};
+		}
+	}
+
+	if (index_.is_string(pos))
+	{
+		const size_t len = index_.string_end(pos) - pos;
+		const uint8_t flags = index_.is_escaped(pos) ? Token::Escaped : Token::NoFlags;
+		if (peek(len) == '"')
+			return TResult{make_token(Token::Type::String, len + 1, flags)};
+		return TResult{make_token(Token::Type::String, len, flags), ErrorCode::UnterminatedString};
+	}
+
+	const char first = front();
+	if (first == '+' || first == '-')
+		return scan_signed_number();
+	if ((first >= '0' && first <= '9') || (first == '.' && peek(1) >= '0' && peek(1) <= '9'))
+		return scan_number();
+	if ((first >= 'a' && first <= 'z') || (first >= 'A' && first <= 'Z') || first == '_')
+		return scan_word();
+
+	return unexpected_result();
+}
+
+
+BatchResult IndexedScanner::next_batch(std::span<Token> out)
+{
+	return fill_batch(*this, out);
+}
+
+
+BatchResult IndexedScanner::next_batch(TokenBuffer& out, size_t limit)
+{
+	return fill_batch(*this, out, limit);
+}
+
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_SCANNER_INDEXED_H
+#define INCLUDED_KFS_NAIVE_CPP_SCANNER_INDEXED_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Two-stage variant of the Scanner: stage 1 builds a StructuralIndex of the whole
+// source, and stage 2 (this) produces tokens from it. Whitespace and comments are
+// skipped by finding the next clear bit in their bitmaps, structural characters
+// are emitted straight from their bit, and strings are cut at the end of their
+// region, so only words and numbers are still scanned a run at a time.
+//
+// It produces exactly the same tokens as Scanner, so the two can be compared on the
+// same input.
+
+
+#include "scanner.h"
+#include "structural-index.h"
+
+
+namespace kfs
+{
+
+
+struct IndexedScanner : public Scanner
+{
+public:
+	//! Builds the index for the source.
+	explicit IndexedScanner(const string_view source)
+		: Scanner(source)
+		, index_(source)
+	{
+	}
+
+	//! Uses an index that has already been built; the scanner's source is the
+	//! index's source.
+	explicit IndexedScanner(StructuralIndex&& index)
+		: Scanner(index.source())
+		, index_(std::move(index))
+	{
+	}
+
+	//! next has the same contract as Scanner::next.
+	TResult next();
+
+	//! next_batch has the same contract as Scanner::next_batch.
+	BatchResult next_batch(std::span<Token> out);
+	BatchResult next_batch(TokenBuffer& out, size_t limit);
+
+	//! The stage 1 index.
+	[[nodiscard]]
+	const StructuralIndex& index() const noexcept { return index_; }
+
+protected:
+	StructuralIndex		index_	{ };
+};
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_SCANNER_INDEXED_H
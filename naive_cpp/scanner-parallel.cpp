@@ -0,0 +1,141 @@
+// Serial and multi-threaded scanning of whole documents.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "scanner-parallel.h"
+#include "scanner.h"
+#include "scanner-simd.h"
+
+#include <thread>
+
+
+namespace kfs
+{
+
+
+namespace
+{
+
+// Scans [begin, end) of the source into a buffer over the whole source.
+ScanOutput scan_range(string_view source, size_t begin, size_t end)
+{
+	constexpr size_t batch_size = 4096;
+
+	ScanOutput output { TokenBuffer{ source } };
+	Scanner scanner(source.substr(begin, end - begin));
+	for (;;)
+	{
+		const auto batch = scanner.next_batch(output.tokens_, batch_size);
+		if (batch.is_error())
+			output.errors_.push_back(ScanError{ output.tokens_.size(), batch.error_ });
+		else if (batch.count_ < batch_size)
+			return output;
+	}
+}
+
+// Appends a chunk's tokens, and the first 'error_count' of its errors.
+void append_chunk(ScanOutput& output, const ScanOutput& chunk, size_t error_count)
+{
+	const size_t base = output.tokens_.size();
+	output.tokens_.append(chunk.tokens_);
+	for (size_t i = 0; i < error_count; ++i)
+		output.errors_.push_back(ScanError{ base + chunk.errors_[i].token_index_, chunk.errors_[i].error_ });
+}
+
+}
+
+
+ScanOutput scan_document(string_view source)
+{
+	return scan_range(source, 0, source.size());
+}
+
+
+ScanOutput scan_parallel(string_view source, size_t threads, size_t min_chunk)
+{
+	threads = std::min(threads, source.size() / std::max<size_t>(min_chunk, 1));
+	if (threads <= 1 || !TokenBuffer::can_hold(source))
+		return scan_document(source);
+
+	// Split just after the first newline past each even division of the source.
+	std::vector<size_t> bounds { 0 };
+	for (size_t i = 1; i < threads; ++i)
+	{
+		const size_t target = std::max(bounds.back(), source.size() / threads * i);
+		const size_t newline = target + simd::find_byte(source.data() + target, source.size() - target, '\n');
+		if (newline >= source.size())
+			break;
+		if (newline + 1 > bounds.back())
+			bounds.push_back(newline + 1);
+	}
+	bounds.push_back(source.size());
+
+	std::vector<ScanOutput> chunks(bounds.size() - 1);
+	{
+		std::vector<std::jthread> workers;
+		for (size_t i = 1; i < chunks.size(); ++i)
+			workers.emplace_back([&, i]() { chunks[i] = scan_range(source, bounds[i], bounds[i + 1]); });
+		chunks[0] = scan_range(source, bounds[0], bounds[1]);
+	}
+
+	// Stitch the chunks together; 'resume' is where the serial scan would pick up.
+	ScanOutput output { TokenBuffer{ source } };
+	size_t token_count = 0;
+	for (const auto& chunk : chunks)
+		token_count += chunk.tokens_.size();
+	output.tokens_.reserve(token_count);
+
+	size_t resume = 0;
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		const size_t end = bounds[i + 1];
+		if (resume >= end)
+			continue;	// Entirely inside a comment.
+
+		// If the previous chunk ended in a comment, this chunk's scan started in the
+		// wrong state, so redo it from where the comment closed.
+		ScanOutput rescan;
+		const ScanOutput* chunk = &chunks[i];
+		if (resume > bounds[i])
+		{
+			rescan = scan_range(source, resume, end);
+			chunk = &rescan;
+		}
+		resume = end;
+
+		size_t error_count = chunk->errors_.size();
+		if (error_count > 0 && i + 1 < chunks.size())
+		{
+			// A block comment that is unterminated at the end of the chunk may be
+			// closed in a later chunk.
+			const Token& token = chunk->errors_.back().error_.token();
+			const size_t offset = static_cast<size_t>(token.source_.data() - source.data());
+			if (token.type_ == Token::Type::OpenComment && offset + token.source_.length() == end)
+			{
+				size_t depth = 1;
+				const size_t close = offset + 2 + simd::skip_comment_body(source.data() + offset + 2, source.size() - offset - 2, depth);
+				if (depth == 0)
+				{
+					--error_count;
+					resume = close;
+				}
+				else
+				{
+					// It really is unterminated, and swallows the rest of the source.
+					append_chunk(output, *chunk, error_count - 1);
+					output.errors_.push_back(ScanError{ output.tokens_.size(),
+						TResult{ Token{ Token::Type::OpenComment, source.substr(offset) }, ErrorCode::UnterminatedComment } });
+					return output;
+				}
+			}
+		}
+
+		append_chunk(output, *chunk, error_count);
+	}
+
+	return output;
+}
+
+
+}
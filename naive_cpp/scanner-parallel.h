@@ -0,0 +1,65 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_SCANNER_PARALLEL_H
+#define INCLUDED_KFS_NAIVE_CPP_SCANNER_PARALLEL_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Scanning a whole document into a TokenBuffer, either serially or split across
+// several threads.
+//
+// The parallel scan splits the source into chunks that each start just after a
+// newline. No token, string or line comment can span a newline, so every chunk can
+// be scanned independently - speculatively assuming it doesn't start inside a block
+// comment. The chunks are then stitched together in order, and wherever a chunk
+// ended in an "unterminated" block comment we find where the comment really ends
+// and rescan from there, discarding whatever the later chunk(s) thought they saw.
+// The result is identical to the serial scan.
+
+
+#include "token-buffer.h"
+#include "tresult.h"
+
+#include <vector>
+
+
+namespace kfs
+{
+
+
+//! An error encountered while scanning a document, and how many tokens preceded it.
+struct ScanError
+{
+	size_t	token_index_	{0};
+	TResult	error_			{ };
+
+	bool operator == (const ScanError&) const = default;
+};
+
+
+//! Everything scanning a document produces: the tokens, and any errors, after each of
+//! which scanning resumed.
+struct ScanOutput
+{
+	TokenBuffer				tokens_	{ };
+	std::vector<ScanError>	errors_	{ };
+
+	bool operator == (const ScanOutput&) const = default;
+};
+
+
+//! Scans the whole of 'source' on the calling thread.
+[[nodiscard]]
+ScanOutput scan_document(string_view source);
+
+//! Chunks smaller than this aren't worth a thread.
+constexpr size_t kMinParallelChunk = 64 * 1024;
+
+//! Scans 'source' using up to 'threads' threads (including the calling thread), with
+//! chunks of at least 'min_chunk' bytes. The result is identical to scan_document.
+[[nodiscard]]
+ScanOutput scan_parallel(string_view source, size_t threads, size_t min_chunk = kMinParallelChunk);
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_SCANNER_PARALLEL_H
@@ -0,0 +1,81 @@
+// Unit tests for whole-document scanning: the parallel scan must be identical to the
+// serial one however the document is split.
+
+#include "scanner-parallel.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+using namespace kfs;
+
+
+TEST(ScanDocumentTest, TokensAndErrors)
+{
+	const string_view source = "a ~ b \"open\nc";
+	const auto output = scan_document(source);
+	ASSERT_EQ(3, output.tokens_.size());
+	EXPECT_EQ("a", output.tokens_.text(0));
+	EXPECT_EQ("b", output.tokens_.text(1));
+	EXPECT_EQ("c", output.tokens_.text(2));
+	ASSERT_EQ(2, output.errors_.size());
+	EXPECT_EQ(1, output.errors_[0].token_index_);
+	EXPECT_EQ("unexpected character", output.errors_[0].error_.error());
+	EXPECT_EQ(2, output.errors_[1].token_index_);
+	EXPECT_EQ("unterminated string", output.errors_[1].error_.error());
+}
+
+
+TEST(ScanParallelTest, SmallDocumentsAreSerial)
+{
+	const string_view source = "type T { int x }\n";
+	EXPECT_EQ(scan_document(source), scan_parallel(source, 8));
+}
+
+
+// Block comments that span one or many chunk boundaries, or never end.
+TEST(ScanParallelTest, CommentsAcrossChunks)
+{
+	std::string source;
+	for (int i = 0; i < 40; ++i)
+	{
+		source += "type T" + std::to_string(i) + " { int x = " + std::to_string(i) + " }\n";
+		if (i % 7 == 3)
+			source += "/* opened here\n" + std::string(i * 10, '\n') + "/* nested */\n" + std::string(i * 5, '\n') + "*/ x = 1\n";
+		if (i % 11 == 5)
+			source += "\"unterminated\n/* a short comment */ ~\n";
+	}
+	const auto expected = scan_document(source);
+	ASSERT_GT(expected.tokens_.size(), 300);
+
+	for (size_t threads = 1; threads <= 16; ++threads)
+	{
+		for (size_t min_chunk : { 1, 16, 100 })
+			ASSERT_EQ(expected, scan_parallel(source, threads, min_chunk)) << threads << " threads, min chunk " << min_chunk;
+	}
+
+	const std::string unterminated = source + "/* never closed /* even though this is */\n" + std::string(200, '\n') + "type X { y }\n";
+	const auto expected_unterminated = scan_document(unterminated);
+	ASSERT_FALSE(expected_unterminated.errors_.empty());
+	EXPECT_EQ(Token::Type::OpenComment, expected_unterminated.errors_.back().error_.token().type_);
+	for (size_t threads = 1; threads <= 16; ++threads)
+		ASSERT_EQ(expected_unterminated, scan_parallel(unterminated, threads, 1)) << threads << " threads";
+}
+
+
+TEST(ScanParallelTest, AgreesOnMixedInput)
+{
+	static const char* fragments[] = {
+		" ", "\n", "\r\n", "enum", "Name", "123", "4.5", "+.", "\"text\"", "\"unterminated\n", "\"\\\"\\\\\"",
+		"{", "}", "::", ",", "// comment\n", "/* block */", "/* multi\nline\n*/", "/*", "*/", "~",
+	};
+	std::mt19937 rng(2024);
+	std::string source;
+	while (source.size() < 256 * 1024)
+		source += fragments[rng() % std::size(fragments)];
+
+	const auto expected = scan_document(source);
+	for (size_t threads : { 2, 3, 4, 7, 16, 64 })
+		ASSERT_EQ(expected, scan_parallel(source, threads, 1024)) << threads << " threads";
+}
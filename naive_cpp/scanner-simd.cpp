@@ -0,0 +1,797 @@
+// Character-class kernels for the Scanner, with runtime selection by cpu feature.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "scanner-simd.h"
+
+#include <atomic>
+#include <bit>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#	define KFS_SIMD_X86 1
+#	define KFS_TARGET(isa) __attribute__((target(isa)))
+#	include <immintrin.h>
+#else
+#	define KFS_SIMD_X86 0
+#endif
+
+
+namespace kfs::simd
+{
+
+using namespace std::string_view_literals;
+
+
+namespace
+{
+
+/* ---------- Scalar: the reference implementations ---------- */
+
+constexpr bool is_whitespace(const char c) noexcept
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+constexpr bool is_digit(const char c) noexcept
+{
+	return c >= '0' && c <= '9';
+}
+
+constexpr bool is_word(const char c) noexcept
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || is_digit(c) || c == '_';
+}
+
+constexpr bool is_string_delim(const char c) noexcept
+{
+	return c == '"' || c == '\\' || c == '\r' || c == '\n';
+}
+
+constexpr bool is_comment_delim(const char c) noexcept
+{
+	return c == '/' || c == '*';
+}
+
+template<bool (*Pred)(char)>
+size_t scalar_span(const char* data, size_t len) noexcept
+{
+	size_t i = 0;
+	while (i < len && Pred(data[i]))
+		++i;
+	return i;
+}
+
+template<bool (*Pred)(char)>
+size_t scalar_find(const char* data, size_t len) noexcept
+{
+	size_t i = 0;
+	while (i < len && !Pred(data[i]))
+		++i;
+	return i;
+}
+
+size_t scalar_span_whitespace(const char* data, size_t len) noexcept { return scalar_span<is_whitespace>(data, len); }
+size_t scalar_span_word(const char* data, size_t len) noexcept { return scalar_span<is_word>(data, len); }
+size_t scalar_span_digits(const char* data, size_t len) noexcept { return scalar_span<is_digit>(data, len); }
+size_t scalar_find_string_delim(const char* data, size_t len) noexcept { return scalar_find<is_string_delim>(data, len); }
+size_t scalar_find_comment_delim(const char* data, size_t len) noexcept { return scalar_find<is_comment_delim>(data, len); }
+
+size_t scalar_find_byte(const char* data, size_t len, char byte) noexcept
+{
+	size_t i = 0;
+	while (i < len && data[i] != byte)
+		++i;
+	return i;
+}
+
+constexpr bool is_structural(const char c) noexcept
+{
+	return c == '{' || c == '}' || c == '[' || c == ']' || c == '=' || c == ':' || c == ',';
+}
+
+// The block kernels always see a full 64 bytes; classify_block pads short blocks.
+BlockMasks scalar_classify_block(const char* data) noexcept
+{
+	BlockMasks masks {};
+	for (size_t i = 0; i < 64; ++i)
+	{
+		const uint64_t bit = uint64_t(1) << i;
+		const char c = data[i];
+		masks.whitespace_ |= is_whitespace(c) ? bit : 0;
+		masks.structural_ |= is_structural(c) ? bit : 0;
+		masks.quote_      |= c == '"' ? bit : 0;
+		masks.backslash_  |= c == '\\' ? bit : 0;
+		masks.slash_      |= c == '/' ? bit : 0;
+		masks.star_       |= c == '*' ? bit : 0;
+		masks.newline_    |= c == '\n' ? bit : 0;
+		masks.return_     |= c == '\r' ? bit : 0;
+	}
+	return masks;
+}
+
+
+/* ---------- SWAR: 8 bytes at a time in a general purpose register ---------- */
+//
+// Each helper produces a mask with 0x80 set in every byte lane that matched. The
+// formulations avoid carries between lanes so that every lane is exact, not just
+// the first.
+
+constexpr uint64_t kOnes  = 0x0101010101010101ULL;
+constexpr uint64_t kLows  = 0x7F7F7F7F7F7F7F7FULL;
+constexpr uint64_t kHighs = 0x8080808080808080ULL;
+
+inline uint64_t load64(const char* data) noexcept
+{
+	uint64_t v;
+	std::memcpy(&v, data, sizeof(v));
+	return v;
+}
+
+// 0x80 in each lane of v that is zero.
+constexpr uint64_t zero_lanes(uint64_t v) noexcept
+{
+	return ~(((v & kLows) + kLows) | v | kLows);
+}
+
+// 0x80 in each lane of v that equals c.
+constexpr uint64_t eq_lanes(uint64_t v, uint8_t c) noexcept
+{
+	return zero_lanes(v ^ (kOnes * c));
+}
+
+// 0x80 in each lane of v that is in the ascii range [lo, hi]; 0 < lo <= hi < 0x80.
+constexpr uint64_t range_lanes(uint64_t v, uint8_t lo, uint8_t hi) noexcept
+{
+	const uint64_t low7 = v & kLows;
+	const uint64_t ge_lo = low7 + kOnes * uint8_t(0x80 - lo);
+	const uint64_t gt_hi = low7 + kOnes * uint8_t(0x7F - hi);
+	return ge_lo & ~gt_hi & ~v & kHighs;
+}
+
+constexpr uint64_t whitespace_lanes(uint64_t v) noexcept
+{
+	return eq_lanes(v, ' ') | eq_lanes(v, '\t') | eq_lanes(v, '\r') | eq_lanes(v, '\n');
+}
+
+constexpr uint64_t word_lanes(uint64_t v) noexcept
+{
+	return range_lanes(v | (kOnes * 0x20), 'a', 'z') | range_lanes(v, '0', '9') | eq_lanes(v, '_');
+}
+
+constexpr uint64_t digit_lanes(uint64_t v) noexcept
+{
+	return range_lanes(v, '0', '9');
+}
+
+constexpr uint64_t string_delim_lanes(uint64_t v) noexcept
+{
+	return eq_lanes(v, '"') | eq_lanes(v, '\\') | eq_lanes(v, '\r') | eq_lanes(v, '\n');
+}
+
+constexpr uint64_t comment_delim_lanes(uint64_t v) noexcept
+{
+	return eq_lanes(v, '/') | eq_lanes(v, '*');
+}
+
+// Span while lanes match, finishing the tail with the scalar version.
+template<uint64_t (*Lanes)(uint64_t), bool (*Pred)(char)>
+size_t swar_span(const char* data, size_t len) noexcept
+{
+	size_t i = 0;
+	if constexpr (std::endian::native == std::endian::little)
+	{
+		for ( ; i + 8 <= len; i += 8)
+		{
+			if (const uint64_t miss = ~Lanes(load64(data + i)) & kHighs; miss != 0)
+				return i + std::countr_zero(miss) / 8;
+		}
+	}
+	return i + scalar_span<Pred>(data + i, len - i);
+}
+
+// Find the first lane that matches, finishing the tail with the scalar version.
+template<uint64_t (*Lanes)(uint64_t), bool (*Pred)(char)>
+size_t swar_find(const char* data, size_t len) noexcept
+{
+	size_t i = 0;
+	if constexpr (std::endian::native == std::endian::little)
+	{
+		for ( ; i + 8 <= len; i += 8)
+		{
+			if (const uint64_t hit = Lanes(load64(data + i)); hit != 0)
+				return i + std::countr_zero(hit) / 8;
+		}
+	}
+	return i + scalar_find<Pred>(data + i, len - i);
+}
+
+size_t swar_span_whitespace(const char* data, size_t len) noexcept { return swar_span<whitespace_lanes, is_whitespace>(data, len); }
+size_t swar_span_word(const char* data, size_t len) noexcept { return swar_span<word_lanes, is_word>(data, len); }
+size_t swar_span_digits(const char* data, size_t len) noexcept { return swar_span<digit_lanes, is_digit>(data, len); }
+size_t swar_find_string_delim(const char* data, size_t len) noexcept { return swar_find<string_delim_lanes, is_string_delim>(data, len); }
+size_t swar_find_comment_delim(const char* data, size_t len) noexcept { return swar_find<comment_delim_lanes, is_comment_delim>(data, len); }
+
+size_t swar_find_byte(const char* data, size_t len, char byte) noexcept
+{
+	size_t i = 0;
+	if constexpr (std::endian::native == std::endian::little)
+	{
+		for ( ; i + 8 <= len; i += 8)
+		{
+			if (const uint64_t hit = eq_lanes(load64(data + i), uint8_t(byte)); hit != 0)
+				return i + std::countr_zero(hit) / 8;
+		}
+	}
+	return i + scalar_find_byte(data + i, len - i, byte);
+}
+
+// Gathers the 0x80 of each lane into the low 8 bits, lane 0 in bit 0; the multiply
+// shifts each lane's bit into the top byte without any of the products colliding.
+constexpr uint64_t pack_lanes(uint64_t lanes) noexcept
+{
+	return ((lanes >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+constexpr uint64_t structural_lanes(uint64_t v) noexcept
+{
+	return eq_lanes(v, '{') | eq_lanes(v, '}') | eq_lanes(v, '[') | eq_lanes(v, ']')
+	     | eq_lanes(v, '=') | eq_lanes(v, ':') | eq_lanes(v, ',');
+}
+
+BlockMasks swar_classify_block(const char* data) noexcept
+{
+	if constexpr (std::endian::native != std::endian::little)
+		return scalar_classify_block(data);
+
+	BlockMasks masks {};
+	for (size_t i = 0; i < 64; i += 8)
+	{
+		const uint64_t v = load64(data + i);
+		masks.whitespace_ |= pack_lanes(whitespace_lanes(v)) << i;
+		masks.structural_ |= pack_lanes(structural_lanes(v)) << i;
+		masks.quote_      |= pack_lanes(eq_lanes(v, '"')) << i;
+		masks.backslash_  |= pack_lanes(eq_lanes(v, '\\')) << i;
+		masks.slash_      |= pack_lanes(eq_lanes(v, '/')) << i;
+		masks.star_       |= pack_lanes(eq_lanes(v, '*')) << i;
+		masks.newline_    |= pack_lanes(eq_lanes(v, '\n')) << i;
+		masks.return_     |= pack_lanes(eq_lanes(v, '\r')) << i;
+	}
+	return masks;
+}
+
+
+#if KFS_SIMD_X86
+
+/* ---------- SSE4.2: 16 bytes at a time using the string-compare instructions ---------- */
+
+// Character sets/ranges for pcmpestri; explicit lengths so that a '\0' in the
+// input isn't treated as a terminator.
+constexpr int kSSEFlags = _SIDD_UBYTE_OPS | _SIDD_LEAST_SIGNIFICANT;
+
+template<int Mode>
+KFS_TARGET("sse4.2")
+inline size_t sse42_scan(const char* data, size_t len, __m128i set, int set_len, size_t (*tail)(const char*, size_t) noexcept) noexcept
+{
+	size_t i = 0;
+	for ( ; i + 16 <= len; i += 16)
+	{
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		if (const int idx = _mm_cmpestri(set, set_len, chunk, 16, Mode); idx < 16)
+			return i + idx;
+	}
+	return i + tail(data + i, len - i);
+}
+
+KFS_TARGET("sse4.2")
+size_t sse42_span_whitespace(const char* data, size_t len) noexcept
+{
+	const __m128i set = _mm_setr_epi8(' ', '\t', '\r', '\n', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	return sse42_scan<kSSEFlags | _SIDD_CMP_EQUAL_ANY | _SIDD_NEGATIVE_POLARITY>(data, len, set, 4, swar_span_whitespace);
+}
+
+KFS_TARGET("sse4.2")
+size_t sse42_span_word(const char* data, size_t len) noexcept
+{
+	const __m128i set = _mm_setr_epi8('a', 'z', 'A', 'Z', '0', '9', '_', '_', 0, 0, 0, 0, 0, 0, 0, 0);
+	return sse42_scan<kSSEFlags | _SIDD_CMP_RANGES | _SIDD_NEGATIVE_POLARITY>(data, len, set, 8, swar_span_word);
+}
+
+KFS_TARGET("sse4.2")
+size_t sse42_span_digits(const char* data, size_t len) noexcept
+{
+	const __m128i set = _mm_setr_epi8('0', '9', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	return sse42_scan<kSSEFlags | _SIDD_CMP_RANGES | _SIDD_NEGATIVE_POLARITY>(data, len, set, 2, swar_span_digits);
+}
+
+KFS_TARGET("sse4.2")
+size_t sse42_find_string_delim(const char* data, size_t len) noexcept
+{
+	const __m128i set = _mm_setr_epi8('"', '\\', '\r', '\n', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	return sse42_scan<kSSEFlags | _SIDD_CMP_EQUAL_ANY>(data, len, set, 4, swar_find_string_delim);
+}
+
+KFS_TARGET("sse4.2")
+size_t sse42_find_comment_delim(const char* data, size_t len) noexcept
+{
+	const __m128i set = _mm_setr_epi8('/', '*', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	return sse42_scan<kSSEFlags | _SIDD_CMP_EQUAL_ANY>(data, len, set, 2, swar_find_comment_delim);
+}
+
+// A single byte doesn't need the string instructions, a plain compare will do.
+KFS_TARGET("sse4.2")
+size_t sse42_find_byte(const char* data, size_t len, char byte) noexcept
+{
+	const __m128i needle = _mm_set1_epi8(byte);
+	size_t i = 0;
+	for ( ; i + 16 <= len; i += 16)
+	{
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		if (const auto mask = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle))); mask != 0)
+			return i + std::countr_zero(mask);
+	}
+	return i + swar_find_byte(data + i, len - i, byte);
+}
+
+KFS_TARGET("sse4.2")
+inline uint64_t sse42_eq(__m128i v, char c) noexcept
+{
+	return uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)))));
+}
+
+KFS_TARGET("sse4.2")
+BlockMasks sse42_classify_block(const char* data) noexcept
+{
+	BlockMasks masks {};
+	for (size_t i = 0; i < 64; i += 16)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		const uint64_t newline = sse42_eq(v, '\n'), ret = sse42_eq(v, '\r');
+		masks.whitespace_ |= (sse42_eq(v, ' ') | sse42_eq(v, '\t') | newline | ret) << i;
+		masks.structural_ |= (sse42_eq(v, '{') | sse42_eq(v, '}') | sse42_eq(v, '[') | sse42_eq(v, ']')
+		                    | sse42_eq(v, '=') | sse42_eq(v, ':') | sse42_eq(v, ',')) << i;
+		masks.quote_      |= sse42_eq(v, '"') << i;
+		masks.backslash_  |= sse42_eq(v, '\\') << i;
+		masks.slash_      |= sse42_eq(v, '/') << i;
+		masks.star_       |= sse42_eq(v, '*') << i;
+		masks.newline_    |= newline << i;
+		masks.return_     |= ret << i;
+	}
+	return masks;
+}
+
+
+/* ---------- AVX2: 32 bytes at a time ---------- */
+
+KFS_TARGET("avx2")
+inline __m256i avx2_eq(__m256i v, char c) noexcept
+{
+	return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+// Bytes in an ascii range; non-ascii bytes are negative as signed and never match.
+KFS_TARGET("avx2")
+inline __m256i avx2_range(__m256i v, char lo, char hi) noexcept
+{
+	return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(char(lo - 1))),
+	                        _mm256_cmpgt_epi8(_mm256_set1_epi8(char(hi + 1)), v));
+}
+
+KFS_TARGET("avx2")
+inline uint32_t avx2_whitespace(__m256i v) noexcept
+{
+	return uint32_t(_mm256_movemask_epi8(
+		_mm256_or_si256(_mm256_or_si256(avx2_eq(v, ' '), avx2_eq(v, '\t')),
+		                _mm256_or_si256(avx2_eq(v, '\r'), avx2_eq(v, '\n')))));
+}
+
+KFS_TARGET("avx2")
+inline uint32_t avx2_word(__m256i v) noexcept
+{
+	const __m256i alpha = avx2_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+	return uint32_t(_mm256_movemask_epi8(
+		_mm256_or_si256(alpha, _mm256_or_si256(avx2_range(v, '0', '9'), avx2_eq(v, '_')))));
+}
+
+KFS_TARGET("avx2")
+inline uint32_t avx2_digits(__m256i v) noexcept
+{
+	return uint32_t(_mm256_movemask_epi8(avx2_range(v, '0', '9')));
+}
+
+KFS_TARGET("avx2")
+inline uint32_t avx2_string_delim(__m256i v) noexcept
+{
+	return uint32_t(_mm256_movemask_epi8(
+		_mm256_or_si256(_mm256_or_si256(avx2_eq(v, '"'), avx2_eq(v, '\\')), _mm256_or_si256(avx2_eq(v, '\r'), avx2_eq(v, '\n')))));
+}
+
+KFS_TARGET("avx2")
+inline uint32_t avx2_comment_delim(__m256i v) noexcept
+{
+	return uint32_t(_mm256_movemask_epi8(_mm256_or_si256(avx2_eq(v, '/'), avx2_eq(v, '*'))));
+}
+
+template<uint32_t (*Lanes)(__m256i) noexcept, bool Invert>
+KFS_TARGET("avx2")
+inline size_t avx2_scan(const char* data, size_t len, size_t (*tail)(const char*, size_t) noexcept) noexcept
+{
+	size_t i = 0;
+	for ( ; i + 32 <= len; i += 32)
+	{
+		uint32_t mask = Lanes(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+		if constexpr (Invert)
+			mask = ~mask;
+		if (mask != 0)
+			return i + std::countr_zero(mask);
+	}
+	return i + tail(data + i, len - i);
+}
+
+KFS_TARGET("avx2")
+size_t avx2_span_whitespace(const char* data, size_t len) noexcept { return avx2_scan<avx2_whitespace, true>(data, len, swar_span_whitespace); }
+KFS_TARGET("avx2")
+size_t avx2_span_word(const char* data, size_t len) noexcept { return avx2_scan<avx2_word, true>(data, len, swar_span_word); }
+KFS_TARGET("avx2")
+size_t avx2_span_digits(const char* data, size_t len) noexcept { return avx2_scan<avx2_digits, true>(data, len, swar_span_digits); }
+KFS_TARGET("avx2")
+size_t avx2_find_string_delim(const char* data, size_t len) noexcept { return avx2_scan<avx2_string_delim, false>(data, len, swar_find_string_delim); }
+KFS_TARGET("avx2")
+size_t avx2_find_comment_delim(const char* data, size_t len) noexcept { return avx2_scan<avx2_comment_delim, false>(data, len, swar_find_comment_delim); }
+
+KFS_TARGET("avx2")
+size_t avx2_find_byte(const char* data, size_t len, char byte) noexcept
+{
+	size_t i = 0;
+	for ( ; i + 32 <= len; i += 32)
+	{
+		if (const uint32_t mask = uint32_t(_mm256_movemask_epi8(avx2_eq(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), byte))); mask != 0)
+			return i + std::countr_zero(mask);
+	}
+	return i + swar_find_byte(data + i, len - i, byte);
+}
+
+KFS_TARGET("avx2")
+inline uint64_t avx2_eq_mask(__m256i v, char c) noexcept
+{
+	return uint64_t(uint32_t(_mm256_movemask_epi8(avx2_eq(v, c))));
+}
+
+KFS_TARGET("avx2")
+BlockMasks avx2_classify_block(const char* data) noexcept
+{
+	BlockMasks masks {};
+	for (size_t i = 0; i < 64; i += 32)
+	{
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		const uint64_t newline = avx2_eq_mask(v, '\n'), ret = avx2_eq_mask(v, '\r');
+		masks.whitespace_ |= (avx2_eq_mask(v, ' ') | avx2_eq_mask(v, '\t') | newline | ret) << i;
+		masks.structural_ |= (avx2_eq_mask(v, '{') | avx2_eq_mask(v, '}') | avx2_eq_mask(v, '[') | avx2_eq_mask(v, ']')
+		                    | avx2_eq_mask(v, '=') | avx2_eq_mask(v, ':') | avx2_eq_mask(v, ',')) << i;
+		masks.quote_      |= avx2_eq_mask(v, '"') << i;
+		masks.backslash_  |= avx2_eq_mask(v, '\\') << i;
+		masks.slash_      |= avx2_eq_mask(v, '/') << i;
+		masks.star_       |= avx2_eq_mask(v, '*') << i;
+		masks.newline_    |= newline << i;
+		masks.return_     |= ret << i;
+	}
+	return masks;
+}
+
+
+/* ---------- AVX-512BW: 64 bytes at a time into mask registers ---------- */
+
+#define KFS_AVX512 KFS_TARGET("avx512f,avx512bw")
+
+KFS_AVX512
+inline uint64_t avx512_eq(__m512i v, char c) noexcept
+{
+	return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(c));
+}
+
+KFS_AVX512
+inline uint64_t avx512_range(__m512i v, char lo, char hi) noexcept
+{
+	return _mm512_cmpgt_epi8_mask(v, _mm512_set1_epi8(char(lo - 1)))
+	     & _mm512_cmplt_epi8_mask(v, _mm512_set1_epi8(char(hi + 1)));
+}
+
+KFS_AVX512
+inline uint64_t avx512_whitespace(__m512i v) noexcept
+{
+	return avx512_eq(v, ' ') | avx512_eq(v, '\t') | avx512_eq(v, '\r') | avx512_eq(v, '\n');
+}
+
+KFS_AVX512
+inline uint64_t avx512_word(__m512i v) noexcept
+{
+	return avx512_range(_mm512_or_si512(v, _mm512_set1_epi8(0x20)), 'a', 'z')
+	     | avx512_range(v, '0', '9') | avx512_eq(v, '_');
+}
+
+KFS_AVX512
+inline uint64_t avx512_digits(__m512i v) noexcept
+{
+	return avx512_range(v, '0', '9');
+}
+
+KFS_AVX512
+inline uint64_t avx512_string_delim(__m512i v) noexcept
+{
+	return avx512_eq(v, '"') | avx512_eq(v, '\\') | avx512_eq(v, '\r') | avx512_eq(v, '\n');
+}
+
+KFS_AVX512
+inline uint64_t avx512_comment_delim(__m512i v) noexcept
+{
+	return avx512_eq(v, '/') | avx512_eq(v, '*');
+}
+
+template<uint64_t (*Lanes)(__m512i) noexcept, bool Invert>
+KFS_AVX512
+inline size_t avx512_scan(const char* data, size_t len, size_t (*tail)(const char*, size_t) noexcept) noexcept
+{
+	size_t i = 0;
+	for ( ; i + 64 <= len; i += 64)
+	{
+		uint64_t mask = Lanes(_mm512_loadu_si512(data + i));
+		if constexpr (Invert)
+			mask = ~mask;
+		if (mask != 0)
+			return i + std::countr_zero(mask);
+	}
+	return i + tail(data + i, len - i);
+}
+
+KFS_AVX512
+size_t avx512_span_whitespace(const char* data, size_t len) noexcept { return avx512_scan<avx512_whitespace, true>(data, len, swar_span_whitespace); }
+KFS_AVX512
+size_t avx512_span_word(const char* data, size_t len) noexcept { return avx512_scan<avx512_word, true>(data, len, swar_span_word); }
+KFS_AVX512
+size_t avx512_span_digits(const char* data, size_t len) noexcept { return avx512_scan<avx512_digits, true>(data, len, swar_span_digits); }
+KFS_AVX512
+size_t avx512_find_string_delim(const char* data, size_t len) noexcept { return avx512_scan<avx512_string_delim, false>(data, len, swar_find_string_delim); }
+KFS_AVX512
+size_t avx512_find_comment_delim(const char* data, size_t len) noexcept { return avx512_scan<avx512_comment_delim, false>(data, len, swar_find_comment_delim); }
+
+KFS_AVX512
+size_t avx512_find_byte(const char* data, size_t len, char byte) noexcept
+{
+	size_t i = 0;
+	for ( ; i + 64 <= len; i += 64)
+	{
+		if (const uint64_t mask = avx512_eq(_mm512_loadu_si512(data + i), byte); mask != 0)
+			return i + std::countr_zero(mask);
+	}
+	return i + swar_find_byte(data + i, len - i, byte);
+}
+
+KFS_AVX512
+BlockMasks avx512_classify_block(const char* data) noexcept
+{
+	const __m512i v = _mm512_loadu_si512(data);
+	BlockMasks masks {};
+	masks.newline_    = avx512_eq(v, '\n');
+	masks.return_     = avx512_eq(v, '\r');
+	masks.whitespace_ = avx512_eq(v, ' ') | avx512_eq(v, '\t') | masks.newline_ | masks.return_;
+	masks.structural_ = avx512_eq(v, '{') | avx512_eq(v, '}') | avx512_eq(v, '[') | avx512_eq(v, ']')
+	                  | avx512_eq(v, '=') | avx512_eq(v, ':') | avx512_eq(v, ',');
+	masks.quote_      = avx512_eq(v, '"');
+	masks.backslash_  = avx512_eq(v, '\\');
+	masks.slash_      = avx512_eq(v, '/');
+	masks.star_       = avx512_eq(v, '*');
+	return masks;
+}
+
+#undef KFS_AVX512
+
+#endif  // KFS_SIMD_X86
+
+
+/* ---------- Dispatch ---------- */
+
+using KernelFn = size_t (*)(const char*, size_t) noexcept;
+using ByteKernelFn = size_t (*)(const char*, size_t, char) noexcept;
+using BlockKernelFn = BlockMasks (*)(const char*) noexcept;
+
+struct Kernels
+{
+	Level		level_;
+	KernelFn	span_whitespace_;
+	KernelFn	span_word_;
+	KernelFn	span_digits_;
+	KernelFn	find_string_delim_;
+	KernelFn	find_comment_delim_;
+	ByteKernelFn find_byte_;
+	BlockKernelFn classify_block_;
+};
+
+constexpr Kernels kScalarKernels { Level::Scalar, scalar_span_whitespace, scalar_span_word, scalar_span_digits, scalar_find_string_delim, scalar_find_comment_delim, scalar_find_byte, scalar_classify_block };
+constexpr Kernels kSwarKernels   { Level::Swar, swar_span_whitespace, swar_span_word, swar_span_digits, swar_find_string_delim, swar_find_comment_delim, swar_find_byte, swar_classify_block };
+// The SWAR kernels again, at their own address, for "not yet chosen".
+constexpr Kernels kStartupKernels = kSwarKernels;
+#if KFS_SIMD_X86
+constexpr Kernels kSSE42Kernels  { Level::SSE42, sse42_span_whitespace, sse42_span_word, sse42_span_digits, sse42_find_string_delim, sse42_find_comment_delim, sse42_find_byte, sse42_classify_block };
+constexpr Kernels kAVX2Kernels   { Level::AVX2, avx2_span_whitespace, avx2_span_word, avx2_span_digits, avx2_find_string_delim, avx2_find_comment_delim, avx2_find_byte, avx2_classify_block };
+constexpr Kernels kAVX512Kernels { Level::AVX512, avx512_span_whitespace, avx512_span_word, avx512_span_digits, avx512_find_string_delim, avx512_find_comment_delim, avx512_find_byte, avx512_classify_block };
+#endif
+
+const Kernels* kernels_for(Level level) noexcept
+{
+	switch (level)
+	{
+	case Level::Scalar:	return &kScalarKernels;
+	case Level::Swar:	return &kSwarKernels;
+#if KFS_SIMD_X86
+	case Level::SSE42:	return &kSSE42Kernels;
+	case Level::AVX2:	return &kAVX2Kernels;
+	case Level::AVX512:	return &kAVX512Kernels;
+#endif
+	default:			return nullptr;
+	}
+}
+
+// The active kernels. They start as the SWAR kernels, constant-initialized so that
+// scanning works even from another translation unit's static initialization, and
+// the cpu's best level replaces them on first use unless set_level got there first.
+constinit std::atomic<const Kernels*> g_kernels { &kStartupKernels };
+
+const Kernels* kernels() noexcept
+{
+	const Kernels* current = g_kernels.load(std::memory_order_relaxed);
+	if (current == &kStartupKernels) [[unlikely]]
+	{
+		// On failure 'current' is whatever another thread chose.
+		const Kernels* detected = kernels_for(detected_level());
+		if (g_kernels.compare_exchange_strong(current, detected, std::memory_order_relaxed))
+			current = detected;
+	}
+	return current;
+}
+
+}
+
+
+string_view level_to_str(Level level) noexcept
+{
+	switch (level)
+	{
+	case Level::Scalar:	return "scalar"sv;
+	case Level::Swar:	return "swar"sv;
+	case Level::SSE42:	return "sse4.2"sv;
+	case Level::AVX2:	return "avx2"sv;
+	case Level::AVX512:	return "avx512"sv;
+	default:			return "<invalid level>"sv;
+	}
+}
+
+
+bool is_supported(Level level) noexcept
+{
+	switch (level)
+	{
+	case Level::Scalar:
+	case Level::Swar:
+		return true;
+#if KFS_SIMD_X86
+	case Level::SSE42:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse4.2");
+	case Level::AVX2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+	case Level::AVX512:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+	default:
+		return false;
+	}
+}
+
+
+Level detected_level() noexcept
+{
+	for (Level level : { Level::AVX512, Level::AVX2, Level::SSE42 })
+	{
+		if (is_supported(level))
+			return level;
+	}
+	return Level::Swar;
+}
+
+
+Level active_level() noexcept
+{
+	return kernels()->level_;
+}
+
+
+bool set_level(Level level) noexcept
+{
+	if (!is_supported(level))
+		return false;
+	g_kernels.store(kernels_for(level), std::memory_order_relaxed);
+	return true;
+}
+
+
+size_t span_whitespace(const char* data, size_t len) noexcept
+{
+	return kernels()->span_whitespace_(data, len);
+}
+
+
+size_t span_word(const char* data, size_t len) noexcept
+{
+	return kernels()->span_word_(data, len);
+}
+
+
+size_t span_digits(const char* data, size_t len) noexcept
+{
+	return kernels()->span_digits_(data, len);
+}
+
+
+size_t find_string_delim(const char* data, size_t len) noexcept
+{
+	return kernels()->find_string_delim_(data, len);
+}
+
+
+size_t find_comment_delim(const char* data, size_t len) noexcept
+{
+	return kernels()->find_comment_delim_(data, len);
+}
+
+
+size_t find_byte(const char* data, size_t len, char byte) noexcept
+{
+	return kernels()->find_byte_(data, len, byte);
+}
+
+
+// Only a '/' or a '*' can change the depth, so hop between them with the kernel and
+// pair each with the byte after it.
+size_t skip_comment_body(const char* data, size_t len, size_t& depth) noexcept
+{
+	size_t pos = 0;
+	while (depth > 0)
+	{
+		pos += kernels()->find_comment_delim_(data + pos, len - pos);
+		if (pos + 1 >= len)
+			return pos;		// Nothing, or a byte whose partner we haven't seen.
+		if (data[pos] == '/' && data[pos + 1] == '*')
+		{
+			++depth;
+			pos += 2;
+		}
+		else if (data[pos] == '*' && data[pos + 1] == '/')
+		{
+			--depth;
+			pos += 2;
+		}
+		else
+		{
+			++pos;
+		}
+	}
+	return pos;
+}
+
+
+BlockMasks classify_block(const char* data, size_t len) noexcept
+{
+	if (len >= 64)
+		return kernels()->classify_block_(data);
+
+	// Pad a short block with zeros, which aren't in any class.
+	char block[64] {};
+	std::memcpy(block, data, len);
+	return kernels()->classify_block_(block);
+}
+
+
+}
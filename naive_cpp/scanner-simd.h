@@ -0,0 +1,126 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_SCANNER_SIMD_H
+#define INCLUDED_KFS_NAIVE_CPP_SCANNER_SIMD_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Character-class kernels used by the Scanner's inner loops. Each kernel looks at
+// a run of bytes and reports how far a particular class of character extends, so
+// that the scanner can consume whole runs of whitespace/word/digit characters in
+// one step rather than a byte at a time through peek().
+//
+// Several implementations are provided - plain scalar, a portable SWAR version
+// that classifies 8 bytes per step, and SSE4.2/AVX2/AVX-512 versions for x86-64
+// that do 16/32/64 bytes per step. The best available set is chosen by checking the
+// CPU features the first time a kernel is used, but can be overridden (e.g. for
+// testing); both are safe to do from any thread.
+//
+// classify_block is the odd one out: rather than finding the end of a run, it
+// produces a bitmap per character class for a whole 64-byte block, which is what
+// the StructuralIndex is built from.
+
+
+#include "common.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace kfs::simd
+{
+
+
+//! Level enumerates the kernel implementations, in order of preference.
+enum class Level : uint8_t
+{
+	Scalar,		// Byte-at-a-time reference implementation.
+	Swar,		// SIMD-within-a-register, 8 bytes per step; portable.
+	SSE42,		// x86-64 SSE4.2 string instructions, 16 bytes per step.
+	AVX2,		// x86-64 AVX2, 32 bytes per step.
+	AVX512,		// x86-64 AVX-512BW, 64 bytes per step.
+};
+
+
+//! Returns a human readable name for a kernel level.
+[[nodiscard]]
+string_view level_to_str(Level level) noexcept;
+
+//! Returns true if the given level can be used on this cpu/build.
+[[nodiscard]]
+bool is_supported(Level level) noexcept;
+
+//! Returns the best level supported by this cpu/build.
+[[nodiscard]]
+Level detected_level() noexcept;
+
+//! Returns the level of the kernels currently in use.
+[[nodiscard]]
+Level active_level() noexcept;
+
+//! Selects the kernels for a particular level, returning false (and leaving the
+//! current selection unchanged) if the level is not supported.
+bool set_level(Level level) noexcept;
+
+
+//! Returns the number of leading bytes in [data, data+len) that are whitespace
+//! (space, tab, carriage-return or newline).
+[[nodiscard]]
+size_t span_whitespace(const char* data, size_t len) noexcept;
+
+//! Returns the number of leading bytes in [data, data+len) that are word
+//! characters ([A-Za-z0-9_]).
+[[nodiscard]]
+size_t span_word(const char* data, size_t len) noexcept;
+
+//! Returns the number of leading bytes in [data, data+len) that are decimal digits.
+[[nodiscard]]
+size_t span_digits(const char* data, size_t len) noexcept;
+
+//! Returns the offset of the first byte in [data, data+len) that terminates a
+//! string literal ('"', '\r' or '\n') or may begin an escape ('\\'), or len if
+//! there is none.
+[[nodiscard]]
+size_t find_string_delim(const char* data, size_t len) noexcept;
+
+//! Returns the offset of the first byte in [data, data+len) that could begin or end
+//! a block comment ('/' or '*'), or len if there is none.
+[[nodiscard]]
+size_t find_comment_delim(const char* data, size_t len) noexcept;
+
+//! Returns the offset of the first occurrence of 'byte' in [data, data+len), or
+//! len if there is none.
+[[nodiscard]]
+size_t find_byte(const char* data, size_t len, char byte) noexcept;
+
+//! Skips the body of a (nestable) block comment: 'depth' is the number of comments
+//! that are open at data[0], and is updated as "/*" and "*/" pairs are consumed.
+//! Returns the offset just past the "*/" that brings depth to 0; or, if the input
+//! runs out first, the offset at which scanning stopped, which is len or, when the
+//! final byte could be the first half of a pair, len - 1.
+size_t skip_comment_body(const char* data, size_t len, size_t& depth) noexcept;
+
+
+//! Bitmaps of the interesting characters in a block of 64 bytes: bit N of each mask
+//! describes byte N of the block.
+struct BlockMasks
+{
+	uint64_t	whitespace_	{0};	// ' ', '\t', '\r', '\n'
+	uint64_t	structural_	{0};	// '{', '}', '[', ']', '=', ':', ','
+	uint64_t	quote_		{0};	// '"'
+	uint64_t	backslash_	{0};	// '\\'
+	uint64_t	slash_		{0};	// '/'
+	uint64_t	star_		{0};	// '*'
+	uint64_t	newline_	{0};	// '\n'
+	uint64_t	return_		{0};	// '\r'
+
+	bool operator == (const BlockMasks&) const noexcept = default;
+};
+
+//! Classifies the bytes in [data, data+len), where len <= 64; bits beyond len are 0.
+[[nodiscard]]
+BlockMasks classify_block(const char* data, size_t len) noexcept;
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_SCANNER_SIMD_H
@@ -0,0 +1,268 @@
+// Unit tests for the scanner's character-class kernels.
+
+#include "scanner.h"
+#include "scanner-simd.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kfs;
+
+
+// Runs a test body once for each kernel level this cpu supports, restoring the
+// original selection afterwards.
+template<typename Body>
+void for_each_level(Body&& body)
+{
+	const simd::Level original = simd::active_level();
+	for (simd::Level level : { simd::Level::Scalar, simd::Level::Swar, simd::Level::SSE42, simd::Level::AVX2, simd::Level::AVX512 })
+	{
+		if (!simd::set_level(level))
+			continue;
+		SCOPED_TRACE(simd::level_to_str(level));
+		body(level);
+	}
+	simd::set_level(original);
+}
+
+
+// Scanned while this file's statics are initialized, before anything has chosen the
+// kernels, and in no particular order relative to scanner-simd.cpp's.
+const size_t g_static_span = simd::span_whitespace(" \t\r\nx", 5);
+
+
+TEST(ScannerSimdTest, UsableDuringStaticInitialization)
+{
+	EXPECT_EQ(4, g_static_span);
+}
+
+
+TEST(ScannerSimdTest, DetectedLevelIsSupported)
+{
+	EXPECT_TRUE(simd::is_supported(simd::Level::Scalar));
+	EXPECT_TRUE(simd::is_supported(simd::Level::Swar));
+	EXPECT_TRUE(simd::is_supported(simd::detected_level()));
+	EXPECT_EQ(simd::detected_level(), simd::active_level());
+}
+
+
+TEST(ScannerSimdTest, SetLevelFromAnyThread)
+{
+	const simd::Level original = simd::active_level();
+	std::vector<std::thread> threads;
+	for (simd::Level level : { simd::Level::Scalar, simd::Level::Swar, simd::detected_level() })
+	{
+		threads.emplace_back([level] {
+			for (int i = 0; i < 1000; ++i)
+			{
+				EXPECT_TRUE(simd::set_level(level));
+				EXPECT_EQ(4, simd::span_whitespace(" \t\r\nx", 5));
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+	simd::set_level(original);
+}
+
+
+// Each kernel must stop at exactly the same place as the scalar reference, no
+// matter where in a block the stopping character falls.
+TEST(ScannerSimdTest, KernelsAgreeAtEveryPosition)
+{
+	struct Case {
+		const char* name;
+		char        fill;
+		char        stop;
+		size_t      (*kernel)(const char*, size_t) noexcept;
+	} cases[] = {
+		{ "whitespace", '\t', 'x',  simd::span_whitespace },
+		{ "word",       'Q',  '-',  simd::span_word },
+		{ "word-hi",    '_',  '\x80', simd::span_word },
+		{ "digits",     '7',  '/',  simd::span_digits },
+		{ "delim",      'a',  '"',  simd::find_string_delim },
+		{ "delim-nl",   '\0', '\n', simd::find_string_delim },
+		{ "delim-bs",   'a',  '\\', simd::find_string_delim },
+		{ "comment",    '+',  '*',  simd::find_comment_delim },
+		{ "comment-sl", '\\', '/',  simd::find_comment_delim },
+		{ "newline",    '\r', '\n', [](const char* data, size_t len) noexcept { return simd::find_byte(data, len, '\n'); } },
+	};
+
+	for_each_level([&](simd::Level) {
+		for (const auto& c : cases)
+		{
+			SCOPED_TRACE(c.name);
+			for (size_t len = 0; len <= 150; ++len)
+			{
+				for (size_t stop = 0; stop <= len; ++stop)
+				{
+					std::string text(len, c.fill);
+					if (stop < len)
+						text[stop] = c.stop;
+					ASSERT_EQ(stop, c.kernel(text.data(), text.size())) << "len " << len << ", stop " << stop;
+				}
+			}
+		}
+	});
+}
+
+
+// Every byte value must be classified the same way by every level.
+TEST(ScannerSimdTest, KernelsAgreeForEveryByte)
+{
+	for_each_level([](simd::Level) {
+		for (int b = 0; b < 256; ++b)
+		{
+			SCOPED_TRACE(b);
+			// Put the byte at the end of a run of 100 bytes so that it lands in a
+			// vector block rather than the tail.
+			const auto c = static_cast<char>(b);
+			const bool ws = c == ' ' || c == '\t' || c == '\r' || c == '\n';
+			const bool digit = c >= '0' && c <= '9';
+			const bool word = digit || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+			const bool delim = c == '"' || c == '\\' || c == '\r' || c == '\n';
+			const bool comment = c == '/' || c == '*';
+
+			std::string text = std::string(99, ' ') + c + std::string(28, '!');
+			EXPECT_EQ(ws ? 100 : 99, simd::span_whitespace(text.data(), text.size()));
+			text = std::string(99, 'z') + c + std::string(28, '!');
+			EXPECT_EQ(word ? 100 : 99, simd::span_word(text.data(), text.size()));
+			text = std::string(99, '0') + c + std::string(28, '!');
+			EXPECT_EQ(digit ? 100 : 99, simd::span_digits(text.data(), text.size()));
+			text = std::string(99, '.') + c + std::string(28, '"');
+			EXPECT_EQ(delim ? 99 : 100, simd::find_string_delim(text.data(), text.size()));
+			text = std::string(99, '.') + c + std::string(28, '/');
+			EXPECT_EQ(comment ? 99 : 100, simd::find_comment_delim(text.data(), text.size()));
+			text = std::string(99, c == '.' ? ',' : '.') + c + std::string(28, '.');
+			EXPECT_EQ(99, simd::find_byte(text.data(), text.size(), c));
+		}
+	});
+}
+
+
+// The block classifier must set exactly the bits the scalar version does, for every
+// byte value at every position, and for short blocks.
+TEST(ScannerSimdTest, ClassifyBlockAgrees)
+{
+	std::mt19937 rng(99);
+	std::vector<std::string> blocks;
+	for (int b = 0; b < 256; ++b)
+	{
+		for (size_t pos : { 0, 7, 8, 31, 32, 63 })
+		{
+			std::string block(64, 'x');
+			block[pos] = static_cast<char>(b);
+			blocks.push_back(block);
+		}
+	}
+	const string_view alphabet = " \t\r\n{}[]=:,\"\\/*ab\x80";
+	for (int i = 0; i < 1000; ++i)
+	{
+		std::string block(64, ' ');
+		for (auto& c : block)
+			c = alphabet[rng() % alphabet.size()];
+		blocks.push_back(block);
+	}
+
+	const simd::Level original = simd::active_level();
+	simd::set_level(simd::Level::Scalar);
+	std::vector<simd::BlockMasks> reference;
+	for (const auto& block : blocks)
+		for (size_t len : { 64, 63, 17, 1, 0 })
+			reference.push_back(simd::classify_block(block.data(), len));
+	simd::set_level(original);
+
+	EXPECT_EQ(1ULL << 5, simd::classify_block("abcde\"", 6).quote_);
+	EXPECT_EQ(0ULL, simd::classify_block("abcde\"", 5).quote_);
+
+	for_each_level([&](simd::Level) {
+		size_t index = 0;
+		for (const auto& block : blocks)
+		{
+			for (size_t len : { 64, 63, 17, 1, 0 })
+				ASSERT_EQ(reference[index++], simd::classify_block(block.data(), len)) << "block |" << block << "| len " << len;
+		}
+	});
+}
+
+
+// Comment bodies nest, and a trailing byte that might be half of a pair is left
+// unconsumed so that streaming callers can resume once they have the other half.
+TEST(ScannerSimdTest, SkipCommentBody)
+{
+	struct Case {
+		string_view body;
+		size_t      depth_in;
+		size_t      end;
+		size_t      depth_out;
+	} cases[] = {
+		{ "*/",                      1, 2,  0 },
+		{ " x */ y",                 1, 5,  0 },
+		{ "/**/*/",                  1, 6,  0 },
+		{ "/* /* */ */ */ tail",     1, 14, 0 },
+		{ "*/ */ */",                3, 8,  0 },
+		{ "**/",                     1, 3,  0 },
+		{ "/ * / x",                 1, 7,  1 },
+		{ "/*",                      1, 2,  2 },
+		{ "abc*",                    1, 3,  1 },
+		{ "abc/",                    2, 3,  2 },
+		{ "",                        1, 0,  1 },
+	};
+
+	for_each_level([&](simd::Level) {
+		for (const auto& c : cases)
+		{
+			SCOPED_TRACE(c.body);
+			size_t depth = c.depth_in;
+			EXPECT_EQ(c.end, simd::skip_comment_body(c.body.data(), c.body.size(), depth));
+			EXPECT_EQ(c.depth_out, depth);
+		}
+
+		// A long body with the delimiters well apart, so that they land in vector blocks.
+		std::string body = std::string(100, 'x') + "/*" + std::string(100, '-') + "*/" + std::string(100, ' ') + "*/!";
+		size_t depth = 1;
+		EXPECT_EQ(body.size() - 1, simd::skip_comment_body(body.data(), body.size(), depth));
+		EXPECT_EQ(0, depth);
+	});
+}
+
+
+// The scanner must produce exactly the same token stream regardless of level.
+TEST(ScannerSimdTest, ScannerTokensAgree)
+{
+	// Generate a mix of everything the scanner knows about, with plenty of
+	// long runs to exercise the wide kernels.
+	static const char* fragments[] = {
+		" ", "\t\t\t\t\t\t\t\t\t", "\r\n", "                                                                  ",
+		"identifier", "_", "a_very_long_identifier_with_lots_of_characters_0123456789_to_be_sure",
+		"0", "12345678901234567890123456789012345678901234567890", "3.14159", ".5", "+1", "-.25", "1.2.3",
+		"\"\"", "\"a string literal that goes on for quite a while, more than sixty four bytes\"",
+		"\"unterminated\n", "\"esc\\\"aped\\\\\"", "\"\\q\"", "{", "}", "[", "]", "=", ":", "::", ",", "// comment\n", "/* block */", "~",
+	};
+	std::mt19937 rng(1234);
+	std::string source;
+	while (source.size() < 64 * 1024)
+		source += fragments[rng() % std::size(fragments)];
+
+	auto scan = [&source]() {
+		std::vector<std::pair<Token, bool>> tokens;
+		Scanner scanner(source);
+		for (auto result = scanner.next(); !result.is_none(); result = scanner.next())
+			tokens.emplace_back(result.token(), result.is_error());
+		return tokens;
+	};
+
+	const simd::Level original = simd::active_level();
+	simd::set_level(simd::Level::Scalar);
+	const auto reference = scan();
+	simd::set_level(original);
+	ASSERT_GT(reference.size(), 1000);
+
+	for_each_level([&](simd::Level) {
+		EXPECT_EQ(reference, scan());
+	});
+}
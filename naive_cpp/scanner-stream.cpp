@@ -0,0 +1,171 @@
+// Streaming variant of the Scanner.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "scanner-stream.h"
+#include "scanner-simd.h"
+
+
+namespace kfs
+{
+
+
+// Drop the consumed part of the window, keeping track of where we are in the stream,
+// and append the new input.
+void StreamScanner::feed(string_view chunk)
+{
+	const size_t consumed = position();
+
+	// Count the lines we're dropping so we can still locate tokens.
+	for (size_t pos = 0; pos < consumed; )
+	{
+		pos += simd::find_byte(window_.data() + pos, consumed - pos, '\n');
+		if (pos >= consumed)
+			break;
+		++pos;
+		++window_line_;
+		line_offset_ = window_offset_ + pos;
+	}
+
+	window_.erase(0, consumed);
+	window_offset_ += consumed;
+	window_.append(chunk);
+
+	source_ = window_;
+	current_ = source_;
+}
+
+
+// Skip whitespace and comments. Comments that run to the end of the window are
+// consumed and remembered as open, so that we can pick up where we left off after
+// the next feed.
+TResult StreamScanner::skip_trivia()
+{
+	for (;;)
+	{
+		if (open_comment_ == Comment::Line)
+		{
+			// The newline isn't part of the comment.
+			const size_t end = simd::find_byte(current_.data(), current_.size(), '\n');
+			comment_len_ += end;
+			current_.remove_prefix(end);
+			if (current_.empty() && !finished_)
+				return TResult{};
+		}
+		else if (open_comment_ == Comment::Block)
+		{
+			// If the window ends part way through a "/*" or "*/", the first half is held
+			// back until we can see the second.
+			const size_t end = simd::skip_comment_body(current_.data(), current_.size(), comment_depth_);
+			comment_len_ += end;
+			current_.remove_prefix(end);
+			if (comment_depth_ > 0)
+			{
+				if (!finished_)
+					return TResult{};
+				open_comment_ = Comment::None;
+				comment_depth_ = 0;
+				return TResult{make_token(Token::Type::OpenComment, current_.size()), ErrorCode::UnterminatedComment};
+			}
+		}
+
+		if (open_comment_ != Comment::None)
+		{
+			comments_ += 1;
+			comments_len_ += comment_len_;
+			open_comment_ = Comment::None;
+		}
+
+		if (skip_whitespace())
+			continue;
+
+		if (front() != '/')
+			return TResult{};
+
+		if (current_.size() < 2)
+			return TResult{};	// Either need more input, or it's an unexpected character.
+
+		if (peek(1) == '/')
+			open_comment_ = Comment::Line;
+		else if (peek(1) == '*')
+		{
+			open_comment_ = Comment::Block;
+			comment_depth_ = 1;
+		}
+		else
+			return TResult{};
+
+		comment_len_ = 2;
+		current_.remove_prefix(2);
+	}
+}
+
+
+// Scan the next token, backing out of any token that more input might change.
+TResult StreamScanner::next()
+{
+	if (auto result = skip_trivia(); result.is_error())
+		return result;
+
+	if (current_.empty() || open_comment_ != Comment::None)
+		return TResult{};
+
+	const string_view restart = current_;
+	TResult result = Scanner::next();
+
+	// Every token is decided by at most the two characters that follow it ('+.'
+	// is only a float if a digit follows), so unless we've seen the last of the
+	// input, those have to be in the window.
+	if (!finished_ && result.has_token())
+	{
+		const Token& token = result.token();
+		const size_t end = static_cast<size_t>(token.source_.data() - source_.data()) + token.source_.length();
+		if (end + 2 > source_.size())
+		{
+			current_ = restart;
+			return TResult{};
+		}
+	}
+
+	return result;
+}
+
+
+BatchResult StreamScanner::next_batch(std::span<Token> out)
+{
+	return fill_batch(*this, out);
+}
+
+
+std::optional<size_t> StreamScanner::get_token_offset(const Token& token) const noexcept
+{
+	if (auto offset = Scanner::get_token_offset(token); offset.has_value())
+		return window_offset_ + offset.value();
+	return std::nullopt;
+}
+
+
+// Count lines from the start of the window rather than the start of the stream.
+std::optional<SourceLocation> StreamScanner::get_token_location(const Token& token) const noexcept
+{
+	const auto offset = Scanner::get_token_offset(token);
+	if (!offset.has_value())
+		return std::nullopt;
+
+	size_t line = window_line_, line_start = line_offset_;
+	for (size_t pos = 0; pos < offset.value(); )
+	{
+		pos += simd::find_byte(window_.data() + pos, offset.value() - pos, '\n');
+		if (pos >= offset.value())
+			break;
+		++pos;
+		++line;
+		line_start = window_offset_ + pos;
+	}
+
+	return SourceLocation{ line, window_offset_ + offset.value() - line_start + 1 };
+}
+
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_SCANNER_STREAM_H
+#define INCLUDED_KFS_NAIVE_CPP_SCANNER_STREAM_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Streaming variant of the Scanner, for input that arrives in chunks (pipes, sockets)
+// or that is too big to hold in memory at once.
+//
+// Rather than a view of the whole document, the StreamScanner owns a window: the
+// unconsumed tail of what it has been fed so far. Each call to feed() discards the
+// consumed part of the window and appends the new chunk, so memory use is bounded by
+// the chunk size plus the longest token rather than by the size of the input.
+//
+// A token is only returned once the scanner can be sure that more input wouldn't
+// change it - "ab" followed by end-of-window might be the start of "abc" - so next()
+// returns None both at end of input and when it needs more; use is_finished() to tell
+// them apart. Whitespace and comments are skipped as they arrive, including block
+// comments that span many chunks, so they don't hold on to the window.
+//
+// Token text points into the window, and is only valid until the next call to feed().
+// The one exception to the Scanner's tokens is an unterminated block comment, where the
+// error token only covers what's left of the comment in the final window.
+
+
+#include "line-index.h"
+#include "scanner.h"
+
+#include <span>
+#include <string>
+
+
+namespace kfs
+{
+
+
+struct StreamScanner : public Scanner
+{
+public:
+	StreamScanner() : Scanner(string_view{}) {}
+
+	// The window is referenced by current_, so the scanner can't be copied or moved.
+	StreamScanner(const StreamScanner&) = delete;
+	StreamScanner& operator = (const StreamScanner&) = delete;
+
+	//! feed appends the next chunk of input. Tokens previously returned by next()
+	//! are invalidated. Must not be called after finish().
+	void feed(string_view chunk);
+
+	//! finish indicates there is no more input, so that whatever remains in the
+	//! window can be scanned.
+	void finish() noexcept { finished_ = true; }
+
+	//! Returns true once finish() has been called: after that, None from next()
+	//! means end of input rather than a need for more input.
+	[[nodiscard]]
+	bool is_finished() const noexcept { return finished_; }
+
+	//! next has the same contract as Scanner::next, except that None is also
+	//! returned when more input is needed before the next token can be decided.
+	TResult next();
+
+	//! next_batch has the same contract as Scanner::next_batch, with the exception
+	//! above. Tokens are only valid until the next feed().
+	BatchResult next_batch(std::span<Token> out);
+
+	// Tokens don't live long enough to be put in a TokenBuffer.
+	BatchResult next_batch(TokenBuffer& out, size_t limit) = delete;
+
+	//! get_token_offset returns the offset of the token from the start of the stream
+	//! if it is from the current window, otherwise nullopt.
+	[[nodiscard]]
+	std::optional<size_t> get_token_offset(const Token& token) const noexcept;
+
+	//! get_token_location returns the 1-based line and column of a token from the
+	//! current window in the stream, otherwise nullopt.
+	[[nodiscard]]
+	std::optional<SourceLocation> get_token_location(const Token& token) const noexcept;
+
+	//! Returns the number of bytes fed so far.
+	[[nodiscard]]
+	size_t fed() const noexcept { return window_offset_ + window_.size(); }
+
+	//! Returns the number of bytes currently held by the scanner.
+	[[nodiscard]]
+	size_t window_size() const noexcept { return window_.size(); }
+
+protected:
+	// Skip whitespace and comments, carrying open comments across windows; returns an
+	// error on reaching end of input in a block comment, otherwise None.
+	TResult skip_trivia();
+
+	enum class Comment : uint8_t { None, Line, Block };
+
+	std::string	window_			{ };				// Unconsumed input.
+	size_t		window_offset_	{0};				// Stream offset of window_[0].
+	size_t		window_line_	{1};				// Line number at window_[0].
+	size_t		line_offset_	{0};				// Stream offset of the start of that line.
+	Comment		open_comment_	{Comment::None};	// Comment we're part way through.
+	size_t		comment_len_	{0};				// Length of the open comment so far.
+	size_t		comment_depth_	{0};				// Nesting depth of an open block comment.
+	bool		finished_		{false};			// No more input will be fed.
+};
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_SCANNER_STREAM_H
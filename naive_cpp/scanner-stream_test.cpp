@@ -0,0 +1,187 @@
+// Unit tests for the streaming scanner: however the input is chunked, it must agree
+// with the Scanner run over the whole document.
+
+#include "scanner.h"
+#include "scanner-stream.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace kfs;
+
+
+namespace
+{
+
+// What we compare: type, stream offset, text and error. The text has to be copied
+// because stream tokens don't outlive the next feed.
+using Scanned = std::tuple<Token::Type, size_t, std::string, std::string>;
+
+Scanned describe(const TResult& result, size_t offset)
+{
+	const Token& token = result.token();
+	// An unterminated block comment is reported with whatever of it is still in the window.
+	if (token.type_ == Token::Type::OpenComment)
+		return { token.type_, 0, {}, std::string(result.error()) };
+	return { token.type_, offset, std::string(token.source_), result.is_error() ? std::string(result.error()) : std::string{} };
+}
+
+std::vector<Scanned> scan_whole(string_view source)
+{
+	std::vector<Scanned> results;
+	Scanner scanner(source);
+	for (auto result = scanner.next(); !result.is_none(); result = scanner.next())
+		results.push_back(describe(result, scanner.get_token_offset(result.token()).value()));
+	return results;
+}
+
+std::vector<Scanned> scan_chunked(string_view source, size_t chunk_size, size_t* max_window = nullptr)
+{
+	std::vector<Scanned> results;
+	StreamScanner scanner;
+	for (size_t pos = 0; ; pos += chunk_size)
+	{
+		if (pos < source.size())
+			scanner.feed(source.substr(pos, chunk_size));
+		else
+			scanner.finish();
+		if (max_window)
+			*max_window = std::max(*max_window, scanner.window_size());
+
+		for (auto result = scanner.next(); !result.is_none(); result = scanner.next())
+			results.push_back(describe(result, scanner.get_token_offset(result.token()).value()));
+
+		if (scanner.is_finished())
+			return results;
+	}
+}
+
+}
+
+
+TEST(StreamScannerTest, NeedsInput)
+{
+	StreamScanner scanner;
+	EXPECT_TRUE(scanner.next().is_none());
+	EXPECT_FALSE(scanner.is_finished());
+
+	scanner.feed("enum Fo");
+	auto result = scanner.next();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ("enum", result.token().source_);
+	// 'Fo' could be the start of a longer word.
+	EXPECT_TRUE(scanner.next().is_none());
+
+	scanner.feed("o {");
+	result = scanner.next();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ("Foo", result.token().source_);
+	EXPECT_EQ(5, scanner.get_token_offset(result.token()));
+	EXPECT_TRUE(scanner.next().is_none());
+
+	scanner.finish();
+	result = scanner.next();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ(Token::Type::LBrace, result.token().type_);
+	EXPECT_TRUE(scanner.next().is_none());
+	EXPECT_TRUE(scanner.is_finished());
+}
+
+
+// Chunking at every size must produce the same tokens, offsets and errors as scanning
+// the whole document.
+TEST(StreamScannerTest, AgreesWithScanner)
+{
+	const string_view source =
+		"// line comment\n"
+		"enum E { A, B } /* block /* nested /**/ */\n comment */ type T : E {\n"
+		"  int x = -1, float y = +.5, z = 3.25 s = \"str\" e = \"\\\"q\\\\\" t::u\n"
+		"  \"unterminated\n"
+		"  bad ~ thing + . /*/ still comment */ x//tail";
+	const auto expected = scan_whole(source);
+	ASSERT_FALSE(expected.empty());
+
+	for (size_t chunk_size = 1; chunk_size <= source.size(); ++chunk_size)
+		ASSERT_EQ(expected, scan_chunked(source, chunk_size)) << "chunk size " << chunk_size;
+}
+
+
+// Sequences of up to three characters, fed one byte at a time.
+TEST(StreamScannerTest, AgreesOnAllShortSequences)
+{
+	const string_view alphabet = " \na_Z09\"{}[]:=,+-./*~";
+	std::string source(3, ' ');
+	for (char a : alphabet)
+	{
+		for (char b : alphabet)
+		{
+			for (char c : alphabet)
+			{
+				source[0] = a; source[1] = b; source[2] = c;
+				for (size_t len = 1; len <= 3; ++len)
+				{
+					const string_view input(source.data(), len);
+					ASSERT_EQ(scan_whole(input), scan_chunked(input, 1)) << "input |" << input << "|";
+				}
+			}
+		}
+	}
+}
+
+
+// A comment spanning many chunks mustn't accumulate in the window.
+TEST(StreamScannerTest, LongCommentIsNotBuffered)
+{
+	const std::string source = "a /*" + std::string(100000, 'x') + "*/ b // " + std::string(100000, 'y') + "\nc";
+	size_t max_window = 0;
+	const auto results = scan_chunked(source, 64, &max_window);
+	ASSERT_EQ(3, results.size());
+	EXPECT_EQ("a", std::get<2>(results[0]));
+	EXPECT_EQ("b", std::get<2>(results[1]));
+	EXPECT_EQ("c", std::get<2>(results[2]));
+	EXPECT_EQ(source.size() - 1, std::get<1>(results[2]));
+	EXPECT_LE(max_window, 64 + 3);
+}
+
+
+TEST(StreamScannerTest, UnterminatedBlockComment)
+{
+	StreamScanner scanner;
+	scanner.feed("x /* never");
+	scanner.feed(" closed");
+	auto result = scanner.next();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ("x", result.token().source_);
+	EXPECT_TRUE(scanner.next().is_none());
+
+	scanner.finish();
+	result = scanner.next();
+	ASSERT_TRUE(result.is_error());
+	EXPECT_EQ("unterminated block comment", result.error());
+	EXPECT_TRUE(scanner.next().is_none());
+}
+
+
+TEST(StreamScannerTest, Location)
+{
+	StreamScanner scanner;
+	scanner.feed("a\nbb\n");
+	ASSERT_TRUE(scanner.next().is_token());
+	scanner.feed("  ccc");
+	auto result = scanner.next();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ("bb", result.token().source_);
+	EXPECT_EQ((SourceLocation{2, 1}), scanner.get_token_location(result.token()));
+
+	scanner.feed(" d");
+	scanner.finish();
+	result = scanner.next();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ("ccc", result.token().source_);
+	EXPECT_EQ((SourceLocation{3, 3}), scanner.get_token_location(result.token()));
+	EXPECT_EQ(7, scanner.get_token_offset(result.token()));
+	EXPECT_EQ(std::nullopt, scanner.get_token_location(Token{Token::Type::Word, "elsewhere"}));
+}
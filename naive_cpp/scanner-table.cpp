@@ -0,0 +1,180 @@
+// Table-driven dispatch for the TypeDef grammar scanner.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "scanner-table.h"
+
+
+namespace kfs
+{
+
+
+namespace
+{
+
+using CharClass = TableScanner::CharClass;
+using State = TableScanner::State;
+using Action = TableScanner::Action;
+using Transition = TableScanner::Transition;
+
+
+// Generate the byte -> character class table.
+constexpr TableScanner::ClassTable make_class_table() noexcept
+{
+	TableScanner::ClassTable table {};
+	for (auto& entry : table)
+		entry = CharClass::Other;
+
+	for (char c : { ' ', '\t', '\r', '\n' })
+		table[uint8_t(c)] = CharClass::Space;
+	for (int c = 'a'; c <= 'z'; ++c)
+		table[c] = table[c - 'a' + 'A'] = CharClass::Alpha;
+	table['_'] = CharClass::Alpha;
+	for (int c = '0'; c <= '9'; ++c)
+		table[c] = CharClass::Digit;
+
+	table['"'] = CharClass::Quote;
+	table['{'] = CharClass::LBrace;
+	table['}'] = CharClass::RBrace;
+	table['['] = CharClass::LBracket;
+	table[']'] = CharClass::RBracket;
+	table[':'] = CharClass::Colon;
+	table['='] = CharClass::Equals;
+	table[','] = CharClass::Comma;
+	table['+'] = table['-'] = CharClass::Sign;
+	table['.'] = CharClass::Dot;
+	table['/'] = CharClass::Slash;
+	table['*'] = CharClass::Star;
+
+	return table;
+}
+
+
+constexpr Transition emit(Token::Type type, uint8_t len) noexcept
+{
+	return Transition{ Action::Emit, type, len, State::Start };
+}
+
+constexpr Transition lookahead(State next) noexcept
+{
+	return Transition{ Action::Lookahead, Token::Type::Invalid, 0, next };
+}
+
+constexpr Transition action(Action act) noexcept
+{
+	return Transition{ act, Token::Type::Invalid, 0, State::Start };
+}
+
+
+// Generate the [state][class] transition table; anything not listed here is an
+// unexpected character.
+constexpr TableScanner::TransitionTable make_transition_table() noexcept
+{
+	TableScanner::TransitionTable table {};
+	auto at = [&table](State state, CharClass cls) -> Transition& {
+		return table[size_t(state)][size_t(cls)];
+	};
+
+	// At a token boundary.
+	at(State::Start, CharClass::Space)    = action(Action::Whitespace);
+	at(State::Start, CharClass::Alpha)    = action(Action::Word);
+	at(State::Start, CharClass::Digit)    = action(Action::Number);
+	at(State::Start, CharClass::Quote)    = action(Action::String);
+	at(State::Start, CharClass::LBrace)   = emit(Token::Type::LBrace, 1);
+	at(State::Start, CharClass::RBrace)   = emit(Token::Type::RBrace, 1);
+	at(State::Start, CharClass::LBracket) = emit(Token::Type::LBracket, 1);
+	at(State::Start, CharClass::RBracket) = emit(Token::Type::RBracket, 1);
+	at(State::Start, CharClass::Equals)   = emit(Token::Type::Equals, 1);
+	at(State::Start, CharClass::Comma)    = emit(Token::Type::Comma, 1);
+	at(State::Start, CharClass::Colon)    = lookahead(State::Colon);
+	at(State::Start, CharClass::Sign)     = lookahead(State::Sign);
+	at(State::Start, CharClass::Dot)      = lookahead(State::Dot);
+	at(State::Start, CharClass::Slash)    = lookahead(State::Slash);
+
+	// ':' is a colon unless followed by another, making it the scope operator.
+	for (size_t cls = 0; cls < size_t(CharClass::Count); ++cls)
+		at(State::Colon, CharClass(cls)) = emit(Token::Type::Colon, 1);
+	at(State::Colon, CharClass::Colon) = emit(Token::Type::Scope, 2);
+
+	// '+'/'-' must be followed by a digit, or a '.' that might begin a float.
+	at(State::Sign, CharClass::Digit) = action(Action::Number);
+	at(State::Sign, CharClass::Dot)   = action(Action::SignedNumber);
+
+	// '.' must be followed by a digit.
+	at(State::Dot, CharClass::Digit) = action(Action::Number);
+
+	// '/' must be followed by '/' or '*' to begin a comment.
+	at(State::Slash, CharClass::Slash) = action(Action::Comment);
+	at(State::Slash, CharClass::Star)  = action(Action::Comment);
+
+	return table;
+}
+
+}
+
+
+const TableScanner::ClassTable TableScanner::kCharClasses = make_class_table();
+const TableScanner::TransitionTable TableScanner::kTransitions = make_transition_table();
+
+
+// Attempts to identify the next token in the stream.
+TResult TableScanner::next()
+{
+	while (!current_.empty())
+	{
+		Transition transition = kTransitions[size_t(State::Start)][size_t(classify(front()))];
+		if (transition.action_ == Action::Lookahead)
+			transition = kTransitions[size_t(transition.next_)][size_t(classify(peek(1)))];
+
+		switch (transition.action_)
+		{
+		case Action::Emit:
+			return TResult{make_token(transition.type_, transition.len_)};
+
+		case Action::Whitespace:
+			skip_whitespace();
+			continue;
+
+		case Action::Comment:
+		{
+			auto result = skip_comment();
+			if (result.is_error())
+				return result;
+			note_comment(result.token());
+			continue;
+		}
+
+		case Action::String:
+			return scan_string();
+		case Action::Number:
+			return scan_number();
+		case Action::SignedNumber:
+			return scan_signed_number();
+		case Action::Word:
+			return scan_word();
+
+		default:
+			return unexpected_result();
+		}
+	}
+
+	// We reached end of input.
+	return TResult{};
+}
+
+
+// Fill a buffer with tokens until it is full, we reach end of input, or an error.
+BatchResult TableScanner::next_batch(std::span<Token> out)
+{
+	return fill_batch(*this, out);
+}
+
+
+BatchResult TableScanner::next_batch(TokenBuffer& out, size_t limit)
+{
+	return fill_batch(*this, out, limit);
+}
+
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_SCANNER_TABLE_H
+#define INCLUDED_KFS_NAIVE_CPP_SCANNER_TABLE_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Table-driven variant of the Scanner: rather than choosing the token kind with a
+// switch over the first character plus ad-hoc peeks, each byte is mapped to a
+// character class through a 256-entry table, and the (state, class) pair indexes a
+// small transition table that says what to do - emit a fixed-length token, look at
+// one more character, or hand off to one of the Scanner's run scanners.
+//
+// It produces exactly the same tokens as Scanner, so the two can be compared on the
+// same input.
+
+
+#include "scanner.h"
+
+#include <array>
+#include <cstdint>
+
+
+namespace kfs
+{
+
+
+struct TableScanner : public Scanner
+{
+public:
+	using Scanner::Scanner;
+
+	//! Character classes that the transition table distinguishes between.
+	enum class CharClass : uint8_t
+	{
+		Other, Space, Alpha, Digit, Quote, LBrace, RBrace, LBracket, RBracket,
+		Colon, Equals, Comma, Sign, Dot, Slash, Star,
+		Count
+	};
+
+	//! States of the DFA; Start is the only state entered at a token boundary,
+	//! the others are entered after one character that needs one more to decide.
+	enum class State : uint8_t
+	{
+		Start, Colon, Sign, Dot, Slash,
+		Count
+	};
+
+	//! What to do on reaching a (state, class) pair.
+	enum class Action : uint8_t
+	{
+		Unexpected,		// Not a valid start of token.
+		Emit,			// Emit a fixed length token of a fixed type.
+		Lookahead,		// Classify the next character and transition to next_.
+		Whitespace,		// Skip whitespace.
+		Comment,		// Skip a line or block comment.
+		String,			// Scan a string literal.
+		Number,			// Scan an integer or float.
+		SignedNumber,	// Scan a signed float that begins with a sign and a dot.
+		Word,			// Scan an identifier.
+	};
+
+	struct Transition
+	{
+		Action		action_	{ Action::Unexpected };
+		Token::Type	type_	{ Token::Type::Invalid };
+		uint8_t		len_	{ 0 };
+		State		next_	{ State::Start };
+	};
+
+	using ClassTable = std::array<CharClass, 256>;
+	using TransitionTable = std::array<std::array<Transition, size_t(CharClass::Count)>, size_t(State::Count)>;
+
+	//! Maps every byte value to its character class.
+	static const ClassTable kCharClasses;
+	//! Indexed by [state][class].
+	static const TransitionTable kTransitions;
+
+	//! next has the same contract as Scanner::next.
+	TResult next();
+
+	//! next_batch has the same contract as Scanner::next_batch.
+	BatchResult next_batch(std::span<Token> out);
+	BatchResult next_batch(TokenBuffer& out, size_t limit);
+
+protected:
+	[[nodiscard]]
+	static CharClass classify(char c) noexcept { return kCharClasses[static_cast<uint8_t>(c)]; }
+};
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_SCANNER_TABLE_H
@@ -0,0 +1,96 @@
+// Unit tests for the table-driven scanner: it must agree with the switch scanner.
+
+#include "scanner.h"
+#include "scanner-table.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace kfs;
+
+
+// Capture the entire stream of results from a scanner, including errors.
+template<typename ScannerType>
+std::vector<std::pair<Token, bool>> scan_all(string_view source)
+{
+	std::vector<std::pair<Token, bool>> tokens;
+	ScannerType scanner(source);
+	for (auto result = scanner.next(); !result.is_none(); result = scanner.next())
+		tokens.emplace_back(result.token(), result.is_error());
+	return tokens;
+}
+
+
+TEST(TableScannerTest, CharClasses)
+{
+	using CharClass = TableScanner::CharClass;
+	EXPECT_EQ(CharClass::Space, TableScanner::kCharClasses['\n']);
+	EXPECT_EQ(CharClass::Alpha, TableScanner::kCharClasses['_']);
+	EXPECT_EQ(CharClass::Alpha, TableScanner::kCharClasses['Q']);
+	EXPECT_EQ(CharClass::Digit, TableScanner::kCharClasses['0']);
+	EXPECT_EQ(CharClass::Sign,  TableScanner::kCharClasses['-']);
+	EXPECT_EQ(CharClass::Other, TableScanner::kCharClasses['~']);
+	EXPECT_EQ(CharClass::Other, TableScanner::kCharClasses[0]);
+	EXPECT_EQ(CharClass::Other, TableScanner::kCharClasses[0xff]);
+}
+
+
+// Every sequence of up to three characters drawn from an alphabet that covers
+// each character class must produce identical results from both scanners.
+TEST(TableScannerTest, AgreesOnAllShortSequences)
+{
+	const string_view alphabet = " \na_Z09\"{}[]:=,+-./*~\x80";
+	std::string source(3, ' ');
+	for (char a : alphabet)
+	{
+		for (char b : alphabet)
+		{
+			for (char c : alphabet)
+			{
+				source[0] = a; source[1] = b; source[2] = c;
+				for (size_t len = 1; len <= 3; ++len)
+				{
+					const string_view input(source.data(), len);
+					ASSERT_EQ(scan_all<Scanner>(input), scan_all<TableScanner>(input)) << "input |" << input << "|";
+				}
+			}
+		}
+	}
+}
+
+
+TEST(TableScannerTest, AgreesOnMixedInput)
+{
+	static const char* fragments[] = {
+		" ", "\r\n", "enum", "type", "Name", "_x1", "0", "123", "4.5", ".5", "+1", "-.25", "+.", "-x",
+		"\"\"", "\"text\"", "\"unterminated\n", "\"esc\\\"aped\\\\\"", "\"\\q\"", "{", "}", "[", "]", "=", ":", "::", ":::", ",",
+		"// comment\n", "/* block */", "/", "~", "@",
+	};
+	std::mt19937 rng(42);
+	std::string source;
+	while (source.size() < 32 * 1024)
+		source += fragments[rng() % std::size(fragments)];
+
+	EXPECT_EQ(scan_all<Scanner>(source), scan_all<TableScanner>(source));
+}
+
+
+TEST(TableScannerTest, CountsComments)
+{
+	struct TestTableScanner : public TableScanner
+	{
+		using TableScanner::TableScanner;
+		[[nodiscard]] size_t comments() const noexcept { return comments_; }
+		[[nodiscard]] size_t comments_len() const noexcept { return comments_len_; }
+	};
+
+	TestTableScanner scanner("/* hello */// world\n\nX");
+	const TResult result = scanner.next();
+	ASSERT_TRUE(result.is_token());
+	EXPECT_EQ("X", result.token().source_);
+	EXPECT_EQ(2, scanner.comments());
+	EXPECT_EQ(19, scanner.comments_len());
+}
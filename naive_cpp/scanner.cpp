@@ -5,6 +5,7 @@
 
 #include "common.h"
 #include "scanner.h"
+#include "scanner-simd.h"
 #include "token.h"
 #include "tresult.h"
 
@@ -48,9 +49,9 @@ std::string_view Token::type_to_str(Token::Type type)
 // Helper that creates a token from the current position in the source
 // and advances past the token.
 //
-Token Scanner::make_token(Token::Type type, size_t len) noexcept
+Token Scanner::make_token(Token::Type type, size_t len, uint8_t flags) noexcept
 {
-	Token token = Token{type, current_.substr(0, len)};
+	Token token = Token{type, current_.substr(0, len), flags};
 	current_.remove_prefix(len);
 	return token;
 }
@@ -59,7 +60,7 @@ Token Scanner::make_token(Token::Type type, size_t len) noexcept
 // Helper that creates a TResult consuming the character at the front of current.
 TResult Scanner::unexpected_result() noexcept
 {
-	return TResult{make_token(Token::Type::Invalid, 1), "unexpected character"};
+	return TResult{make_token(Token::Type::Invalid, 1), ErrorCode::UnexpectedCharacter};
 }
 
 
@@ -77,6 +78,16 @@ std::optional<size_t> Scanner::get_token_offset(const Token& token) const noexce
 }
 
 
+// Locate the token by offset, and then the offset by line.
+std::optional<SourceLocation> Scanner::get_token_location(const Token& token) const
+{
+	if (auto offset = get_token_offset(token); offset.has_value())
+		return lines_.locate(offset.value());
+
+	return std::nullopt;
+}
+
+
 // Attempts to identify the next token in the stream.
 TResult Scanner::next()
 {
@@ -89,9 +100,7 @@ TResult Scanner::next()
 		{
 			if (result.is_error())
 				return result;
-			// Track comment stats.
-			comments_ += 1;
-			comments_len_ += result.token().source_.length();
+			note_comment(result.token());
 			continue;
 		}
 
@@ -155,18 +164,25 @@ TResult Scanner::next()
 }
 
 
+// Fill a buffer with tokens until it is full, we reach end of input, or an error.
+BatchResult Scanner::next_batch(std::span<Token> out)
+{
+	return fill_batch(*this, out);
+}
+
+
+BatchResult Scanner::next_batch(TokenBuffer& out, size_t limit)
+{
+	return fill_batch(*this, out, limit);
+}
+
+
 // If there is whitespace at the front of current, advance past it and
 // return true, otherwise return false.
 //
 bool Scanner::skip_whitespace()
 {
-	size_t trimLen = 0;
-	for (;!current_.empty(); trimLen++)
-	{
-		char next = peek(trimLen);
-		if (next != ' ' && next != '\t' && next != '\r' && next != '\n')
-			break;
-	}
+	const size_t trimLen = simd::span_whitespace(current_.data(), current_.size());
 
 	current_.remove_prefix(trimLen);
 
@@ -174,6 +190,15 @@ bool Scanner::skip_whitespace()
 }
 
 
+void Scanner::note_comment(const Token& comment)
+{
+	comments_ += 1;
+	comments_len_ += comment.source_.length();
+	if (trivia_ != nullptr)
+		trivia_->add(size_t(comment.source_.data() - source_.data()), comment.source_.length());
+}
+
+
 // Either return a token representing a comment we find at the front of
 // current, return an error if there is an unterminated comment, or return
 // None if there is no comment.
@@ -197,54 +222,75 @@ TResult Scanner::skip_comment()
 	if (peek(1) != '*')
 		return None;
 
-	// block comment - simple version, no nesting.
-	if (auto end = current_.find("*/", /*skip open*/2); end != current_.npos)
-	{
+	// block comment, which may contain other block comments.
+	size_t depth = 1;
+	const size_t end = simd::skip_comment_body(current_.data() + 2, current_.size() - 2, depth);
+	if (depth == 0)
 		return TResult{make_token(Token::Type::CloseComment, end + 2)};
-	}
 
-	// This will cause the open comment to look like some unknown symbol.
-	return TResult{make_token(Token::Type::OpenComment, current_.size()), "unterminated block comment"};
+	// Report the whole comment, so that the error points at where it was opened.
+	return TResult{make_token(Token::Type::OpenComment, current_.size()), ErrorCode::UnterminatedComment};
 }
 
 
-// Naive implementation of string scanner, doesn't handle escape sequences.
+// String scanner: hops between quotes, backslashes and line endings. The only escapes
+// are \" and \\; any other backslash is just a backslash. The literal is flagged if
+// it has escapes, so that consumers know its value isn't simply its text.
 //
 TResult Scanner::scan_string()
 {
-	auto end = current_.find_first_of("\"\r\n", /*skip open quote*/1);
-	if (end != current_.npos)
+	uint8_t flags = Token::NoFlags;
+	// skip the open quote.
+	for (size_t end = 1; ; )
 	{
-		if (peek(end) == '"')
-			return TResult{make_token(Token::Type::String, end + 1)};
+		end += simd::find_string_delim(current_.data() + end, current_.size() - end);
+		if (end >= current_.size())
+			break;
 
-		return TResult{make_token(Token::Type::String, end), "unterminated string"};
+		switch (current_[end])
+		{
+		case '"':
+			return TResult{make_token(Token::Type::String, end + 1, flags)};
+
+		case '\\':
+			if (peek(end + 1) == '"' || peek(end + 1) == '\\')
+			{
+				flags |= Token::Escaped;
+				end += 2;
+			}
+			else
+				end += 1;
+			break;
+
+		default:
+			return TResult{make_token(Token::Type::String, end, flags), ErrorCode::UnterminatedString};
+		}
 	}
 
-	return TResult{make_token(Token::Type::String, current_.size()), "unterminated string"};
+	return TResult{make_token(Token::Type::String, current_.size(), flags), ErrorCode::UnterminatedString};
 }
 
 
 // Handles a digit sequence that will either be an integer or float if we encounter
-// a decimal point.
+// a decimal point, or a decimal point followed by digits, which is a float.
 TResult Scanner::scan_number()
 {
 	// We take it as read that the caller checked the first character to be numeric,
-	// so we start from character 1.
+	// or a '.' before a digit, so we start from character 1.
+	if (front() == '.')
+		return make_number(Token::Type::Float, 1 + simd::span_digits(current_.data() + 1, current_.size() - 1));
+
 	bool is_float = false;
-	size_t len = 1;
-	for ( ; len < current_.size(); ++len)
+	size_t len = 1 + simd::span_digits(current_.data() + 1, current_.size() - 1);
+	// if we see a '.', this is a float and another series of digits may follow;
+	// anything else is a stop.
+	if (peek(len) == '.')
 	{
-		if (const char c = peek(len); c >= '0' && c <= '9')
-			continue;
-		// if we see a '.', set is_float to true, and then if it wasn't already set,
-		// allow another series of integers to follow.
-		else if (c == '.' && !std::exchange(is_float, true))
-			continue;
-		// anything else is a stop.
-		break;
+		is_float = true;
+		len += 1;
+		len += simd::span_digits(current_.data() + len, current_.size() - len);
 	}
-	return TResult{make_token(!is_float ? Token::Type::Integer : Token::Type::Float, len)};
+	return make_number(!is_float ? Token::Type::Integer : Token::Type::Float, len);
 }
 
 
@@ -260,32 +306,39 @@ TResult Scanner::scan_signed_number()
 
 	if (peek(1) == '.')
 	{
-		size_t len = 2;
-		for ( ; len < current_.size(); len++)
-		{
-			if (char c = peek(len); c < '0' || c > '9')
-				break;
-		}
+		const size_t len = 2 + simd::span_digits(current_.data() + 2, current_.size() - 2);
 		if (len > 2)	// sign + dot
-			return TResult{make_token(Token::Type::Float, len)};
+			return make_number(Token::Type::Float, len);
 	}
 
 	return unexpected_result();
 }
 
 
-// Handles a sequence of characters that started with an ascii letter or underscore.
+// Decoding is optional so that scanners which only classify tokens don't pay for it.
+TResult Scanner::make_number(Token::Type type, size_t len) noexcept
+{
+	const Token token = make_token(type, len);
+	if (!decode_numbers_)
+		return TResult{token};
+
+	const ErrorCode code = type == Token::Type::Integer
+		? parse_integer(token.source_, number_.integer_)
+		: parse_float(token.source_, number_.float_);
+	if (code != ErrorCode::None)
+		return TResult{token, code};
+	return TResult{token};
+}
+
+
+// Handles a sequence of characters that started with an ascii letter or underscore,
+// noting which keyword, if any, it spells.
 TResult Scanner::scan_word()
 {
-	size_t len = 1;
-	for (; len < current_.size(); len++)
-	{
-		const char c = peek(len);
-		if ((c < 'a' || c > 'z') && (c < 'A' || c > 'Z') && (c < '0' || c > '9') && c != '_')
-			break;
-	}
+	const size_t len = 1 + simd::span_word(current_.data() + 1, current_.size() - 1);
+	const Keyword keyword = classify_keyword(current_.substr(0, len));
 
-	return TResult{make_token(Token::Type::Word, len)};
+	return TResult{make_token(Token::Type::Word, len, Token::keyword_flags(keyword))};
 }
 
 
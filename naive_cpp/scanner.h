@@ -7,18 +7,39 @@
 // getting it to work over being performant or cleverly designed.
 //
 // Constructed with a view of text that must persist as long as the Scanner lives,
-// calling "next()" will return a result containing a Token, an Error (string) or
+// calling "next()" will return a result containing a Token, an Error (code) or
 // 'None' on end-of-input.
 
 
+#include "line-index.h"
+#include "numeric.h"
 #include "token.h"
+#include "token-buffer.h"
+#include "trivia.h"
 #include "tresult.h"
 
+#include <optional>
+#include <span>
+
 
 namespace kfs
 {
 
 
+//! BatchResult describes the outcome of filling a buffer of tokens: how many were
+//! written, and the first error encountered, if any. Scanning stops at the first
+//! error, so a count shorter than the buffer without an error means end-of-input.
+struct BatchResult
+{
+	size_t	count_ {0};		// Number of tokens written to the buffer.
+	TResult	error_ {};		// The error that stopped the batch, or None.
+
+	//! Returns true if the batch was stopped by an error.
+	[[nodiscard]]
+	bool is_error() const noexcept { return error_.is_error(); }
+};
+
+
 struct Scanner
 {
 public:
@@ -29,6 +50,7 @@ public:
 	explicit Scanner(const string_view source)
 		: source_(source)
 		, current_(source)
+		, lines_(source)
 	{
 	}
 	explicit Scanner(const std::string& source) : Scanner(string_view(source)) {}
@@ -37,30 +59,80 @@ public:
 
 	//! next will attempt to fetch and return the next token. If end-of-input is reached,
 	//! it will return None; if a valid token is found, it will return the token; if an
-	//! error occurs it will return an error string describing the error, and possibly
+	//! error occurs it will return an error code describing the error, and possibly
 	//! an accompanying Token describing the problem text.
 	TResult next();
 
+	//! next_batch fills 'out' with up to out.size() tokens in a single call, stopping
+	//! early at end-of-input or at the first error. The error (and any token that
+	//! accompanies it) is returned in the result rather than written to 'out', and the
+	//! scanner is left positioned after it so that scanning can resume.
+	BatchResult next_batch(std::span<Token> out);
+
+	//! next_batch appends up to 'limit' tokens to a TokenBuffer, whose source must be
+	//! (or contain) the scanner's source, with the same contract as above. A token that
+	//! can't be represented in the buffer is reported as an error. If the buffer's
+	//! source is too large for it to hold at all, the first call reports that as a
+	//! single DocumentTooLarge error and the scanner is left at the end of input.
+	BatchResult next_batch(TokenBuffer& out, size_t limit);
+
+	//! source returns the document the scanner was constructed with.
+	[[nodiscard]]
+	string_view source() const noexcept { return source_; }
+
 	//! get_token_offset tries to determine the offset of a particular token. If the token does
 	//! not appear to be from this source document, returns nullopt, otherwise returns the
 	//! offset in bytes of the token from the start of the source.
 	[[nodiscard]]
 	std::optional<size_t> get_token_offset(const Token& token) const noexcept;
 
+	//! get_token_location is like get_token_offset, but returns the 1-based line and
+	//! column of the token. The first call builds an index of the source's lines, so
+	//! that scanning itself doesn't have to track them.
+	[[nodiscard]]
+	std::optional<SourceLocation> get_token_location(const Token& token) const;
+
+	//! line_index returns the (lazily built) line index for the source.
+	[[nodiscard]]
+	const LineIndex& line_index() const noexcept { return lines_; }
+
+	//! decode_numbers turns on decoding of Integer and Float tokens while they are
+	//! scanned. The value of the most recent one is then available from last_number(),
+	//! next_batch records values in the TokenBuffer, and literals that are out of
+	//! range are reported as errors.
+	void decode_numbers(bool enabled) noexcept { decode_numbers_ = enabled; }
+	[[nodiscard]]
+	bool decodes_numbers() const noexcept { return decode_numbers_; }
+	[[nodiscard]]
+	NumericValue last_number() const noexcept { return number_; }
+
+	//! retain_trivia has the scanner record the span of every comment it skips in
+	//! 'table', or stops it recording if 'table' is null. The table must outlive the
+	//! scanner, or the next call.
+	void retain_trivia(TriviaTable* table) noexcept { trivia_ = table; }
+
 protected:
 	string_view		source_		  { };		// Original unmodified source view.
 	string_view		current_	  { };		// Reduced source view as we scan.
 	size_t			comments_     {0};		// Count of comments skipped.
 	size_t			comments_len_ {0};		// Total quantity of comment text skipped.
+	LineIndex		lines_		  { };		// Built on first request for a location.
+	NumericValue	number_		  { };		// Value of the last number, when decoding.
+	bool			decode_numbers_ {false};	// Decode numbers as they are scanned.
+	TriviaTable*	trivia_		  {nullptr};	// Where to record comments, if anywhere.
 
 protected:
 	/* ---------- Internal Methods, I hate pimpls ---------- */
 	// make_token is a helper to create a token from the current view and advance the cursor.
-	Token   make_token(Token::Type type, size_t len) noexcept;
+	Token   make_token(Token::Type type, size_t len, uint8_t flags = Token::NoFlags) noexcept;
 
 	// indicate an unexpected character at the front of the current view.
 	TResult unexpected_result() noexcept;
 
+	// position returns the offset of the cursor from the start of the source.
+	[[nodiscard]]
+	size_t position() const noexcept { return static_cast<size_t>(current_.data() - source_.data()); }
+
 	// front will return the first character of the current view, or '\0' at eoi.
 	[[nodiscard]]
 	char front() const noexcept { return peek(0); }
@@ -76,8 +148,12 @@ protected:
 	// skip_comment will advance past a line or block comment at the current cursor.
 	TResult skip_comment();
 
-	// Try to produce a single-line quoted string from the current view at the opening quote.
-	// If the string is unterminated by EOI/EOL, an error is returned.
+	// note_comment accounts for a comment that was skipped, and retains it if asked to.
+	void note_comment(const Token& comment);
+
+	// Try to produce a single-line quoted string from the current view at the opening quote,
+	// allowing for \" and \\ escapes. If the string is unterminated by EOI/EOL, an error
+	// is returned.
 	TResult scan_string();
 
 	// Optimistic attempt to scan a number from either a digit or a decimal point.
@@ -86,10 +162,67 @@ protected:
 	// Optimistic attempt to scan a signed integer/float from a leading sign (+/-).
 	TResult scan_signed_number();
 
+	// Produce a number token of 'len' characters, decoding it if asked to.
+	TResult make_number(Token::Type type, size_t len) noexcept;
+
 	// Scan a word token from the current view at the initial character. Note that
 	// this will happily accept a digit as the first character, it's assumed that the
 	// caller will already have made the distinction.
 	TResult scan_word();
+
+	// Common implementation of next_batch for Scanner and its variants; defined here so
+	// that each variant's next() can be inlined into the loop.
+	template<typename ScannerType>
+	static BatchResult fill_batch(ScannerType& scanner, std::span<Token> out)
+	{
+		BatchResult batch {};
+		for (Token& slot : out)
+		{
+			TResult result = scanner.next();
+			if (!result.is_token())
+			{
+				if (result.is_error())
+					batch.error_ = std::move(result);
+				break;
+			}
+			slot = result.token();
+			++batch.count_;
+		}
+		return batch;
+	}
+
+	template<typename ScannerType>
+	static BatchResult fill_batch(ScannerType& scanner, TokenBuffer& out, size_t limit)
+	{
+		BatchResult batch {};
+		if (!TokenBuffer::can_hold(out.source())) [[unlikely]]
+		{
+			// Every token past the offsets' reach would fail on its own; fail once instead.
+			Scanner& base = scanner;
+			if (!base.current_.empty())
+				batch.error_ = TResult{Token{ Token::Type::Invalid, base.current_.substr(0, 0) }, ErrorCode::DocumentTooLarge};
+			base.current_ = base.current_.substr(base.current_.size());
+			return batch;
+		}
+		for ( ; batch.count_ < limit; ++batch.count_)
+		{
+			TResult result = scanner.next();
+			if (!result.is_token())
+			{
+				if (result.is_error())
+					batch.error_ = std::move(result);
+				break;
+			}
+			if (!out.push_back(result.token()))
+			{
+				batch.error_ = TResult{result.token(), ErrorCode::TokenTooLong};
+				break;
+			}
+			if (scanner.decodes_numbers() && (result.token().type_ == Token::Type::Integer || result.token().type_ == Token::Type::Float))
+				out.set_number(out.size() - 1, scanner.last_number());
+		}
+		return batch;
+	}
 };
 
 
@@ -0,0 +1,172 @@
+// Benchmarks for the scanners: Scanner::next over each class of token, and whole
+// documents collected into a TokenBuffer with each engine.
+
+#include "app-collect.h"
+#include "bench-documents.h"
+#include "content-hash.h"
+#include "keyword.h"
+#include "retokenize.h"
+#include "scanner.h"
+#include "scanner-indexed.h"
+#include "scanner-table.h"
+#include "symbol-table.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+using namespace kfs;
+using namespace kfs::bench;
+
+
+namespace
+{
+
+// A document made of one class of token, so regressions can be pinned to a path.
+void BM_ScanNext(benchmark::State& state, string_view fragment)
+{
+	const std::string source = repeat(fragment, document_size);
+	size_t tokens = 0;
+	for (auto _ : state)
+	{
+		Scanner scanner(source);
+		tokens = 0;
+		for (auto result = scanner.next(); !result.is_none(); result = scanner.next())
+		{
+			benchmark::DoNotOptimize(result);
+			++tokens;
+		}
+	}
+	report_throughput(state, source.size(), tokens);
+}
+
+BENCHMARK_CAPTURE(BM_ScanNext, words, "identifier another_name x Y2 ");
+BENCHMARK_CAPTURE(BM_ScanNext, keywords, "enum type true false ");
+BENCHMARK_CAPTURE(BM_ScanNext, integers, "12345 -678 0 +9 ");
+BENCHMARK_CAPTURE(BM_ScanNext, floats, "3.14159 -.5 2. +0.001 ");
+BENCHMARK_CAPTURE(BM_ScanNext, strings, "\"a string literal\" \"\" ");
+BENCHMARK_CAPTURE(BM_ScanNext, escaped_strings, "\"a \\\"quoted\\\" string\" ");
+BENCHMARK_CAPTURE(BM_ScanNext, punctuation, "{}[]=:::,");
+BENCHMARK_CAPTURE(BM_ScanNext, line_comments, "// a line comment that runs on for a while\nx ");
+BENCHMARK_CAPTURE(BM_ScanNext, block_comments, "/* a block /* nested */ comment */ x ");
+BENCHMARK_CAPTURE(BM_ScanNext, whitespace, "          \n\t\t\t\t\r\n    x");
+
+
+// The app's scanning phase, with each engine.
+template<typename ScannerType>
+void BM_CollectTokens(benchmark::State& state)
+{
+	const std::string source = make_schema(document_size);
+	size_t tokens = 0;
+	const PerfCounters perf;
+	const PerfSample before = perf.read();
+	for (auto _ : state)
+	{
+		ScannerType scanner(source);
+		auto buffer = collect_tokens(scanner, "bench", false);
+		tokens = buffer.size();
+		benchmark::DoNotOptimize(buffer);
+	}
+	report_perf(state, perf.read() - before, source.size(), tokens);
+	report_throughput(state, source.size(), tokens);
+}
+
+BENCHMARK_TEMPLATE(BM_CollectTokens, Scanner);
+BENCHMARK_TEMPLATE(BM_CollectTokens, TableScanner);
+BENCHMARK_TEMPLATE(BM_CollectTokens, IndexedScanner);
+
+
+// Bringing a document's tokens up to date after renaming an identifier halfway through
+// it, to compare with scanning the whole document again.
+void BM_Retokenize(benchmark::State& state)
+{
+	std::string source = make_schema(document_size);
+	Scanner scanner(source);
+	TokenBuffer tokens = collect_tokens(scanner, "bench", false);
+	const size_t at = source.find(" T", source.size() / 2) + 2;
+	RetokenizeResult result;
+	for (auto _ : state)
+	{
+		const char replacement[] = { source[at] == 'Q' ? 'R' : 'Q', 0 };
+		const TextEdit edit = apply_edit(source, at, 1, replacement);
+		result = retokenize(tokens, source, edit);
+		benchmark::DoNotOptimize(tokens);
+	}
+	// Throughput is of what was rescanned, not the whole document.
+	state.counters["rescanned"] = double(result.rescanned_);
+	report_throughput(state, result.rescanned_, result.inserted_);
+}
+
+BENCHMARK(BM_Retokenize);
+
+
+// Hashing a document, which is all a parse cache hit costs beyond reading it; compare
+// with BM_CollectTokens.
+void BM_ContentHash(benchmark::State& state)
+{
+	const std::string source = make_schema(document_size);
+	for (auto _ : state)
+		benchmark::DoNotOptimize(content_hash(source));
+	report_throughput(state, source.size(), 0);
+}
+
+BENCHMARK(BM_ContentHash);
+
+
+// The words of a schema, for the lookup benchmarks.
+std::vector<string_view> schema_words(const std::string& source)
+{
+	std::vector<string_view> words;
+	Scanner scanner(source);
+	for (auto result = scanner.next(); !result.is_none(); result = scanner.next())
+		if (result.is_token() && result.token().type_ == Token::Type::Word)
+			words.push_back(result.token().source_);
+	return words;
+}
+
+
+void BM_ClassifyKeyword(benchmark::State& state)
+{
+	const std::string source = make_schema(document_size);
+	const auto words = schema_words(source);
+	for (auto _ : state)
+		for (string_view word : words)
+			benchmark::DoNotOptimize(classify_keyword(word));
+	report_throughput(state, 0, words.size());
+}
+BENCHMARK(BM_ClassifyKeyword);
+
+
+// Interning every word of a document into a fresh table, as the parser does.
+void BM_SymbolIntern(benchmark::State& state)
+{
+	const std::string source = make_schema(document_size);
+	const auto words = schema_words(source);
+	for (auto _ : state)
+	{
+		SymbolTable symbols;
+		for (string_view word : words)
+			benchmark::DoNotOptimize(symbols.intern(word));
+	}
+	report_throughput(state, 0, words.size());
+}
+BENCHMARK(BM_SymbolIntern);
+
+
+// Finding every word in a table that already holds them.
+void BM_SymbolFind(benchmark::State& state)
+{
+	const std::string source = make_schema(document_size);
+	const auto words = schema_words(source);
+	SymbolTable symbols;
+	for (string_view word : words)
+		symbols.intern(word);
+	for (auto _ : state)
+		for (string_view word : words)
+			benchmark::DoNotOptimize(symbols.find(word));
+	report_throughput(state, 0, words.size());
+}
+BENCHMARK(BM_SymbolFind);
+
+}
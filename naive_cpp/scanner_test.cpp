@@ -258,6 +258,30 @@ TEST(ScannerTest, SkipCommentUnterminatedBlock)
 }
 
 
+TEST(ScannerTest, SkipCommentNestedBlock)
+{
+	TestScanner scanner("/* outer /* inner */ still outer */X");
+	const TResult result = scanner.skip_comment();
+	EXPECT_TRUE(result.is_token());
+	EXPECT_EQ(Token::Type::CloseComment, result.token().type_);
+	EXPECT_EQ("/* outer /* inner */ still outer */", result.token().source_);
+	EXPECT_EQ('X', scanner.front());
+}
+
+
+TEST(ScannerTest, SkipCommentUnterminatedNestedBlock)
+{
+	// The inner comment closes, but the outer one doesn't: the error is at the outer opening.
+	TestScanner scanner("/* outer /* inner */ X\n/*/");
+	const TResult result = scanner.skip_comment();
+	EXPECT_TRUE(result.is_error());
+	EXPECT_EQ(Token::Type::OpenComment, result.token().type_);
+	EXPECT_EQ(ErrorCode::UnterminatedComment, result.code());
+	EXPECT_EQ("/* outer /* inner */ X\n/*/", result.token().source_);
+	EXPECT_EQ(0, scanner.front());
+}
+
+
 TEST(ScannerTest, ScanString)
 {
 	TestScanner scanner("\"hello world\"");
@@ -308,11 +332,44 @@ TEST(ScannerTest, ScanStringUnterminatedEOL)
 }
 
 
+TEST(ScannerTest, ScanStringEscapes)
+{
+	struct Case {
+		string_view input;
+		string_view capture;
+		bool        escaped;
+		bool        error;
+	} cases[] = {
+		{ R"("plain")",              R"("plain")",              false, false },
+		{ R"("say \"hi\"" x)",       R"("say \"hi\"")",         true,  false },
+		{ R"("back\\slash")",        R"("back\\slash")",        true,  false },
+		{ R"("ends in \\")",         R"("ends in \\")",         true,  false },
+		{ R"("not an \escape")",     R"("not an \escape")",     false, false },
+		{ R"("\\\"")",               R"("\\\"")",               true,  false },
+		{ "\"trailing \\",           "\"trailing \\",           false, true },
+		{ "\"escaped \\\" but\n\"",  "\"escaped \\\" but",      true,  true },
+		{ "\"no newline \\\n\"",     "\"no newline \\",         false, true },
+	};
+	for (const auto& c : cases)
+	{
+		SCOPED_TRACE(c.input);
+		TestScanner scanner(c.input);
+		const TResult result = scanner.scan_string();
+		EXPECT_EQ(c.error, result.is_error());
+		ASSERT_TRUE(result.has_token());
+		EXPECT_EQ(Token::Type::String, result.token().type_);
+		EXPECT_EQ(c.capture, result.token().source_);
+		EXPECT_EQ(c.escaped, result.token().is_escaped());
+	}
+}
+
+
 TEST(ScannerTest, ScanNumber)
 {
 	// Scan number takes it as read that the byte at the front of current is numeric,
 	// then scans until it reaches a non-numeric character.
-	// If that character is '.', and it hasn't seen a dot yet, it will continue.
+	// If that character is '.', and it hasn't seen a dot yet, it will continue; a
+	// leading '.' is a float's only dot.
 	// Otherwise, it ends on the first non-digit or reaching EOI.
 	struct PassCase {
 		std::string_view input;
@@ -327,6 +384,9 @@ TEST(ScannerTest, ScanNumber)
 		PassCase { "12.a",	"12.",	"a",   Token::Type::Float },
 		PassCase { "1..", 	"1.",	".",   Token::Type::Float },
 		PassCase { "1.2.",  "1.2",  ".",   Token::Type::Float },
+		PassCase { ".5",    ".5",   "",    Token::Type::Float },
+		PassCase { ".25a",  ".25",  "a",   Token::Type::Float },
+		PassCase { ".5.3",  ".5",   ".3",  Token::Type::Float },
 	};
 	for (const PassCase& c: cases)
 	{
@@ -508,7 +568,9 @@ TEST(ScannerTest, NextComments)
 		PassCase{"empty line comment", "//", 1, 2},
 		PassCase{"multiple line comments", "//\n//\n//*/\n", 3, 8},
 		PassCase{"eoi empty block comment", "/**/", 1, 4},
-		PassCase{"eoi // block comment", "/*//*/", 1, 6},  // this is only valid in this naive version that doesn't do nesting.
+		PassCase{"eoi // block comment", "/*/ /*/ */ */", 1, 13},
+		PassCase{"nested block comments", "/* a /* b /* c */ */ d */", 1, 25},
+		PassCase{"adjacent nested comments", "/*/**//**/*//**/", 2, 16},
 		PassCase{"block-hello plus line world", "/* hello */// world\n\n", 2, 19},
 		PassCase{"multi comment", "///**/\n/**///\n/*\n\r\n\t\n*/", 4, 21},
 	};
@@ -687,3 +749,52 @@ TEST(ScannerTest, NextFailures)
 		EXPECT_EQ(source, result.token().source_);
 	}
 }
+
+
+TEST(ScannerTest, NextBatch)
+{
+	const string_view source = "enum X { A, B } ~ type Y { int i = -1 }";
+
+	// Collect the stream the slow way for reference.
+	std::vector<Token> expected;
+	{
+		Scanner scanner(source);
+		for (auto result = scanner.next(); !result.is_none(); result = scanner.next())
+			if (result.is_token())
+				expected.push_back(result.token());
+	}
+	ASSERT_EQ(15, expected.size());
+
+	// Small batches, so we see a full batch, an error, and then end-of-input.
+	Scanner scanner(source);
+	std::vector<Token> tokens;
+	Token buffer[4];
+
+	auto batch = scanner.next_batch(buffer);
+	EXPECT_EQ(4, batch.count_);
+	EXPECT_FALSE(batch.is_error());
+	tokens.insert(tokens.end(), buffer, buffer + batch.count_);
+
+	batch = scanner.next_batch(buffer);
+	EXPECT_EQ(3, batch.count_);  // ",", "B", "}"
+	ASSERT_TRUE(batch.is_error());
+	EXPECT_EQ("unexpected character", batch.error_.error());
+	EXPECT_EQ("~", batch.error_.token().source_);
+	tokens.insert(tokens.end(), buffer, buffer + batch.count_);
+
+	for (;;)
+	{
+		batch = scanner.next_batch(buffer);
+		EXPECT_FALSE(batch.is_error());
+		tokens.insert(tokens.end(), buffer, buffer + batch.count_);
+		if (batch.count_ < std::size(buffer))
+			break;
+	}
+
+	EXPECT_EQ(expected, tokens);
+
+	// Once exhausted, further batches are empty.
+	batch = scanner.next_batch(buffer);
+	EXPECT_EQ(0, batch.count_);
+	EXPECT_FALSE(batch.is_error());
+}
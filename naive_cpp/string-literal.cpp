@@ -0,0 +1,69 @@
+// Values of string literal tokens.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "string-literal.h"
+#include "scanner-simd.h"
+
+#include <cstring>
+
+
+namespace kfs
+{
+
+
+string_view string_contents(const Token& token) noexcept
+{
+	string_view text = token.source_;
+	if (!text.empty() && text.front() == '"')
+		text.remove_prefix(1);
+	// A closing quote is one that isn't escaped; "\\" ends with one but "\" doesn't.
+	if (!text.empty() && text.back() == '"')
+	{
+		size_t backslashes = 0;
+		while (backslashes + 1 < text.size() && text[text.size() - 2 - backslashes] == '\\')
+			++backslashes;
+		if (backslashes % 2 == 0)
+			text.remove_suffix(1);
+	}
+	return text;
+}
+
+
+string_view string_value(const Token& token, Arena& arena)
+{
+	const string_view text = string_contents(token);
+	if (!token.is_escaped())
+		return text;
+
+	char* out = arena.allocate(text.size());
+	const size_t length = unescape(text, out);
+	arena.shrink(out, text.size(), length);
+	return string_view(out, length);
+}
+
+
+// Copy the runs between backslashes in bulk.
+size_t unescape(string_view text, char* out) noexcept
+{
+	size_t written = 0;
+	for (size_t pos = 0; pos < text.size(); )
+	{
+		const size_t run = simd::find_byte(text.data() + pos, text.size() - pos, '\\');
+		std::memcpy(out + written, text.data() + pos, run);
+		written += run;
+		pos += run;
+		if (pos >= text.size())
+			break;
+
+		// Only \" and \\ are escapes, any other backslash is kept.
+		if (pos + 1 < text.size() && (text[pos + 1] == '"' || text[pos + 1] == '\\'))
+			++pos;
+		out[written++] = text[pos++];
+	}
+	return written;
+}
+
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_STRING_LITERAL_H
+#define INCLUDED_KFS_NAIVE_CPP_STRING_LITERAL_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Values of string literal tokens.
+//
+// The scanner doesn't unescape string literals, it just flags the ones that have
+// escapes (Token::Escaped). A literal without escapes is its own value, so getting
+// it is free; only the flagged ones are copied, into an arena, and only when
+// someone actually asks for the value.
+
+
+#include "arena.h"
+#include "common.h"
+#include "token.h"
+
+
+namespace kfs
+{
+
+
+//! Returns the text between the quotes of a string literal token. Tolerates an
+//! unterminated literal, which has no closing quote.
+[[nodiscard]]
+string_view string_contents(const Token& token) noexcept;
+
+//! Returns the value of a string literal token: a view of its contents if it has
+//! no escapes, otherwise a view of an unescaped copy made in 'arena'.
+[[nodiscard]]
+string_view string_value(const Token& token, Arena& arena);
+
+//! Replaces the \" and \\ escapes in 'text' with the characters they stand for,
+//! writing the result to 'out', which must have room for text.size() bytes.
+//! Returns the number of bytes written.
+size_t unescape(string_view text, char* out) noexcept;
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_STRING_LITERAL_H
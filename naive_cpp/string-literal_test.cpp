@@ -0,0 +1,79 @@
+// Unit tests for string literal values.
+
+#include "scanner.h"
+#include "string-literal.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace kfs;
+
+
+namespace
+{
+
+Token scan_literal(string_view source)
+{
+	Scanner scanner(source);
+	return scanner.next().token();
+}
+
+}
+
+
+TEST(StringLiteralTest, Contents)
+{
+	EXPECT_EQ("", string_contents(Token{ Token::Type::String, R"("")" }));
+	EXPECT_EQ("abc", string_contents(Token{ Token::Type::String, R"("abc")" }));
+	EXPECT_EQ(R"(a\")", string_contents(Token{ Token::Type::String, R"("a\")" }));
+	EXPECT_EQ(R"(a\\)", string_contents(Token{ Token::Type::String, R"("a\\")" }));
+	EXPECT_EQ("unterminated", string_contents(Token{ Token::Type::String, R"("unterminated)" }));
+}
+
+
+TEST(StringLiteralTest, Unescape)
+{
+	struct Case {
+		string_view text;
+		string_view value;
+	} cases[] = {
+		{ "",                       "" },
+		{ "plain",                  "plain" },
+		{ R"(say \"hi\")",          R"(say "hi")" },
+		{ R"(back\\slash)",         R"(back\slash)" },
+		{ R"(\\\")",                R"(\")" },
+		{ R"(not \an escape)",      R"(not \an escape)" },
+		{ R"(trailing \)",          R"(trailing \)" },
+	};
+	for (const auto& c : cases)
+	{
+		SCOPED_TRACE(c.text);
+		std::string out(c.text.size(), '?');
+		out.resize(unescape(c.text, out.data()));
+		EXPECT_EQ(c.value, out);
+	}
+}
+
+
+TEST(StringLiteralTest, ValuesAreOnlyCopiedWhenEscaped)
+{
+	Arena arena;
+	const string_view source = R"("plain" "with \"escapes\" and \\ slashes")";
+	Scanner scanner(source);
+
+	const Token plain = scanner.next().token();
+	ASSERT_FALSE(plain.is_escaped());
+	const string_view plain_value = string_value(plain, arena);
+	EXPECT_EQ("plain", plain_value);
+	EXPECT_EQ(source.data() + 1, plain_value.data());
+	EXPECT_EQ(0, arena.bytes_used());
+
+	const Token escaped = scanner.next().token();
+	ASSERT_TRUE(escaped.is_escaped());
+	const string_view escaped_value = string_value(escaped, arena);
+	EXPECT_EQ(R"(with "escapes" and \ slashes)", escaped_value);
+	EXPECT_EQ(escaped_value.size(), arena.bytes_used());
+
+	EXPECT_EQ(R"(\)", string_value(scan_literal(R"("\\")"), arena));
+}
@@ -0,0 +1,181 @@
+// Stage-1 structural index of a source document.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "structural-index.h"
+#include "scanner-simd.h"
+
+#include <bit>
+
+
+namespace kfs
+{
+
+
+namespace
+{
+
+// Finds the first set bit at or after 'from' in the mask selected from each block,
+// or 'end' if there isn't one.
+template<typename Select>
+size_t next_bit(const std::vector<simd::BlockMasks>& blocks, size_t from, size_t end, Select select) noexcept
+{
+	for (size_t block = from / 64; block < blocks.size(); ++block)
+	{
+		uint64_t bits = select(blocks[block]);
+		if (block == from / 64)
+			bits &= ~uint64_t(0) << (from % 64);
+		if (bits != 0)
+			return std::min(end, block * 64 + std::countr_zero(bits));
+	}
+	return end;
+}
+
+// Sets the bits for [begin, end).
+void set_range(std::vector<uint64_t>& bits, size_t begin, size_t end) noexcept
+{
+	for ( ; begin < end && begin % 64 != 0; ++begin)
+		bits[begin / 64] |= uint64_t(1) << (begin % 64);
+	for ( ; begin + 64 <= end; begin += 64)
+		bits[begin / 64] = ~uint64_t(0);
+	for ( ; begin < end; ++begin)
+		bits[begin / 64] |= uint64_t(1) << (begin % 64);
+}
+
+}
+
+
+StructuralIndex::StructuralIndex(string_view source)
+	: source_(source)
+{
+	const size_t size = source.size();
+	const size_t block_count = (size + 63) / 64;
+
+	// Classify.
+	std::vector<simd::BlockMasks> blocks(block_count);
+	for (size_t block = 0; block < block_count; ++block)
+	{
+		const size_t offset = block * 64;
+		blocks[block] = simd::classify_block(source.data() + offset, std::min<size_t>(64, size - offset));
+	}
+
+	// Resolve strings and comments: outside of both, only a quote or a slash can
+	// change state, and once inside one we only need to find what ends it.
+	strings_.assign(block_count, 0);
+	escaped_.assign(block_count, 0);
+	comments_.assign(block_count, 0);
+	for (size_t pos = 0; ; )
+	{
+		pos = next_bit(blocks, pos, size, [](const simd::BlockMasks& b) { return b.quote_ | b.slash_; });
+		if (pos >= size)
+			break;
+
+		if (source[pos] == '"')
+		{
+			// Hop over the \" and \\ escapes to whatever ends the string.
+			size_t end = pos + 1;
+			bool escaped = false;
+			for (;;)
+			{
+				end = next_bit(blocks, end, size, [](const simd::BlockMasks& b) { return b.quote_ | b.backslash_ | b.newline_ | b.return_; });
+				if (end >= size || source[end] != '\\')
+					break;
+				if (end + 1 < size && (source[end + 1] == '"' || source[end + 1] == '\\'))
+				{
+					escaped = true;
+					end += 2;
+				}
+				else
+					end += 1;
+			}
+			set_range(strings_, pos, end);
+			if (escaped)
+				escaped_[pos / 64] |= uint64_t(1) << (pos % 64);
+			pos = (end < size && source[end] == '"') ? end + 1 : end;
+		}
+		else if (pos + 1 < size && source[pos + 1] == '/')
+		{
+			const size_t end = next_bit(blocks, pos + 2, size, [](const simd::BlockMasks& b) { return b.newline_; });
+			set_range(comments_, pos, end);
+			comment_count_ += 1;
+			comment_bytes_ += end - pos;
+			pos = end;
+		}
+		else if (pos + 1 < size && source[pos + 1] == '*')
+		{
+			// Comments nest, so hop between the slashes and stars pairing each with the
+			// byte after it until the depth returns to zero.
+			size_t depth = 1, end = pos + 2;
+			while (depth > 0)
+			{
+				end = next_bit(blocks, end, size, [](const simd::BlockMasks& b) { return b.slash_ | b.star_; });
+				if (end + 1 >= size)
+					break;
+				if (source[end] == '/' && source[end + 1] == '*')
+					++depth, end += 2;
+				else if (source[end] == '*' && source[end + 1] == '/')
+					--depth, end += 2;
+				else
+					++end;
+			}
+			if (depth > 0)
+			{
+				unterminated_comment_ = pos;
+				break;
+			}
+			set_range(comments_, pos, end);
+			comment_count_ += 1;
+			comment_bytes_ += end - pos;
+			pos = end;
+		}
+		else
+		{
+			// A slash on its own, which stage 2 will report.
+			++pos;
+		}
+	}
+
+	// Whitespace and structure only count outside of strings and comments.
+	whitespace_.resize(block_count);
+	structural_.resize(block_count);
+	for (size_t block = 0; block < block_count; ++block)
+	{
+		uint64_t outside = ~(strings_[block] | comments_[block]);
+		if (unterminated_comment_ != npos && block >= unterminated_comment_ / 64)
+			outside &= (block == unterminated_comment_ / 64) ? ~(~uint64_t(0) << (unterminated_comment_ % 64)) : 0;
+		whitespace_[block] = blocks[block].whitespace_ & outside;
+		structural_[block] = blocks[block].structural_ & outside;
+	}
+}
+
+
+size_t StructuralIndex::next_significant(size_t offset) const noexcept
+{
+	for (size_t block = offset / 64; block < whitespace_.size(); ++block)
+	{
+		uint64_t bits = ~(whitespace_[block] | comments_[block]);
+		if (block == offset / 64)
+			bits &= ~uint64_t(0) << (offset % 64);
+		if (bits != 0)
+			return std::min(source_.size(), block * 64 + std::countr_zero(bits));
+	}
+	return source_.size();
+}
+
+
+size_t StructuralIndex::string_end(size_t offset) const noexcept
+{
+	for (size_t block = offset / 64; block < strings_.size(); ++block)
+	{
+		uint64_t bits = ~strings_[block];
+		if (block == offset / 64)
+			bits &= ~uint64_t(0) << (offset % 64);
+		if (bits != 0)
+			return std::min(source_.size(), block * 64 + std::countr_zero(bits));
+	}
+	return source_.size();
+}
+
+
+}
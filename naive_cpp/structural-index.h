@@ -0,0 +1,113 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_STRUCTURAL_INDEX_H
+#define INCLUDED_KFS_NAIVE_CPP_STRUCTURAL_INDEX_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// The StructuralIndex is a "stage 1" pass over a whole document, in the style of
+// simdjson: the source is classified 64 bytes at a time into bitmaps (one bit per
+// byte), and then the string and comment regions are resolved by hopping between
+// the set bits of the quote/slash/star/newline maps rather than by looking at every
+// character.
+//
+// The result describes, for every byte of the source, whether it is whitespace, a
+// structural character ('{', '}', '[', ']', '=', ':' or ','), part of a string
+// literal, or part of a comment - everything "stage 2" (the IndexedScanner) needs
+// to find token boundaries without a per-character state machine. Since it's just
+// bitmaps, it can be built once and kept for other passes over the same source.
+
+
+#include "common.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+namespace kfs
+{
+
+
+struct StructuralIndex
+{
+public:
+	static constexpr size_t npos = string_view::npos;
+
+	StructuralIndex() = default;
+
+	//! Classifies and resolves the whole of 'source', which must outlive the index.
+	explicit StructuralIndex(string_view source);
+
+	//! The source the index describes.
+	[[nodiscard]]
+	string_view source() const noexcept { return source_; }
+
+	//! The bitmaps, one word per 64 bytes of source. Whitespace and structural bits
+	//! are only set outside of strings and comments. A string's bits start at its
+	//! opening quote and stop before whatever ended it: the closing quote, or the
+	//! end of the line for an unterminated string. Comment bits cover the whole of
+	//! each (terminated) comment, but not the newline after a line comment.
+	[[nodiscard]]
+	std::span<const uint64_t> whitespace() const noexcept { return whitespace_; }
+	[[nodiscard]]
+	std::span<const uint64_t> structural() const noexcept { return structural_; }
+	[[nodiscard]]
+	std::span<const uint64_t> strings() const noexcept { return strings_; }
+	[[nodiscard]]
+	std::span<const uint64_t> comments() const noexcept { return comments_; }
+
+	//! Offset of a block comment that runs to the end of the source, or npos.
+	[[nodiscard]]
+	size_t unterminated_comment() const noexcept { return unterminated_comment_; }
+
+	//! Number of (terminated) comments in the source, and their total length.
+	[[nodiscard]]
+	size_t comment_count() const noexcept { return comment_count_; }
+	[[nodiscard]]
+	size_t comment_bytes() const noexcept { return comment_bytes_; }
+
+	//! Returns the offset of the first byte at or after 'offset' that is neither
+	//! whitespace nor comment, or the size of the source if there isn't one.
+	[[nodiscard]]
+	size_t next_significant(size_t offset) const noexcept;
+
+	//! Returns true if the byte at 'offset' is a structural character.
+	[[nodiscard]]
+	bool is_structural(size_t offset) const noexcept { return test(structural_, offset); }
+
+	//! Returns true if the byte at 'offset' is part of a string literal.
+	[[nodiscard]]
+	bool is_string(size_t offset) const noexcept { return test(strings_, offset); }
+
+	//! Given the offset of a string's opening quote, returns the offset of the byte
+	//! that ended it: the closing quote, a line terminator, or the end of the source.
+	//! The quote of a \" escape doesn't end a string.
+	[[nodiscard]]
+	size_t string_end(size_t offset) const noexcept;
+
+	//! Given the offset of a string's opening quote, returns true if the string has
+	//! \" or \\ escapes.
+	[[nodiscard]]
+	bool is_escaped(size_t offset) const noexcept { return test(escaped_, offset); }
+
+protected:
+	static bool test(const std::vector<uint64_t>& bits, size_t offset) noexcept
+	{
+		return offset / 64 < bits.size() && (bits[offset / 64] >> (offset % 64)) & 1;
+	}
+
+	string_view				source_					{ };
+	std::vector<uint64_t>	whitespace_				{ };
+	std::vector<uint64_t>	structural_				{ };
+	std::vector<uint64_t>	strings_				{ };
+	std::vector<uint64_t>	comments_				{ };
+	std::vector<uint64_t>	escaped_				{ };	// Set at the opening quote.
+	size_t					unterminated_comment_	{ npos };
+	size_t					comment_count_			{ 0 };
+	size_t					comment_bytes_			{ 0 };
+};
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_STRUCTURAL_INDEX_H
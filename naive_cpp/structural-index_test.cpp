@@ -0,0 +1,194 @@
+// Unit tests for the structural index and the two-stage scanner built on it.
+
+#include "scanner.h"
+#include "scanner-indexed.h"
+#include "scanner-simd.h"
+#include "structural-index.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace kfs;
+
+
+namespace
+{
+
+// Token equality ignores the flags, so compare them separately.
+template<typename ScannerType>
+std::vector<std::tuple<Token, uint8_t, bool>> scan_all(string_view source)
+{
+	std::vector<std::tuple<Token, uint8_t, bool>> tokens;
+	ScannerType scanner(source);
+	for (auto result = scanner.next(); !result.is_none(); result = scanner.next())
+		tokens.emplace_back(result.token(), result.token().flags_, result.is_error());
+	return tokens;
+}
+
+// Renders one of the index's bitmaps as a string the same length as the source.
+std::string render(std::span<const uint64_t> bits, size_t size)
+{
+	std::string text(size, '.');
+	for (size_t i = 0; i < size; ++i)
+		if ((bits[i / 64] >> (i % 64)) & 1)
+			text[i] = '^';
+	return text;
+}
+
+}
+
+
+TEST(StructuralIndexTest, Empty)
+{
+	StructuralIndex index("");
+	EXPECT_TRUE(index.whitespace().empty());
+	EXPECT_EQ(0, index.next_significant(0));
+	EXPECT_EQ(StructuralIndex::npos, index.unterminated_comment());
+}
+
+
+TEST(StructuralIndexTest, Regions)
+{
+	const string_view source = "a = \"x{ }\" // c{\n{/* \"]\" */:\"open\n\"\"";
+	StructuralIndex index(source);
+	EXPECT_EQ("..^..............^.........^........", render(index.structural(), source.size()));
+	EXPECT_EQ("....^^^^^...................^^^^^.^.", render(index.strings(), source.size()));
+	EXPECT_EQ("...........^^^^^..^^^^^^^^^.........", render(index.comments(), source.size()));
+	EXPECT_EQ(".^.^......^.....^................^..", render(index.whitespace(), source.size()));
+	EXPECT_EQ(2, index.comment_count());
+	EXPECT_EQ(5 + 9, index.comment_bytes());
+
+	EXPECT_EQ(0, index.next_significant(0));
+	EXPECT_EQ(2, index.next_significant(1));
+	EXPECT_EQ(17, index.next_significant(10));
+	EXPECT_EQ(9, index.string_end(4));
+	EXPECT_EQ(33, index.string_end(28));
+	EXPECT_EQ(35, index.string_end(34));
+}
+
+
+TEST(StructuralIndexTest, UnterminatedComment)
+{
+	const string_view source = "x /* a } \"b\" ";
+	StructuralIndex index(source);
+	EXPECT_EQ(2, index.unterminated_comment());
+	EXPECT_EQ(2, index.next_significant(1));
+	EXPECT_EQ(std::string(source.size(), '.'), render(index.structural(), source.size()));
+	EXPECT_EQ(".^...........", render(index.whitespace(), source.size()));
+	EXPECT_EQ(0, index.comment_count());
+}
+
+
+TEST(StructuralIndexTest, EscapedStrings)
+{
+	const string_view source = R"("a\"{" = "\\" "\q")";
+	StructuralIndex index(source);
+	EXPECT_EQ(".......^..........", render(index.structural(), source.size()));
+	EXPECT_EQ("^^^^^....^^^..^^^.", render(index.strings(), source.size()));
+	EXPECT_EQ(5, index.string_end(0));
+	EXPECT_EQ(12, index.string_end(9));
+	EXPECT_EQ(17, index.string_end(14));
+	EXPECT_TRUE(index.is_escaped(0));
+	EXPECT_TRUE(index.is_escaped(9));
+	EXPECT_FALSE(index.is_escaped(14));
+}
+
+
+TEST(StructuralIndexTest, NestedComments)
+{
+	const string_view source = "{/* a /* } */ ] */}/* x /* y */";
+	StructuralIndex index(source);
+	EXPECT_EQ("^.................^............", render(index.structural(), source.size()));
+	EXPECT_EQ(".^^^^^^^^^^^^^^^^^.............", render(index.comments(), source.size()));
+	EXPECT_EQ(1, index.comment_count());
+	EXPECT_EQ(19, index.unterminated_comment());
+	EXPECT_EQ(18, index.next_significant(1));
+}
+
+
+// A region that spans several blocks.
+TEST(StructuralIndexTest, LongRegions)
+{
+	const std::string source = "{/*" + std::string(200, '}') + "*/\"" + std::string(200, ' ') + "\"}";
+	StructuralIndex index(source);
+	EXPECT_EQ(0, index.next_significant(0));
+	EXPECT_EQ(205, index.next_significant(1));
+	EXPECT_TRUE(index.is_string(205));
+	EXPECT_TRUE(index.is_string(405));
+	EXPECT_EQ(406, index.string_end(205));
+	EXPECT_TRUE(index.is_structural(407));
+	EXPECT_FALSE(index.is_structural(100));
+}
+
+
+TEST(IndexedScannerTest, AgreesOnAllShortSequences)
+{
+	const string_view alphabet = " \na_Z09\"{}[]:=,+-./*~\x80";
+	std::string source(3, ' ');
+	for (char a : alphabet)
+	{
+		for (char b : alphabet)
+		{
+			for (char c : alphabet)
+			{
+				source[0] = a; source[1] = b; source[2] = c;
+				for (size_t len = 1; len <= 3; ++len)
+				{
+					const string_view input(source.data(), len);
+					ASSERT_EQ(scan_all<Scanner>(input), scan_all<IndexedScanner>(input)) << "input |" << input << "|";
+				}
+			}
+		}
+	}
+}
+
+
+TEST(IndexedScannerTest, AgreesOnMixedInput)
+{
+	static const char* fragments[] = {
+		" ", "\r\n", "\t", "enum", "type", "Name", "_x1", "0", "123", "4.5", ".5", "+1", "-.25", "+.", "-x",
+		"\"\"", "\"text with { } = : , / * // /* and spaces\"", "\"unterminated\n", "\"esc\\\"aped\\\\\"", "\"\\q\"", "\"cr\r",
+		"{", "}", "[", "]", "=", ":", "::", ":::", ",", "// comment { \" \n", "/* block \" { \n */", "/**/",
+		"/*/ x */", "/", "*", "~", "@", std::string(70, ' ').c_str(),
+	};
+	std::mt19937 rng(7);
+	std::string source;
+	while (source.size() < 32 * 1024)
+		source += fragments[rng() % std::size(fragments)];
+
+	const simd::Level original = simd::active_level();
+	for (simd::Level level : { simd::Level::Scalar, simd::Level::Swar, simd::Level::SSE42, simd::Level::AVX2, simd::Level::AVX512 })
+	{
+		if (!simd::set_level(level))
+			continue;
+		SCOPED_TRACE(simd::level_to_str(level));
+		EXPECT_EQ(scan_all<Scanner>(source), scan_all<IndexedScanner>(source));
+		// Ending in an unterminated comment.
+		const std::string open = source + "/* the end";
+		EXPECT_EQ(scan_all<Scanner>(open), scan_all<IndexedScanner>(open));
+	}
+	simd::set_level(original);
+}
+
+
+TEST(IndexedScannerTest, ReusesIndex)
+{
+	const string_view source = "type T { int x = 1 }";
+	StructuralIndex index(source);
+	const auto comment_count = index.comment_count();
+
+	IndexedScanner scanner(std::move(index));
+	EXPECT_EQ(source, scanner.source());
+	EXPECT_EQ(comment_count, scanner.index().comment_count());
+	EXPECT_EQ(scan_all<Scanner>(source), scan_all<IndexedScanner>(source));
+
+	Token tokens[16];
+	const auto batch = scanner.next_batch(tokens);
+	EXPECT_FALSE(batch.is_error());
+	EXPECT_EQ(8, batch.count_);
+	EXPECT_EQ("}", tokens[7].source_);
+}
@@ -0,0 +1,75 @@
+// Interning of identifiers.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "symbol-table.h"
+
+
+namespace kfs
+{
+
+
+uint64_t SymbolTable::hash_name(string_view name) noexcept
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (const char c : name)
+		hash = (hash ^ uint8_t(c)) * 0x100000001B3ULL;
+	return hash;
+}
+
+
+// Linear probing; the table is kept at most half full, so there is always a free
+// slot to stop at.
+size_t SymbolTable::probe(string_view name, uint64_t hash) const noexcept
+{
+	const size_t mask = slots_.size() - 1;
+	for (size_t slot = size_t(hash) & mask; ; slot = (slot + 1) & mask)
+	{
+		const SymbolId id = slots_[slot];
+		if (id == no_symbol || (entries_[id].hash_ == hash && entries_[id].name_ == name))
+			return slot;
+	}
+}
+
+
+SymbolId SymbolTable::find(string_view name) const noexcept
+{
+	if (slots_.empty())
+		return no_symbol;
+	return slots_[probe(name, hash_name(name))];
+}
+
+
+SymbolId SymbolTable::intern(string_view name)
+{
+	if ((entries_.size() + 1) * 2 > slots_.size())
+		grow();
+
+	const uint64_t hash = hash_name(name);
+	const size_t slot = probe(name, hash);
+	if (slots_[slot] != no_symbol)
+		return slots_[slot];
+
+	const auto id = static_cast<SymbolId>(entries_.size());
+	entries_.push_back(Entry{ names_.copy(name), hash });
+	slots_[slot] = id;
+	return id;
+}
+
+
+void SymbolTable::grow()
+{
+	slots_.assign(slots_.empty() ? 64 : slots_.size() * 2, no_symbol);
+	const size_t mask = slots_.size() - 1;
+	for (SymbolId id = 0; id < entries_.size(); ++id)
+	{
+		size_t slot = size_t(entries_[id].hash_) & mask;
+		while (slots_[slot] != no_symbol)
+			slot = (slot + 1) & mask;
+		slots_[slot] = id;
+	}
+}
+
+
+}
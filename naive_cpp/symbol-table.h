@@ -0,0 +1,87 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_SYMBOL_TABLE_H
+#define INCLUDED_KFS_NAIVE_CPP_SYMBOL_TABLE_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Interning of identifiers.
+//
+// Names get compared a lot: every definition, member and reference is checked
+// against the names already seen. Rather than compare text each time, each
+// distinct name is interned once into a dense 32-bit SymbolId, after which
+// resolving and de-duplicating names are integer operations, and tables of things
+// by name can simply be indexed by id.
+//
+// The table is open-addressed and stores each name's hash, so lookups only compare
+// text on a full hash match. Unlike tokens, the names aren't views of the source:
+// each is copied into the table's arena as it is interned, so the table stays valid
+// however the text it came from is edited, moved or freed.
+
+
+#include "arena.h"
+#include "common.h"
+
+#include <cstdint>
+#include <vector>
+
+
+namespace kfs
+{
+
+
+//! Dense identifier of an interned name; ids are allocated from 0 upwards.
+using SymbolId = uint32_t;
+
+//! SymbolId that names nothing.
+inline constexpr SymbolId no_symbol = UINT32_MAX;
+
+
+struct SymbolTable
+{
+public:
+	SymbolTable() = default;
+
+	//! Returns the id of 'name', adding it to the table if it is new.
+	SymbolId intern(string_view name);
+
+	//! Returns the id of 'name' if it has been interned, otherwise no_symbol.
+	[[nodiscard]]
+	SymbolId find(string_view name) const noexcept;
+
+	//! The text and hash of an interned name; unchecked.
+	[[nodiscard]]
+	string_view name(SymbolId id) const noexcept { return entries_[id].name_; }
+	[[nodiscard]]
+	uint64_t hash(SymbolId id) const noexcept { return entries_[id].hash_; }
+
+	//! Number of names interned; also the next id to be allocated.
+	[[nodiscard]]
+	size_t size() const noexcept { return entries_.size(); }
+
+	//! The hash the table uses for names (64-bit FNV-1a).
+	[[nodiscard]]
+	static uint64_t hash_name(string_view name) noexcept;
+
+protected:
+	struct Entry
+	{
+		string_view	name_;		// A copy in names_.
+		uint64_t	hash_;
+	};
+
+	Arena					names_		{ };	// The text of every name.
+	std::vector<Entry>		entries_	{ };	// Indexed by SymbolId.
+	std::vector<SymbolId>	slots_		{ };	// Power-of-two hash table, no_symbol when free.
+
+	// Returns the slot holding 'name', or the free slot where it belongs.
+	[[nodiscard]]
+	size_t probe(string_view name, uint64_t hash) const noexcept;
+
+	// Doubles the hash table and reinserts every entry.
+	void grow();
+};
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_SYMBOL_TABLE_H
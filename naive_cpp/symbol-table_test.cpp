@@ -0,0 +1,71 @@
+// Unit tests for the symbol table.
+
+#include "symbol-table.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace kfs;
+
+
+TEST(SymbolTableTest, Empty)
+{
+	SymbolTable table;
+	EXPECT_EQ(0, table.size());
+	EXPECT_EQ(no_symbol, table.find("x"));
+}
+
+
+TEST(SymbolTableTest, Intern)
+{
+	SymbolTable table;
+	EXPECT_EQ(0, table.intern("alpha"));
+	EXPECT_EQ(1, table.intern("beta"));
+	EXPECT_EQ(0, table.intern("alpha"));
+	EXPECT_EQ(2, table.intern(""));
+	EXPECT_EQ(3, table.size());
+
+	EXPECT_EQ(1, table.find("beta"));
+	EXPECT_EQ(no_symbol, table.find("gamma"));
+	EXPECT_EQ("alpha", table.name(0));
+	EXPECT_EQ(SymbolTable::hash_name("beta"), table.hash(1));
+	EXPECT_NE(table.hash(0), table.hash(1));
+}
+
+
+// Names are compared by text, not by where the text is, and the table keeps its own
+// copy of the text.
+TEST(SymbolTableTest, InternsByValue)
+{
+	std::string first = "name name";
+	SymbolTable table;
+	const SymbolId id = table.intern(string_view(first).substr(0, 4));
+	EXPECT_EQ(id, table.intern(string_view(first).substr(5, 4)));
+	EXPECT_NE(first.data(), table.name(id).data());
+
+	first.assign(first.size(), '#');
+	EXPECT_EQ("name", table.name(id));
+	EXPECT_EQ(id, table.find("name"));
+}
+
+
+// Ids stay dense and stable as the table grows.
+TEST(SymbolTableTest, Growth)
+{
+	std::vector<std::string> names;
+	for (size_t i = 0; i < 10000; ++i)
+		names.push_back("symbol_" + std::to_string(i));
+
+	SymbolTable table;
+	for (size_t i = 0; i < names.size(); ++i)
+		ASSERT_EQ(i, table.intern(names[i]));
+	EXPECT_EQ(names.size(), table.size());
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		ASSERT_EQ(i, table.find(names[i]));
+		ASSERT_EQ(names[i], table.name(SymbolId(i)));
+	}
+	EXPECT_EQ(no_symbol, table.find("symbol_10000"));
+}
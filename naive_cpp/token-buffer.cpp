@@ -0,0 +1,149 @@
+// Struct-of-arrays token storage.
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "token-buffer.h"
+
+#include <algorithm>
+
+
+namespace kfs
+{
+
+
+void TokenBuffer::reserve(size_t count)
+{
+	types_.reserve(count);
+	offsets_.reserve(count);
+	lengths_.reserve(count);
+}
+
+
+void TokenBuffer::clear() noexcept
+{
+	types_.clear();
+	offsets_.clear();
+	lengths_.clear();
+	number_tokens_.clear();
+	numbers_.clear();
+}
+
+
+// Determine the token's position within our source by the same pointer comparison
+// as Scanner::get_token_offset.
+bool TokenBuffer::push_back(const Token& token)
+{
+	const char *outer_begin =       source_.data(), *outer_end =       source_.data() +       source_.length();
+	const char *inner_begin = token.source_.data(), *inner_end = token.source_.data() + token.source_.length();
+	if (inner_begin < outer_begin || inner_end > outer_end)
+		return false;
+
+	return push_back(token.type_, size_t(inner_begin - outer_begin), token.source_.length(), token.flags_);
+}
+
+
+bool TokenBuffer::push_back(Token::Type type, size_t offset, size_t length, uint8_t flags)
+{
+	if (offset > max_offset || length > max_length)
+		return false;
+
+	types_.push_back(type);
+	offsets_.push_back(static_cast<uint32_t>(offset));
+	lengths_.push_back(static_cast<uint32_t>(length) | (uint32_t(flags) << 24));
+	return true;
+}
+
+
+// Since offsets are relative to the source, buffers over the same source can simply
+// be concatenated.
+bool TokenBuffer::append(const TokenBuffer& other)
+{
+	if (other.source_.data() != source_.data() || other.source_.size() != source_.size())
+		return false;
+
+	const auto base = static_cast<uint32_t>(types_.size());
+	types_.insert(types_.end(), other.types_.begin(), other.types_.end());
+	offsets_.insert(offsets_.end(), other.offsets_.begin(), other.offsets_.end());
+	lengths_.insert(lengths_.end(), other.lengths_.begin(), other.lengths_.end());
+	for (const uint32_t index : other.number_tokens_)
+		number_tokens_.push_back(base + index);
+	numbers_.insert(numbers_.end(), other.numbers_.begin(), other.numbers_.end());
+	return true;
+}
+
+
+// Each array has its range replaced, and then the offsets after it are moved; the
+// decoded numbers are indexed by token, so their indexes move with the tokens.
+bool TokenBuffer::splice(size_t first, size_t count, const TokenBuffer& replacement, ptrdiff_t shift)
+{
+	if (replacement.source_.data() != source_.data() || replacement.source_.size() != source_.size())
+		return false;
+	if (first > size() || count > size() - first)
+		return false;
+	const size_t last = first + count;
+	if (last < size())
+	{
+		const auto moved = ptrdiff_t(offsets_.back()) + shift;
+		if (ptrdiff_t(offsets_[last]) + shift < 0 || moved > ptrdiff_t(max_offset))
+			return false;
+	}
+
+	auto replace = [first, last](auto& into, const auto& from) {
+		const auto at = into.begin() + ptrdiff_t(first);
+		const size_t common = std::min(last - first, from.size());
+		std::copy_n(from.begin(), common, at);
+		if (from.size() > common)
+			into.insert(at + ptrdiff_t(common), from.begin() + ptrdiff_t(common), from.end());
+		else
+			into.erase(at + ptrdiff_t(common), into.begin() + ptrdiff_t(last));
+	};
+	replace(types_, replacement.types_);
+	replace(offsets_, replacement.offsets_);
+	replace(lengths_, replacement.lengths_);
+
+	const size_t moved_from = first + replacement.size();
+	for (size_t i = moved_from; shift != 0 && i < offsets_.size(); ++i)
+		offsets_[i] = static_cast<uint32_t>(ptrdiff_t(offsets_[i]) + shift);
+
+	// Numbers before the range stay, those in it are replaced, and those after it move.
+	const auto begin = std::lower_bound(number_tokens_.begin(), number_tokens_.end(), first);
+	const auto end = std::lower_bound(begin, number_tokens_.end(), last);
+	const auto number_first = size_t(begin - number_tokens_.begin());
+	const auto number_last = size_t(end - number_tokens_.begin());
+	const auto index_shift = ptrdiff_t(replacement.size()) - ptrdiff_t(count);
+	for (size_t i = number_last; index_shift != 0 && i < number_tokens_.size(); ++i)
+		number_tokens_[i] = static_cast<uint32_t>(ptrdiff_t(number_tokens_[i]) + index_shift);
+
+	std::vector<uint32_t> indexes(replacement.number_tokens_);
+	for (uint32_t& index : indexes)
+		index += static_cast<uint32_t>(first);
+	number_tokens_.erase(number_tokens_.begin() + ptrdiff_t(number_first), number_tokens_.begin() + ptrdiff_t(number_last));
+	number_tokens_.insert(number_tokens_.begin() + ptrdiff_t(number_first), indexes.begin(), indexes.end());
+	numbers_.erase(numbers_.begin() + ptrdiff_t(number_first), numbers_.begin() + ptrdiff_t(number_last));
+	numbers_.insert(numbers_.begin() + ptrdiff_t(number_first), replacement.numbers_.begin(), replacement.numbers_.end());
+	return true;
+}
+
+
+bool TokenBuffer::set_number(size_t index, NumericValue value)
+{
+	if (index >= size() || (!number_tokens_.empty() && index <= number_tokens_.back()))
+		return false;
+	number_tokens_.push_back(static_cast<uint32_t>(index));
+	numbers_.push_back(value);
+	return true;
+}
+
+
+// The indexes are recorded in order, so they can be binary searched.
+std::optional<NumericValue> TokenBuffer::number(size_t index) const noexcept
+{
+	const auto it = std::lower_bound(number_tokens_.begin(), number_tokens_.end(), index);
+	if (it == number_tokens_.end() || *it != index)
+		return std::nullopt;
+	return numbers_[size_t(it - number_tokens_.begin())];
+}
+
+
+}
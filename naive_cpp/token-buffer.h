@@ -0,0 +1,167 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_TOKEN_BUFFER_H
+#define INCLUDED_KFS_NAIVE_CPP_TOKEN_BUFFER_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Compact storage for the tokens scanned from a document.
+//
+// A Token is a type plus a string_view, 24 bytes; for a document full of short
+// identifiers and punctuation that's several times the size of the text itself.
+// Since every token of a document refers to the same source text, all we really
+// need is its offset and length within that text.
+//
+// TokenBuffer stores tokens as struct-of-arrays: the types are contiguous so that
+// passes which only care about the kind of token can stream through 1 byte per
+// token, with the offsets and lengths in separate arrays. Tokens are only turned
+// back into string_views when someone asks for one. Lengths only need 24 bits, so
+// the token's flags ride along in the top byte of its length. When the scanner
+// decodes numbers, their values go in a side array indexed by token, so that only
+// the numeric tokens pay for them.
+
+
+#include "common.h"
+#include "numeric.h"
+#include "token.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace kfs
+{
+
+
+//! PackedToken is the 8-byte form of a token relative to its source document: a
+//! 32-bit offset, 24-bit length and 8-bit type. It doesn't carry the flags.
+struct PackedToken
+{
+	uint32_t	offset_			{0};
+	uint32_t	length_	: 24	{0};
+	uint32_t	type_	: 8		{0};
+
+	[[nodiscard]]
+	Token::Type type() const noexcept { return static_cast<Token::Type>(type_); }
+
+	bool operator == (const PackedToken& rhs) const noexcept = default;
+};
+static_assert(sizeof(PackedToken) == 8);
+
+
+//! TokenBuffer is a struct-of-arrays sequence of tokens from a single source.
+//
+// The source must outlive the buffer, same as for the Scanner.
+//
+struct TokenBuffer
+{
+public:
+	//! Largest offset and length that the packed representation can hold.
+	static constexpr size_t max_offset = UINT32_MAX;
+	static constexpr size_t max_length = (size_t(1) << 24) - 1;
+
+	TokenBuffer() = default;
+	explicit TokenBuffer(const string_view source) : source_(source) {}
+
+	//! Returns true if every token of 'source' can be held, i.e. it's no bigger than
+	//! the offsets can address.
+	[[nodiscard]]
+	static bool can_hold(string_view source) noexcept { return source.size() <= max_offset; }
+
+	//! The document the tokens refer to.
+	[[nodiscard]]
+	string_view source() const noexcept { return source_; }
+
+	[[nodiscard]]
+	size_t size() const noexcept { return types_.size(); }
+	[[nodiscard]]
+	bool empty() const noexcept { return types_.empty(); }
+
+	void reserve(size_t count);
+	void clear() noexcept;
+
+	//! Appends a token from the source document. Returns false, and does not append
+	//! anything, if the token lies outside the source or can't be represented.
+	bool push_back(const Token& token);
+
+	//! Appends a token given its position within the source. Returns false, and
+	//! does not append anything, if the position can't be represented.
+	bool push_back(Token::Type type, size_t offset, size_t length, uint8_t flags = Token::NoFlags);
+
+	//! Appends all of the tokens from another buffer over the same source. Returns
+	//! false, and does not append anything, if the sources differ.
+	bool append(const TokenBuffer& other);
+
+	//! Points the buffer at a new copy of its document, such as after an edit; the
+	//! offsets are not changed, so tokens must be spliced to match (see retokenize.h).
+	void rebase(string_view source) noexcept { source_ = source; }
+
+	//! Replaces the 'count' tokens starting at 'first' with the tokens of 'replacement',
+	//! which must be over the same source, and moves the tokens after them by 'shift'
+	//! bytes. Returns false, and changes nothing, if the sources differ, the range is
+	//! out of bounds or a moved token's offset can't be represented.
+	bool splice(size_t first, size_t count, const TokenBuffer& replacement, ptrdiff_t shift);
+
+	//! Records the decoded value of the numeric token at 'index'. Values must be
+	//! recorded in token order; returns false, and records nothing, if they aren't.
+	bool set_number(size_t index, NumericValue value);
+
+	//! Returns the decoded value of the token at 'index', or nullopt if it has none.
+	[[nodiscard]]
+	std::optional<NumericValue> number(size_t index) const noexcept;
+
+	//! Number of tokens with decoded values.
+	[[nodiscard]]
+	size_t number_count() const noexcept { return numbers_.size(); }
+
+	//! Accessors for the individual fields; unchecked.
+	[[nodiscard]]
+	Token::Type type(size_t index) const noexcept { return types_[index]; }
+	[[nodiscard]]
+	uint32_t offset(size_t index) const noexcept { return offsets_[index]; }
+	[[nodiscard]]
+	uint32_t length(size_t index) const noexcept { return lengths_[index] & max_length; }
+	[[nodiscard]]
+	uint8_t flags(size_t index) const noexcept { return static_cast<uint8_t>(lengths_[index] >> 24); }
+
+	//! Returns the token at 'index' in its packed form; unchecked.
+	[[nodiscard]]
+	PackedToken packed(size_t index) const noexcept
+	{
+		return PackedToken{ offsets_[index], length(index), static_cast<uint8_t>(types_[index]) };
+	}
+
+	//! Materializes the text of the token at 'index'; unchecked.
+	[[nodiscard]]
+	string_view text(size_t index) const noexcept { return source_.substr(offsets_[index], length(index)); }
+
+	//! Materializes the token at 'index' as a full Token; unchecked.
+	[[nodiscard]]
+	Token token(size_t index) const noexcept { return Token{ types_[index], text(index), flags(index) }; }
+
+	//! The contiguous array of token types, for passes that only need the types.
+	[[nodiscard]]
+	std::span<const Token::Type> types() const noexcept { return types_; }
+
+	//! Two buffers are equal if they hold the same tokens at the same offsets; the
+	//! decoded values follow from the tokens, so aren't compared.
+	bool operator == (const TokenBuffer& rhs) const noexcept
+	{
+		return types_ == rhs.types_ && offsets_ == rhs.offsets_ && lengths_ == rhs.lengths_;
+	}
+
+protected:
+	string_view				source_		{ };
+	std::vector<Token::Type>	types_		{ };
+	std::vector<uint32_t>		offsets_	{ };
+	std::vector<uint32_t>		lengths_	{ };	// Length, with the flags in the top byte.
+	std::vector<uint32_t>		number_tokens_	{ };	// Ascending indexes of decoded tokens,
+	std::vector<NumericValue>	numbers_	{ };	// and their values.
+};
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_TOKEN_BUFFER_H
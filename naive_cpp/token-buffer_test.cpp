@@ -0,0 +1,125 @@
+// Unit tests for the packed token representation and TokenBuffer.
+
+#include "scanner.h"
+#include "token-buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace kfs;
+
+
+TEST(TokenBufferTest, PackedToken)
+{
+	PackedToken packed{ 0x12345678, TokenBuffer::max_length, uint8_t(Token::Type::Scope) };
+	EXPECT_EQ(0x12345678, packed.offset_);
+	EXPECT_EQ(0xFFFFFF, packed.length_);
+	EXPECT_EQ(Token::Type::Scope, packed.type());
+}
+
+
+TEST(TokenBufferTest, PushBackAndMaterialize)
+{
+	const string_view source = "enum X";
+	TokenBuffer buffer(source);
+	EXPECT_TRUE(buffer.empty());
+
+	EXPECT_TRUE(buffer.push_back(Token{Token::Type::Word, source.substr(0, 4)}));
+	EXPECT_TRUE(buffer.push_back(Token::Type::Word, 5, 1));
+	ASSERT_EQ(2, buffer.size());
+
+	EXPECT_EQ(Token::Type::Word, buffer.type(0));
+	EXPECT_EQ(0, buffer.offset(0));
+	EXPECT_EQ(4, buffer.length(0));
+	EXPECT_EQ("enum", buffer.text(0));
+	EXPECT_EQ((Token{Token::Type::Word, source.substr(5, 1)}), buffer.token(1));
+	// Materialized tokens refer to the original source text.
+	EXPECT_EQ(source.data() + 5, buffer.token(1).source_.data());
+
+	EXPECT_EQ(2, buffer.types().size());
+	EXPECT_EQ((PackedToken{5, 1, uint8_t(Token::Type::Word)}), buffer.packed(1));
+
+	buffer.clear();
+	EXPECT_TRUE(buffer.empty());
+}
+
+
+TEST(TokenBufferTest, PushBackRejects)
+{
+	const string_view outer = "[inner]";
+	TokenBuffer buffer(outer.substr(1, 5));
+
+	// Tokens that aren't (entirely) within the source.
+	EXPECT_FALSE(buffer.push_back(Token{Token::Type::Word, outer}));
+	EXPECT_FALSE(buffer.push_back(Token{Token::Type::Word, outer.substr(0, 2)}));
+	EXPECT_FALSE(buffer.push_back(Token{Token::Type::Word, outer.substr(5, 2)}));
+	EXPECT_FALSE(buffer.push_back(Token{Token::Type::Word, "inner"}));
+	// Positions that can't be packed.
+	EXPECT_FALSE(buffer.push_back(Token::Type::Word, 0, TokenBuffer::max_length + 1));
+	EXPECT_FALSE(buffer.push_back(Token::Type::Word, TokenBuffer::max_offset + 1, 1));
+	EXPECT_TRUE(buffer.empty());
+}
+
+
+TEST(TokenBufferTest, ScannerFillsBuffer)
+{
+	const string_view source = "type T : U { int i = 1, string s[] } ~ enum E { A }";
+
+	std::vector<Token> expected;
+	{
+		Scanner scanner(source);
+		for (auto result = scanner.next(); !result.is_none(); result = scanner.next())
+			if (result.is_token())
+				expected.push_back(result.token());
+	}
+
+	Scanner scanner(source);
+	TokenBuffer buffer(scanner.source());
+	auto batch = scanner.next_batch(buffer, 5);
+	EXPECT_EQ(5, batch.count_);
+	EXPECT_FALSE(batch.is_error());
+
+	batch = scanner.next_batch(buffer, 1000);
+	ASSERT_TRUE(batch.is_error());
+	EXPECT_EQ("~", batch.error_.token().source_);
+
+	batch = scanner.next_batch(buffer, 1000);
+	EXPECT_FALSE(batch.is_error());
+	EXPECT_EQ(5, batch.count_);
+
+	ASSERT_EQ(expected.size(), buffer.size());
+	for (size_t i = 0; i < buffer.size(); ++i)
+	{
+		SCOPED_TRACE(i);
+		EXPECT_EQ(expected[i], buffer.token(i));
+	}
+}
+
+
+TEST(TokenBufferTest, ScannerRejectsHugeSourceOnce)
+{
+	if constexpr (sizeof(size_t) > sizeof(uint32_t))
+	{
+		// The check comes before anything is scanned, so the view needn't be backed by
+		// real memory.
+		const char text[] = "a b c";
+		const string_view huge(text, TokenBuffer::max_offset + 1);
+		EXPECT_FALSE(TokenBuffer::can_hold(huge));
+		EXPECT_TRUE(TokenBuffer::can_hold(huge.substr(0, TokenBuffer::max_offset)));
+
+		Scanner scanner(huge);
+		TokenBuffer buffer(huge);
+		auto batch = scanner.next_batch(buffer, 1000);
+		ASSERT_TRUE(batch.is_error());
+		EXPECT_EQ(ErrorCode::DocumentTooLarge, batch.error_.code());
+		EXPECT_EQ(0, batch.count_);
+
+		// And then it's at the end.
+		batch = scanner.next_batch(buffer, 1000);
+		EXPECT_FALSE(batch.is_error());
+		EXPECT_EQ(0, batch.count_);
+		EXPECT_TRUE(buffer.empty());
+		EXPECT_TRUE(scanner.next().is_none());
+	}
+}
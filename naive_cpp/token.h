@@ -5,6 +5,9 @@
 
 
 #include "common.h"
+#include "keyword.h"
+
+#include <cstdint>
 
 
 namespace kfs
@@ -20,7 +23,7 @@ namespace kfs
 struct Token
 {
 	//! Token::Type enumerates the distinct base-types of token.
-	enum class Type
+	enum class Type : uint8_t
 	{
 		Invalid,
 		Word,
@@ -44,14 +47,45 @@ struct Token
 		CloseComment,
 	};
 
+	//! Token::Flags are things the scanner noticed about the text of a token, so that
+	//! consumers don't have to look for them again.
+	enum Flags : uint8_t
+	{
+		NoFlags		= 0,
+		Escaped		= 1 << 0,	// String literal containing \" or \\ escapes.
+		KeywordMask	= 0xF0,		// For words, the Keyword they spell.
+	};
+	static constexpr unsigned keyword_shift = 4;
+
 	Type     		type_		{ Type::Invalid };
+	uint8_t			flags_		{ NoFlags };
 	string_view		source_		{ "" };
 
+	constexpr Token() noexcept = default;
+	constexpr Token(Type type, string_view source, uint8_t flags = NoFlags) noexcept
+		: type_(type), flags_(flags), source_(source)
+	{}
+
+	//! Two tokens are the same if they have the same type and text; the flags are
+	//! derived from the text.
 	bool operator == (const Token& rhs) const noexcept
 	{
 		return type_ == rhs.type_ && source_ == rhs.source_;
 	}
 
+	//! Returns true if the token is a string literal whose value differs from its
+	//! text because of escapes.
+	[[nodiscard]]
+	constexpr bool is_escaped() const noexcept { return (flags_ & Escaped) != 0; }
+
+	//! Returns the keyword a word token spells, as classified by the scanner.
+	[[nodiscard]]
+	constexpr Keyword keyword() const noexcept { return static_cast<Keyword>((flags_ & KeywordMask) >> keyword_shift); }
+
+	//! Returns the flags that record 'keyword'.
+	[[nodiscard]]
+	static constexpr uint8_t keyword_flags(Keyword keyword) noexcept { return static_cast<uint8_t>(uint8_t(keyword) << keyword_shift); }
+
     // Static helper: maps a type to a human displayable name.
     //#[derive(Debug)] please
     static string_view type_to_str(Token::Type type);
@@ -3,8 +3,13 @@
 #define INCLUDED_KFS_NAIVE_CPP_TRESULT_H
 
 
+#include "error.h"
 #include "token.h"
-#include "result.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <type_traits>
 
 
 namespace kfs
@@ -12,31 +17,89 @@ namespace kfs
 
 
 //! TResult is used to encapsulate Token-or-error related returns, and is loosely
-//! modelled after Rust's Result type. It is a specific implementation of kfs::Result
-//! for Token.
+//! modelled after Rust's Result type. It has the same interface as kfs::Result for
+//! Token, but since it's returned for every token the scanner produces, it packs the
+//! token and error code into 16 bytes so that it is returned in registers.
 //!
-//! It can return "nothing" (None), a Token, an error string, or an error accompanied
+//! It can return "nothing" (None), a Token, an error code, or an error accompanied
 //! by the Token that produced it.
 //!
 //!	 	.is_none()	 => neither error nor token,
 //!		.is_error()  => error is present,
 //!		.is_token()  => no error, and token is present,
 //!		.has_token() => token is present (may also be an error)
+//!
+//! Token lengths are stored in 32 bits: a token of 4GiB or more comes back as a
+//! TokenTooLong error, with the token cut to max_length, rather than silently
+//! truncated.
 //
-struct TResult : public Result<Token>
+struct TResult
 {
-	using Result::Result;
+public:
+	static constexpr size_t max_length = UINT32_MAX;
+
+	constexpr TResult() = default;
+	static constexpr TResult None() noexcept { return TResult{}; }
+
+	constexpr explicit TResult(const Token& token) noexcept
+		: TResult(token, ErrorCode::None)
+	{}
+
+	constexpr TResult(const Token& token, ErrorCode code) noexcept
+		: data_(token.source_.data())
+		, length_(static_cast<uint32_t>(std::min(token.source_.length(), max_length)))
+		, type_(token.type_)
+		, flags_(token.flags_)
+		, code_(token.source_.length() > max_length ? ErrorCode::TokenTooLong : code)
+		, has_token_(true)
+	{}
+
+	[[nodiscard]]
+	constexpr bool operator == (const TResult& rhs) const noexcept
+	{
+		return code_ == rhs.code_ && has_token_ == rhs.has_token_ && (!has_token_ || token() == rhs.token());
+	}
+
+	//! is_none will return true if there is neither a token nor an error.
+	[[nodiscard]]
+	constexpr bool is_none() const noexcept { return !has_token_ && !is_error(); }
+	//! is_error will return true if an error is present.
+	[[nodiscard]]
+	constexpr bool is_error() const noexcept { return code_ != ErrorCode::None; }
 	//! is_token will return true only if a token is present without an error.
-	bool is_token() const noexcept { return is_value(); }
+	[[nodiscard]]
+	constexpr bool is_token() const noexcept { return has_token_ && !is_error(); }
 	//! has_token will return true if a token is present, but it may be an error-related token.
-	bool has_token() const noexcept { return has_value(); }
+	[[nodiscard]]
+	constexpr bool has_token() const noexcept { return has_token_; }
 
-	//! token() will attempt to return the value of the token, you must check is_token() or has_token() first.
-	const Token& token() const noexcept { return value(); }
+	//! token() will return the token, you must check is_token() or has_token() first.
+	[[nodiscard]]
+	constexpr Token token() const noexcept { return Token{ type_, string_view(data_, length_), flags_ }; }
 
+	//! code() returns the error code, which is ErrorCode::None if there is no error.
+	[[nodiscard]]
+	constexpr ErrorCode code() const noexcept { return code_; }
+	//! error() returns the static description of the error, you must check is_error() first.
+	[[nodiscard]]
+	string_view error() const noexcept { return error_message(code_); }
+	//! message() builds a full description of the error, including the token text.
+	[[nodiscard]]
+	std::string message() const { return describe_error(code_, token()); }
+
+private:
+	const char*	data_		{ "" };
+	uint32_t	length_		{ 0 };
+	Token::Type	type_		{ Token::Type::Invalid };
+	uint8_t		flags_		{ Token::NoFlags };
+	ErrorCode	code_		{ ErrorCode::None };
+	bool		has_token_	{ false };
 };
 
+static_assert(sizeof(TResult) == 16);
+static_assert(std::is_trivially_copyable_v<TResult>);
+
 
 }
 
-#endif  // INCLUDED_KFS_NAIVE_CPP_TRESULT_H
\ No newline at end of file
+#endif  // INCLUDED_KFS_NAIVE_CPP_TRESULT_H
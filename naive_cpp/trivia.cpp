@@ -0,0 +1,73 @@
+// Retention of comments ("trivia").
+//
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+
+#include "trivia.h"
+
+
+namespace kfs
+{
+
+
+void TriviaTable::clear() noexcept
+{
+	spans_.clear();
+	starts_.clear();
+}
+
+
+bool TriviaTable::add(size_t offset, size_t length)
+{
+	if (offset > UINT32_MAX || length > UINT32_MAX)
+		return false;
+	spans_.push_back(TriviaSpan{ static_cast<uint32_t>(offset), static_cast<uint32_t>(length) });
+	return true;
+}
+
+
+// Both comments and tokens are in source order, so each token's comments start at or
+// after the previous token's. Token i's comments are [starts_[i], starts_[i + 1]),
+// with an entry for the comments after the last token and one past that.
+void TriviaTable::attach(const TokenBuffer& tokens)
+{
+	starts_.resize(tokens.size() + 2);
+	size_t span = 0;
+	for (size_t token = 0; token < tokens.size(); ++token)
+	{
+		starts_[token] = static_cast<uint32_t>(span);
+		while (span < spans_.size() && spans_[span].offset_ < tokens.offset(token))
+			++span;
+	}
+	starts_[tokens.size()] = static_cast<uint32_t>(span);
+	starts_[tokens.size() + 1] = static_cast<uint32_t>(spans_.size());
+}
+
+
+std::span<const TriviaSpan> TriviaTable::leading(size_t index) const noexcept
+{
+	if (index + 1 >= starts_.size())
+		return {};
+	return std::span(spans_).subspan(starts_[index], starts_[index + 1] - starts_[index]);
+}
+
+
+string_view TriviaTable::doc_comment(string_view source, size_t index) const noexcept
+{
+	const auto comments = leading(index);
+	if (comments.empty())
+		return {};
+
+	// Only whitespace can come between the last comment and the token; before the
+	// comment, there must be nothing else on its line.
+	const TriviaSpan& comment = comments.back();
+	const string_view before = source.substr(0, comment.offset_);
+	const size_t newline = before.find_last_of('\n');
+	const string_view indent = newline == string_view::npos ? before : before.substr(newline + 1);
+	if (indent.find_first_not_of(" \t\r") != string_view::npos)
+		return {};
+	return source.substr(comment.offset_, comment.length_);
+}
+
+
+}
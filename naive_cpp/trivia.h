@@ -0,0 +1,85 @@
+#pragma once
+#ifndef INCLUDED_KFS_NAIVE_CPP_TRIVIA_H
+#define INCLUDED_KFS_NAIVE_CPP_TRIVIA_H
+// Copyright (C) Oliver 'kfsone' Smith, 2024 -- under MIT license terms.
+
+// Retention of comments ("trivia").
+//
+// The scanner normally throws comments away. Tooling that wants them - say, for
+// the doc comment above an enum - can give the scanner a TriviaTable, and it will
+// record the span of each comment it skips. Nothing is added to Token, and the
+// only cost when trivia isn't wanted is a null check on the comment path.
+//
+// Comments are recorded by position, since the scanner doesn't know which token
+// will follow; attach() then keys each comment to the index of the next token in
+// a TokenBuffer with a single merge of the two (sorted) sequences, building an
+// array of where each token's comments start so that finding them is O(1).
+
+
+#include "common.h"
+#include "token-buffer.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+namespace kfs
+{
+
+
+//! The position of a comment within the source.
+struct TriviaSpan
+{
+	uint32_t	offset_	{0};
+	uint32_t	length_	{0};
+
+	bool operator == (const TriviaSpan& rhs) const noexcept = default;
+};
+
+
+struct TriviaTable
+{
+public:
+	TriviaTable() = default;
+
+	[[nodiscard]]
+	size_t size() const noexcept { return spans_.size(); }
+	[[nodiscard]]
+	bool empty() const noexcept { return spans_.empty(); }
+	void clear() noexcept;
+
+	//! Records a comment; comments must be added in source order. Returns false,
+	//! and records nothing, if the span can't be represented.
+	bool add(size_t offset, size_t length);
+
+	//! Keys every comment to the index of the first token of 'tokens' that follows
+	//! it; comments after the last token are keyed to tokens.size().
+	void attach(const TokenBuffer& tokens);
+
+	//! The comments between token 'index' and the token before it, in order.
+	//! Only meaningful after attach(); empty before it.
+	[[nodiscard]]
+	std::span<const TriviaSpan> leading(size_t index) const noexcept;
+
+	//! The text of the comment immediately before token 'index', or an empty view
+	//! if there isn't one. The comment must begin its own line, so that one trailing
+	//! the previous line's code isn't taken for the next definition's doc comment.
+	//! 'source' is the document the comments were scanned from.
+	[[nodiscard]]
+	string_view doc_comment(string_view source, size_t index) const noexcept;
+
+	//! All of the comments, in order.
+	[[nodiscard]]
+	std::span<const TriviaSpan> spans() const noexcept { return spans_; }
+
+protected:
+	std::vector<TriviaSpan>	spans_	{ };
+	std::vector<uint32_t>	starts_	{ };	// Index of the first span of each token, and one past the end.
+};
+
+
+}
+
+
+#endif  // INCLUDED_KFS_NAIVE_CPP_TRIVIA_H
@@ -0,0 +1,122 @@
+// Unit tests for comment retention.
+
+#include "scanner.h"
+#include "scanner-table.h"
+#include "trivia.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace kfs;
+
+
+namespace
+{
+
+template<typename ScannerType>
+std::pair<TokenBuffer, TriviaTable> scan_with_trivia(string_view source)
+{
+	std::pair<TokenBuffer, TriviaTable> result { TokenBuffer(source), TriviaTable() };
+	ScannerType scanner(source);
+	scanner.retain_trivia(&result.second);
+	EXPECT_FALSE(scanner.next_batch(result.first, 1024).is_error());
+	result.second.attach(result.first);
+	return result;
+}
+
+std::vector<string_view> texts(string_view source, std::span<const TriviaSpan> spans)
+{
+	std::vector<string_view> result;
+	for (const auto& span : spans)
+		result.push_back(source.substr(span.offset_, span.length_));
+	return result;
+}
+
+}
+
+
+TEST(TriviaTest, NotRetainedByDefault)
+{
+	const string_view source = "// comment\nenum";
+	Scanner scanner(source);
+	TriviaTable trivia;
+	EXPECT_TRUE(scanner.next().is_token());
+	EXPECT_TRUE(trivia.empty());
+}
+
+
+TEST(TriviaTest, KeyedToFollowingToken)
+{
+	const string_view source =
+		"// first\n"
+		"// doc for E\n"
+		"enum E { A, /* inner */ B }\n"
+		"/* a */ /* b */ type /*c*/ T\n"
+		"// trailing";
+	const auto [tokens, trivia] = scan_with_trivia<Scanner>(source);
+	ASSERT_EQ(9, tokens.size());
+	ASSERT_EQ(7, trivia.size());
+
+	using Texts = std::vector<string_view>;
+	EXPECT_EQ((Texts{ "// first", "// doc for E" }), texts(source, trivia.leading(0)));
+	EXPECT_EQ("// doc for E", trivia.doc_comment(source, 0));
+	EXPECT_TRUE(trivia.leading(1).empty());
+	EXPECT_EQ("", trivia.doc_comment(source, 1));
+	EXPECT_EQ((Texts{ "/* inner */" }), texts(source, trivia.leading(5)));
+	EXPECT_EQ((Texts{ "/* a */", "/* b */" }), texts(source, trivia.leading(7)));
+	EXPECT_EQ("", trivia.doc_comment(source, 7));
+	EXPECT_EQ((Texts{ "/*c*/" }), texts(source, trivia.leading(8)));
+	// Comments after the last token are keyed to the end.
+	EXPECT_EQ((Texts{ "// trailing" }), texts(source, trivia.leading(tokens.size())));
+}
+
+
+TEST(TriviaTest, LeadingBeforeAttach)
+{
+	TriviaTable trivia;
+	ASSERT_TRUE(trivia.add(0, 2));
+	EXPECT_TRUE(trivia.leading(0).empty());
+	EXPECT_EQ("", trivia.doc_comment("//", 0));
+}
+
+
+TEST(TriviaTest, DocCommentsBeginTheirOwnLine)
+{
+	const string_view source =
+		"/* top */ enum A { X } // trailing A\n"
+		"enum B { Y }\n"
+		"  \t// indented\n"
+		"\n"
+		"type C { }\n"
+		"enum D { Z } /* after D */\n"
+		"/* own line */ enum E { W }";
+	const auto [tokens, trivia] = scan_with_trivia<Scanner>(source);
+	const auto doc = [&] (string_view name) {
+		for (size_t i = 1; i < tokens.size(); ++i)
+			if (tokens.text(i) == name)
+				return trivia.doc_comment(source, i - 1);
+		ADD_FAILURE() << name;
+		return string_view{};
+	};
+	EXPECT_EQ("/* top */", doc("A"));
+	EXPECT_EQ("", doc("B"));
+	EXPECT_EQ("// indented", doc("C"));
+	EXPECT_EQ("/* own line */", doc("E"));
+	EXPECT_EQ((std::vector<string_view>{ "/* after D */", "/* own line */" }), texts(source, trivia.leading(tokens.size() - 5)));
+}
+
+
+// The table-driven scanner retains the same comments.
+TEST(TriviaTest, TableScannerAgrees)
+{
+	const string_view source = "/**/a//x\n/* /* nested */ */ b /*/ c */";
+	const auto [tokens, trivia] = scan_with_trivia<Scanner>(source);
+	const auto [table_tokens, table_trivia] = scan_with_trivia<TableScanner>(source);
+	EXPECT_EQ(tokens, table_tokens);
+	ASSERT_EQ(4, trivia.size());
+	ASSERT_EQ(trivia.size(), table_trivia.size());
+	for (size_t i = 0; i <= tokens.size(); ++i)
+		EXPECT_EQ(texts(source, trivia.leading(i)), texts(source, table_trivia.leading(i))) << i;
+}